@@ -0,0 +1,296 @@
+#include "corpus.h"
+
+#include <QByteArray>
+#include <QStringEncoder>
+
+#include <cstdio>
+#include <vector>
+
+using namespace mcla;
+
+// splitmix64：各平台结果相同，不依赖标准库分布的实现
+class Rng {
+public:
+    explicit Rng(quint64 seed) : state(seed) {}
+
+    quint64 next() {
+        quint64 z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    // [0, n)
+    quint32 below(quint32 n) { return quint32(((next() >> 32) * n) >> 32); }
+    bool chance(double p) { return double(next() >> 11) * (1.0 / 9007199254740992.0) < p; }
+    template <typename T, size_t N>
+    const T &pick(const T (&items)[N]) { return items[below(quint32(N))]; }
+
+private:
+    quint64 state;
+};
+
+static const char *const kNames[] = {
+    "Steve", "Alex", "Notch", "jeb_", "Dinnerbone", "xX_Sniper_Xx", "CreeperHunter", "redstone_wiz",
+    "Builder_42", "kitty2009", "小明", "苦力怕", "末影人Enderman", "MC_大佬", "Herobrine", "Technoblade",
+};
+
+static const char *const kChat[] = {
+    "hello everyone", "anyone want to trade diamonds?", "lag again...", "服务器好卡", "谁有附魔书",
+    "server version is 1.20.4", "try build 1.2.3.4.5", "my old ip was 999.1.1.1 lol", "meet at 100, 64, -200",
+    "gg", "brb", "这个红石电路怎么做", "port 25565 is blocked?", "v1.19.2 had that bug", "/tpa Steve",
+};
+
+static const char *const kWorlds[] = { "world", "world_nether", "world_the_end" };
+
+static const char *const kFrames[] = {
+    "net.minecraft.server.level.ServerLevel.tick(ServerLevel.java:412)",
+    "net.minecraft.server.MinecraftServer.tickChildren(MinecraftServer.java:1502)",
+    "net.minecraft.server.dedicated.DedicatedServer.tickChildren(DedicatedServer.java:436)",
+    "net.minecraft.server.MinecraftServer.runServer(MinecraftServer.java:1175)",
+    "io.netty.channel.AbstractChannelHandlerContext.invokeChannelRead(AbstractChannelHandlerContext.java:444)",
+    "net.md_5.bungee.connection.InitialHandler.handle(InitialHandler.java:381)",
+    "com.velocitypowered.proxy.connection.MinecraftConnection.channelRead(MinecraftConnection.java:150)",
+    "java.base/java.lang.Thread.run(Thread.java:833)",
+};
+
+static const char *const kExceptions[] = {
+    "java.lang.NullPointerException: Cannot invoke \"net.minecraft.world.entity.Entity.getId()\" because \"entity\" is null",
+    "java.io.IOException: Connection reset by peer",
+    "java.util.ConcurrentModificationException",
+    "io.netty.handler.timeout.ReadTimeoutException",
+};
+
+// 按行生成日志（UTF-8）；同一批玩家反复上线，地址与端口可以重复出现
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(const CorpusSpec &spec) : spec(spec), rng(spec.seed) {
+        for (int i = 0; i < 512; ++i) {
+            players.push_back({ QByteArray(rng.pick(kNames)) + (i >= 16 ? QByteArray::number(i) : QByteArray()),
+                                randomAddress() });
+        }
+    }
+
+    void appendLine(QByteArray &out) {
+        seconds += rng.below(3);
+        LogFlavor flavor = spec.flavor;
+        if (flavor == LogFlavor::Mixed) flavor = LogFlavor(rng.below(3));
+        const bool address = rng.chance(spec.ipDensity);
+        switch (flavor) {
+        case LogFlavor::Bungee: appendBungee(out, address); break;
+        case LogFlavor::Velocity: appendVelocity(out, address); break;
+        default: appendVanilla(out, address); break;
+        }
+    }
+
+private:
+    struct Player {
+        QByteArray name;
+        QByteArray ip;
+    };
+
+    const CorpusSpec &spec;
+    Rng rng;
+    std::vector<Player> players;
+    qint64 seconds = 8 * 3600;
+
+    QByteArray randomAddress() {
+        // 少量边界值：0.0.0.0、255.255.255.255、本地地址
+        switch (rng.below(40)) {
+        case 0: return "0.0.0.0";
+        case 1: return "255.255.255.255";
+        case 2: return "127.0.0.1";
+        case 3: return "192.168." + QByteArray::number(rng.below(256)) + "." + QByteArray::number(rng.below(256));
+        default: break;
+        }
+        return QByteArray::number(1 + rng.below(223)) + "." + QByteArray::number(rng.below(256)) + "."
+               + QByteArray::number(rng.below(256)) + "." + QByteArray::number(rng.below(256));
+    }
+
+    QByteArray port() { return QByteArray::number(rng.chance(0.1) ? 25565 : 1024 + rng.below(64512)); }
+
+    const Player &player() { return players[rng.below(quint32(players.size()))]; }
+
+    // 偶尔换成新地址，模拟新玩家
+    QByteArray endpoint(const Player &p) { return (rng.chance(0.05) ? randomAddress() : p.ip) + ":" + port(); }
+
+    QByteArray clock(bool brackets) {
+        char t[16];
+        std::snprintf(t, sizeof t, "%02d:%02d:%02d", int(seconds / 3600 % 24), int(seconds / 60 % 60), int(seconds % 60));
+        return brackets ? "[" + QByteArray(t) + "]" : QByteArray(t);
+    }
+
+    QByteArray uuid() {
+        char u[40];
+        const quint64 a = rng.next(), b = rng.next();
+        std::snprintf(u, sizeof u, "%08x-%04x-4%03x-a%03x-%012llx", unsigned(a >> 32), unsigned(a >> 16 & 0xFFFF),
+                      unsigned(a & 0xFFF), unsigned(b >> 52), static_cast<unsigned long long>(b & 0xFFFFFFFFFFFFull));
+        return u;
+    }
+
+    void appendStackTrace(QByteArray &out) {
+        out += rng.pick(kExceptions);
+        out += '\n';
+        const int frames = 3 + int(rng.below(12));
+        for (int i = 0; i < frames; ++i) {
+            out += "\tat ";
+            out += rng.pick(kFrames);
+            out += " ~[?:?]\n";
+        }
+    }
+
+    void appendVanilla(QByteArray &out, bool address) {
+        const Player &p = player();
+        out += clock(true);
+        if (address) {
+            switch (rng.below(3)) {
+            case 0:
+                out += " [Server thread/INFO]: " + p.name + "[/" + endpoint(p) + "] logged in with entity id "
+                       + QByteArray::number(rng.below(100000)) + " at ([" + rng.pick(kWorlds) + "]"
+                       + QByteArray::number(int(rng.below(2000)) - 1000) + ".5, 64.0, "
+                       + QByteArray::number(int(rng.below(2000)) - 1000) + ".5)\n";
+                return;
+            case 1:
+                out += " [Server thread/INFO]: com.mojang.authlib.GameProfile@" + QByteArray::number(rng.next() & 0xFFFFFF, 16)
+                       + "[id=<null>,name=" + p.name + ",properties={},legacy=false] (/" + endpoint(p)
+                       + ") lost connection: Disconnected\n";
+                return;
+            default:
+                out += " [Server thread/INFO]: Disconnecting /" + endpoint(p) + ": Took too long to log in\n";
+                return;
+            }
+        }
+        switch (rng.below(8)) {
+        case 0:
+            out += " [User Authenticator #" + QByteArray::number(1 + rng.below(9)) + "/INFO]: UUID of player " + p.name
+                   + " is " + uuid() + "\n";
+            return;
+        case 1: out += " [Server thread/INFO]: " + p.name + " joined the game\n"; return;
+        case 2: out += " [Server thread/INFO]: " + p.name + " lost connection: Disconnected\n"; return;
+        case 3:
+            out += " [Server thread/WARN]: Can't keep up! Is the server overloaded? Running "
+                   + QByteArray::number(2000 + rng.below(8000)) + "ms or " + QByteArray::number(40 + rng.below(160))
+                   + " ticks behind\n";
+            return;
+        case 4:
+            if (rng.chance(0.05)) {
+                out += " [Server thread/ERROR]: Encountered an unexpected exception\n";
+                appendStackTrace(out);
+                return;
+            }
+            [[fallthrough]];
+        default:
+            out += " [Async Chat Thread - #" + QByteArray::number(rng.below(20)) + "/INFO]: <" + p.name + "> "
+                   + rng.pick(kChat) + "\n";
+            return;
+        }
+    }
+
+    void appendBungee(QByteArray &out, bool address) {
+        const Player &p = player();
+        out += clock(false);
+        if (address) {
+            if (rng.chance(0.5))
+                out += " [INFO] [" + p.name + "|/" + endpoint(p) + "] <-> InitialHandler has connected\n";
+            else
+                out += " [INFO] [/" + endpoint(p) + "] <-> InitialHandler has pinged\n";
+            return;
+        }
+        switch (rng.below(5)) {
+        case 0: out += " [INFO] [" + p.name + "] -> UpstreamBridge has disconnected\n"; return;
+        case 1: out += " [INFO] [" + p.name + "] <-> ServerConnector [lobby] has connected\n"; return;
+        case 2: out += " [INFO] [" + p.name + "] <-> DownstreamBridge <-> [survival] has disconnected\n"; return;
+        case 3:
+            if (rng.chance(0.05)) {
+                out += " [WARNING] Error reading packet from " + p.name + "\n";
+                appendStackTrace(out);
+                return;
+            }
+            [[fallthrough]];
+        default: out += " [INFO] " + p.name + " executed command: /server survival\n"; return;
+        }
+    }
+
+    void appendVelocity(QByteArray &out, bool address) {
+        const Player &p = player();
+        out += "[" + clock(false) + " INFO]: ";
+        if (address) {
+            switch (rng.below(3)) {
+            case 0: out += "[connected player] " + p.name + " (/" + endpoint(p) + ") has connected\n"; return;
+            case 1: out += "[connected player] " + p.name + " (/" + endpoint(p) + ") has disconnected\n"; return;
+            default: out += "[initial connection] /" + endpoint(p) + " has disconnected: Connection reset by peer\n"; return;
+            }
+        }
+        switch (rng.below(4)) {
+        case 0: out += "[server connection] " + p.name + " -> lobby has connected\n"; return;
+        case 1: out += rng.chance(0.05) ? "Listening on /0.0.0.0:25577\n" : "Loaded 12 plugins\n"; return;
+        default: out += "[chat] <" + p.name + "> " + rng.pick(kChat) + "\n"; return;
+        }
+    }
+};
+
+bool generateCorpus(const CorpusSpec &spec, QIODevice &out) {
+    CorpusGenerator generator(spec);
+    const bool utf8 = spec.encoding.encoding == QStringConverter::Utf8 && !spec.encoding.gb18030;
+    QStringEncoder encoder = spec.encoding.encoder(spec.encoding.isAsciiCompatible() ? QStringConverter::Flag::Default
+                                                                                   : QStringConverter::Flag::WriteBom);
+    QByteArray block;
+    qint64 written = 0;
+    while (written < spec.size) {
+        block.resize(0);
+        while (block.size() < (1 << 20) && written + block.size() < spec.size) generator.appendLine(block);
+        written += block.size();
+        const QByteArray data = utf8 ? block : QByteArray(encoder.encode(QString::fromUtf8(block)));
+        if (out.write(data) != data.size()) return false;
+    }
+    return true;
+}
+
+bool parseFlavor(const QString &text, LogFlavor *flavorOut) {
+    for (LogFlavor f : { LogFlavor::Vanilla, LogFlavor::Bungee, LogFlavor::Velocity, LogFlavor::Mixed }) {
+        if (text.compare(flavorName(f), Qt::CaseInsensitive) == 0) {
+            *flavorOut = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+QString flavorName(LogFlavor flavor) {
+    switch (flavor) {
+    case LogFlavor::Vanilla: return "vanilla";
+    case LogFlavor::Bungee: return "bungee";
+    case LogFlavor::Velocity: return "velocity";
+    default: return "mixed";
+    }
+}
+
+bool parseEncoding(const QString &text, TextEncoding *encodingOut) {
+    const QString lower = text.toLower();
+    TextEncoding enc;
+    if (lower == "gb18030" || lower == "gbk") {
+        enc.gb18030 = true;
+    } else if (lower == "utf-16le" || lower == "utf-16be") {
+        enc.encoding = lower == "utf-16le" ? QStringConverter::Utf16LE : QStringConverter::Utf16BE;
+        enc.bom = true;
+    } else if (lower != "utf-8" && lower != "utf8") {
+        return false;
+    }
+    *encodingOut = enc;
+    return true;
+}
+
+qint64 parseSize(const QString &text) {
+    if (text.isEmpty()) return -1;
+    qint64 unit = 1;
+    QString digits = text;
+    switch (text.back().toUpper().unicode()) {
+    case 'K': unit = 1ll << 10; break;
+    case 'M': unit = 1ll << 20; break;
+    case 'G': unit = 1ll << 30; break;
+    default: break;
+    }
+    if (unit > 1) digits.chop(1);
+    bool ok = false;
+    const double value = digits.toDouble(&ok);
+    return ok && value > 0 ? qint64(value * double(unit)) : -1;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// ---------------------------- 合成语料 ----------------------------
+// 生成仿真的 Minecraft 服务端（原版 / Paper）、BungeeCord 与 Velocity 日志：登录行中的 /IP:端口、
+// UUID、聊天（含中文与形似 IP 的版本号）、堆栈跟踪等。内容只由种子决定，同样的参数总是生成同样的字节
+
+#include "core/textencoding.h"
+
+#include <QIODevice>
+#include <QString>
+
+enum class LogFlavor { Vanilla, Bungee, Velocity, Mixed };
+
+struct CorpusSpec {
+    LogFlavor flavor = LogFlavor::Mixed;
+    qint64 size = 64ll << 20;      // 目标大小（UTF-8 字节），写到超过该大小的第一个整行为止
+    double ipDensity = 0.2;        // 含 IP 地址的行所占的比例
+    quint64 seed = 1;
+    mcla::TextEncoding encoding;   // 输出编码，UTF-16 时带 BOM
+};
+
+// 按 spec 生成日志写入 out，写入失败时返回 false
+bool generateCorpus(const CorpusSpec &spec, QIODevice &out);
+
+// vanilla / bungee / velocity / mixed
+bool parseFlavor(const QString &text, LogFlavor *flavorOut);
+QString flavorName(LogFlavor flavor);
+
+// utf-8 / gb18030 / utf-16le / utf-16be
+bool parseEncoding(const QString &text, mcla::TextEncoding *encodingOut);
+
+// 带 K / M / G 后缀的大小（1024 进制），格式不对时返回 -1
+qint64 parseSize(const QString &text);
@@ -0,0 +1,376 @@
+// ---------------------------- 性能基准 ----------------------------
+// mcla-bench generate <文件> [--size 64M] [--flavor mixed] [--ip-density 0.2] [--seed 1] [--encoding utf-8] [--archives]
+// mcla-bench run [--size 64M] [--flavor mixed] [--ip-density 0.2] [--seed 1] [--encoding utf-8] [-j N] [--report <文件|->]
+// mcla-bench diff [--size 16M] [--seed 1] [--input <文件>]
+// run 在临时目录中生成语料（含 .gz / .zip / .tar.gz），逐项测量解压、读取、编码识别、脱敏（单线程与多线程）、
+// 导出与流式处理的吞吐量；diff 把各实现的结果与原正则实现逐字节比对，不一致时返回非 0
+
+#include "corpus.h"
+
+#include "core/archive.h"
+#include "core/ipscanner.h"
+#include "core/logfile.h"
+#include "core/logsource.h"
+#include "core/metrics.h"
+#include "core/pseudonyms.h"
+#include "core/redactor.h"
+#include "core/rules.h"
+#include "core/textencoding.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace mcla;
+
+static void printUsage() {
+    std::fprintf(stderr,
+                 "用法：\n"
+                 "  mcla-bench generate <文件> [--size 64M] [--flavor vanilla|bungee|velocity|mixed]\n"
+                 "                      [--ip-density 0.2] [--seed 1] [--encoding utf-8|gb18030|utf-16le] [--archives]\n"
+                 "  mcla-bench run [同上的语料参数] [-j N] [--report <文件|->]\n"
+                 "  mcla-bench diff [--size 16M] [--seed 1] [--input <文件>]\n");
+}
+
+// 解析语料参数，不认识的参数留给调用方；出错时返回 false
+static bool parseCorpusOption(const QStringList &args, int &i, CorpusSpec &spec) {
+    const QString &a = args[i];
+    if (i + 1 >= args.size()) return false;
+    const QString value = args[i + 1];
+    bool ok = true;
+    if (a == "--size") {
+        spec.size = parseSize(value);
+        ok = spec.size > 0;
+    } else if (a == "--flavor") {
+        ok = parseFlavor(value, &spec.flavor);
+    } else if (a == "--ip-density") {
+        spec.ipDensity = value.toDouble(&ok);
+        ok = ok && spec.ipDensity >= 0 && spec.ipDensity <= 1;
+    } else if (a == "--seed") {
+        spec.seed = value.toULongLong(&ok);
+    } else if (a == "--encoding") {
+        ok = parseEncoding(value, &spec.encoding);
+    } else {
+        return false;
+    }
+    if (!ok) std::fprintf(stderr, "参数 %s 的值无效：%s\n", qPrintable(a), qPrintable(value));
+    ++i;
+    return ok;
+}
+
+static bool isCorpusOption(const QString &a) {
+    return a == "--size" || a == "--flavor" || a == "--ip-density" || a == "--seed" || a == "--encoding";
+}
+
+static bool writeCorpus(const CorpusSpec &spec, const QString &path) {
+    return writeFileAtomically(path, false, [&](QIODevice &out) { return generateCorpus(spec, out); });
+}
+
+// 在 path 旁边生成 .gz、.zip 与 .tar.gz（压缩包中只有一个同名条目）
+static bool writeArchives(const QString &path) {
+    const QString entry = QFileInfo(path).fileName();
+    QString error;
+    const bool gz = writeFileAtomically(path + ".gz", true, [&](QIODevice &out) {
+        QFile in(path);
+        if (!in.open(QIODevice::ReadOnly)) return false;
+        QByteArray buf(kStreamChunkSize, Qt::Uninitialized);
+        for (;;) {
+            const qint64 got = readChunk(in, buf.data(), buf.size());
+            if (got <= 0) return got == 0;
+            if (out.write(buf.constData(), got) != got) return false;
+        }
+    });
+    if (!gz || !packFile(path, entry, ArchiveKind::Zip, path + ".zip", &error)
+        || !packFile(path, entry, ArchiveKind::TarGz, path + ".tar.gz", &error)) {
+        std::fprintf(stderr, "无法生成压缩包：%s\n", qPrintable(error.isEmpty() ? path : error));
+        return false;
+    }
+    return true;
+}
+
+static int runGenerate(const QStringList &args) {
+    CorpusSpec spec;
+    QString target;
+    bool archives = false;
+    for (int i = 2; i < args.size(); ++i) {
+        const QString &a = args[i];
+        if (isCorpusOption(a)) {
+            if (!parseCorpusOption(args, i, spec)) return 2;
+        } else if (a == "--archives") {
+            archives = true;
+        } else if (target.isEmpty() && !a.startsWith("--")) {
+            target = a;
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (target.isEmpty()) {
+        printUsage();
+        return 2;
+    }
+    if (!writeCorpus(spec, target)) {
+        std::fprintf(stderr, "无法写入：%s\n", qPrintable(target));
+        return 1;
+    }
+    if (archives && !writeArchives(target)) return 1;
+    std::printf("%s  %lld bytes  %s  %s\n", qPrintable(target), static_cast<long long>(QFileInfo(target).size()),
+                qPrintable(flavorName(spec.flavor)), qPrintable(spec.encoding.name()));
+    return 0;
+}
+
+// ---- run ----
+
+// 计时执行 step 并记入 metrics；step 返回输出的字节数，失败时返回 -1
+static bool measure(RunMetrics &metrics, const QString &stage, qint64 bytesIn, const std::function<qint64()> &step) {
+    QElapsedTimer t;
+    t.start();
+    const qint64 out = step();
+    if (out < 0) {
+        std::fprintf(stderr, "阶段 %s 失败\n", qPrintable(stage));
+        return false;
+    }
+    metrics.add(stage, t.nsecsElapsed(), bytesIn, out);
+    return true;
+}
+
+// 只解压不保存：内存占用与语料大小无关
+static qint64 drainSource(const QString &path) {
+    auto source = openLogSource(path);
+    if (!source) return -1;
+    QByteArray buf(kStreamChunkSize, Qt::Uninitialized);
+    qint64 total = 0;
+    for (;;) {
+        const qint64 got = readChunk(*source, buf.data(), buf.size());
+        if (got < 0) return -1;
+        if (got == 0) return total;
+        total += got;
+    }
+}
+
+static int runRun(const QStringList &args) {
+    CorpusSpec spec;
+    int jobs = QThread::idealThreadCount();
+    QString reportPath;
+    for (int i = 1; i < args.size(); ++i) {
+        const QString &a = args[i];
+        if (a == "run") continue;
+        if (isCorpusOption(a)) {
+            if (!parseCorpusOption(args, i, spec)) return 2;
+        } else if (a == "-j" && i + 1 < args.size()) {
+            jobs = qMax(1, args[++i].toInt());
+        } else if (a == "--report" && i + 1 < args.size()) {
+            reportPath = args[++i];
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "无法创建临时目录\n");
+        return 1;
+    }
+    const QString corpus = dir.filePath("corpus.log");
+    QElapsedTimer t;
+    t.start();
+    if (!writeCorpus(spec, corpus) || !writeArchives(corpus)) return 1;
+    const qint64 size = QFileInfo(corpus).size();
+    std::printf("corpus    %.1f MiB  %s  %s  ip-density %.2f  seed %llu  (%.1f s)\n", size / (1024.0 * 1024.0),
+                qPrintable(flavorName(spec.flavor)), qPrintable(spec.encoding.name()), spec.ipDensity,
+                static_cast<unsigned long long>(spec.seed), t.nsecsElapsed() / 1e9);
+
+    RunMetrics metrics;
+    bool ok = measure(metrics, "gunzip", size, [&] { return drainSource(corpus + ".gz"); })
+              && measure(metrics, "unzip", size, [&] { return drainSource(corpus + ".zip"); })
+              && measure(metrics, "untar", size, [&] { return drainSource(corpus + ".tar.gz"); });
+
+    std::shared_ptr<QFile> mapping;
+    QByteArray raw;
+    ok = ok && measure(metrics, "map", size, [&] {
+        raw = mapPlainFile(corpus, mapping);
+        return raw.isEmpty() ? -1 : raw.size();
+    });
+    TextEncoding enc;
+    ok = ok && measure(metrics, "detect", size, [&] {
+        enc = detectTextEncoding(raw.constData(), raw.size());
+        return 0;
+    });
+    const QByteArray bytes = ok ? toWorkingBytes(raw, enc) : QByteArray();
+
+    TaskProgress hits;
+    RedactedLog r;
+    ok = ok && measure(metrics, "redact-1", bytes.size(), [&] {
+        return redactBytes(bytes, enc.working(), r, &hits) ? r.outputSize(bytes.size()) : -1;
+    });
+    ok = ok && measure(metrics, QString("redact-%1").arg(jobs), bytes.size(), [&] {
+        RedactedLog parallel;
+        return redactBytes(bytes, enc.working(), parallel, nullptr, jobs) ? parallel.outputSize(bytes.size()) : -1;
+    });
+    ok = ok && measure(metrics, "export", bytes.size(), [&] {
+        const QString out = dir.filePath("export.log");
+        return writeRedactedFile(out, bytes, r, enc) ? QFileInfo(out).size() : -1;
+    });
+    ok = ok && measure(metrics, "export-gz", bytes.size(), [&] {
+        const QString out = dir.filePath("export.log.gz");
+        return writeRedactedFile(out, bytes, r, enc, nullptr, true) ? QFileInfo(out).size() : -1;
+    });
+    ok = ok && measure(metrics, "stream", size, [&] {
+        const QString out = dir.filePath("stream.log");
+        return anonymizeFileStreaming(corpus, out) ? QFileInfo(out).size() : -1;
+    });
+    if (!ok) return 1;
+
+    std::printf("%-10s %10s %10s %12s\n", "stage", "ms", "MiB", "MiB/s");
+    for (const auto &[stage, s] : metrics.stages()) {
+        std::printf("%-10s %10.1f %10.1f %12.1f\n", qPrintable(stage), s.ns / 1e6, s.bytesIn / (1024.0 * 1024.0),
+                    s.mibPerSecond());
+    }
+    const qint64 peak = peakRssBytes();
+    if (peak >= 0) std::printf("peak RSS  %.1f MiB\n", peak / (1024.0 * 1024.0));
+
+    if (!reportPath.isEmpty()) {
+        QJsonObject corpusInfo;
+        corpusInfo["flavor"] = flavorName(spec.flavor);
+        corpusInfo["encoding"] = spec.encoding.name();
+        corpusInfo["ipDensity"] = spec.ipDensity;
+        corpusInfo["seed"] = QString::number(spec.seed);
+        corpusInfo["bytes"] = size;
+        QJsonObject report;
+        report["corpus"] = corpusInfo;
+        report["threads"] = jobs;
+        report["stages"] = metrics.toJson();
+        report["peakRssBytes"] = peak;
+        report["hits"] = ruleHitsJson(*activeRuleSet(), hits);
+        const QByteArray json = QJsonDocument(report).toJson();
+        if (reportPath == "-") {
+            std::fwrite(json.constData(), 1, json.size(), stdout);
+        } else if (!writeFileAtomically(reportPath, false, [&](QIODevice &out) { return out.write(json) == json.size(); })) {
+            std::fprintf(stderr, "无法写入报告：%s\n", qPrintable(reportPath));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// ---- diff ----
+
+// 报告第一个不同的位置及其前后的内容
+static bool sameText(const char *name, const QString &expected, const QString &actual) {
+    if (expected == actual) {
+        std::printf("%-24s ok\n", name);
+        return true;
+    }
+    qsizetype at = 0;
+    const qsizetype n = qMin(expected.size(), actual.size());
+    while (at < n && expected[at] == actual[at]) ++at;
+    const qsizetype from = qMax<qsizetype>(0, at - 40);
+    std::printf("%-24s MISMATCH at char %lld (lengths %lld / %lld)\n", name, static_cast<long long>(at),
+                static_cast<long long>(expected.size()), static_cast<long long>(actual.size()));
+    std::printf("  expected: %s\n", qPrintable(expected.mid(from, 120).replace('\n', "\\n")));
+    std::printf("  actual:   %s\n", qPrintable(actual.mid(from, 120).replace('\n', "\\n")));
+    return false;
+}
+
+// 按 chunkSize（为 0 时每块随机 1 到 64 KiB）切块送入流式接口
+static QByteArray streamInChunks(const QByteArray &raw, qsizetype chunkSize, bool lineBuffered, quint64 seed) {
+    QByteArray out;
+    StreamAnonymizer anonymizer([&](QByteArrayView piece) {
+        out.append(piece);
+        return true;
+    });
+    anonymizer.setLineBuffered(lineBuffered);
+    quint64 state = seed;
+    for (qsizetype pos = 0; pos < raw.size();) {
+        qsizetype take = chunkSize;
+        if (take == 0) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            take = 1 + qsizetype((state >> 33) % (64 << 10));
+        }
+        take = qMin(take, raw.size() - pos);
+        if (!anonymizer.feed(QByteArrayView(raw.constData() + pos, take))) return {};
+        pos += take;
+    }
+    return anonymizer.finish() ? out : QByteArray();
+}
+
+static int runDiff(const QStringList &args) {
+    CorpusSpec spec;
+    spec.size = 16ll << 20;
+    QString input;
+    for (int i = 2; i < args.size(); ++i) {
+        const QString &a = args[i];
+        if (isCorpusOption(a)) {
+            if (!parseCorpusOption(args, i, spec)) return 2;
+        } else if (a == "--input" && i + 1 < args.size()) {
+            input = args[++i];
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    QByteArray raw;
+    if (input.isEmpty()) {
+        QTemporaryDir dir;
+        const QString corpus = dir.filePath("corpus.log");
+        if (!dir.isValid() || !writeCorpus(spec, corpus)) {
+            std::fprintf(stderr, "无法生成语料\n");
+            return 1;
+        }
+        raw = readPlainFile(corpus);
+    } else {
+        raw = readPlainFile(input);
+    }
+    if (raw.isEmpty()) {
+        std::fprintf(stderr, "无法读取输入\n");
+        return 1;
+    }
+
+    // 正则实现只认识默认规则（IPv4 与端口），对比时使用默认规则集、不做一致化替换
+    setActiveRuleSet(RuleSet::defaults());
+    setActivePseudonymTable(nullptr);
+
+    const TextEncoding enc = detectTextEncoding(raw.constData(), raw.size());
+    const QByteArray bytes = toWorkingBytes(raw, enc);
+    auto decode = [&](const QByteArray &b) { return QString(enc.working().decoder().decode(b)); };
+    auto decodeRaw = [&](const QByteArray &b) { return QString(enc.decoder().decode(b)); };
+    const QString text = decode(bytes);
+    std::printf("input     %.1f MiB (%s)\n", raw.size() / (1024.0 * 1024.0), qPrintable(enc.name()));
+
+    const QString expected = anonymizeTextRegex(text);
+    const int jobs = QThread::idealThreadCount();
+    bool ok = sameText("scanner", expected, anonymizeText(text));
+    if (enc.isAsciiCompatible()) {
+        ok = sameText("bytes -j1", expected, decode(anonymizeBytes(bytes, enc, 1))) && ok;
+        ok = sameText(qPrintable(QString("bytes -j%1").arg(jobs)), expected, decode(anonymizeBytes(bytes, enc, jobs))) && ok;
+    }
+    for (qsizetype chunk : { qsizetype(3), qsizetype(4096), qsizetype(65543), qsizetype(0) }) {
+        const QString name = chunk ? QString("stream %1").arg(chunk) : QString("stream random");
+        ok = sameText(qPrintable(name), expected, decodeRaw(streamInChunks(raw, chunk, false, spec.seed))) && ok;
+    }
+    ok = sameText("stream line-buffered", expected, decodeRaw(streamInChunks(raw, 0, true, spec.seed))) && ok;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.size() >= 2 && args[1] == "generate") return runGenerate(args);
+    if (args.size() >= 2 && args[1] == "run") return runRun(args);
+    if (args.size() >= 2 && args[1] == "diff") return runDiff(args);
+    printUsage();
+    return 2;
+}
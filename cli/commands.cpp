@@ -0,0 +1,557 @@
+#include "commands.h"
+#include "service.h"
+
+#include "core/archive.h"
+#include "core/batch.h"
+#include "core/follower.h"
+#include "core/ipscanner.h"
+#include "core/logfile.h"
+#include "core/logsource.h"
+#include "core/metrics.h"
+#include "core/progress.h"
+#include "core/pseudonyms.h"
+#include "core/redactor.h"
+#include "core/resultcache.h"
+#include "core/rotation.h"
+#include "core/rules.h"
+#include "core/textencoding.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <vector>
+
+using namespace mcla;
+
+// ---------------------------- 命令行批处理 ----------------------------
+// mcla-cli --in <文件或目录...> --out <输出目录> [-j N] [--rules <规则文件>] [--pseudonymize [--map <编号表>]]
+//          [--report <报告文件>] [--max-memory <MiB>] [--cache <缓存目录> [--cache-size <MiB>]]
+// 只依赖 QtCore 与 QtNetwork，可在无显示环境（cron、日志转运脚本）中运行
+
+static void printBatchUsage() {
+    std::fprintf(stderr,
+        "用法: mcla-cli --in <文件或目录...> --out <输出目录> [-j N] [--rules <规则文件>]\n"
+        "               [--pseudonymize [--map <编号表>]] [--report <报告文件>] [--max-memory <MiB>]\n"
+        "               [--cache <缓存目录> [--cache-size <MiB>]]\n"
+        "      mcla-cli --follow <日志文件> [--out <输出文件>] [--from-start] [--rules <规则文件>]\n"
+        "               [--pseudonymize [--map <编号表>]]\n"
+        "      mcla-cli --merge <logs 目录> --out <输出文件> [-j N] [--rules <规则文件>] [--pseudonymize [--map <编号表>]]\n"
+        "      mcla-cli --serve <端口 | unix:路径> [-j N] [--rules <规则文件>] [--pseudonymize [--map <编号表>]]\n"
+        "      mcla-cli --bench-scanner <日志文件>\n"
+        "      mcla-cli --bench-threads <日志文件>\n"
+        "  --in   待处理的日志文件（.log/.txt/.gz/.zip/.tar.gz）或目录，目录会递归遍历；\n"
+        "         .zip/.tar.gz 中的所有文本条目都会脱敏，并重新打包为同类型压缩包\n"
+        "  --out  输出目录，目录输入会在其中保留相对路径\n"
+        "  -j N   并行处理的文件数，默认为 CPU 核心数\n"
+        "  --rules 规则文件，默认使用程序目录下的 anonymizer-rules.txt（不存在时只删除 IP 及端口）\n"
+        "  --pseudonymize  把每个不同的 IP 与端口替换为固定编号（IP-0001:PORT-07），所有文件共用同一套编号\n"
+        "  --map  编号表文件（隐含 --pseudonymize）：存在时先载入，结束后写回，多次运行保持编号一致\n"
+        "  --report 把各阶段耗时、吞吐量、峰值内存、命中次数与每个文件的结果写成 JSON（- 为标准输出）\n"
+        "  --max-memory 单个文件整体载入内存的上限（压缩文件按解压后估计），超过的文件改为流式处理\n"
+        "  --cache 结果缓存目录：内容与规则都未变的文件直接取出上次的结果（一致化替换时不使用）；\n"
+        "         --cache-size 缓存总大小上限，默认 2048，超出时淘汰最久未用的结果\n"
+        "  --follow  跟踪不断增长的日志（类似 tail -F），只脱敏新追加的行，写到标准输出或追加到 --out 指定的文件；\n"
+        "         日志被轮转或截断时从新文件开头继续。默认跳过已有内容，--from-start 从文件开头处理\n"
+        "  --merge  把目录中的 latest.log 与 YYYY-MM-DD-N.log.gz 并行脱敏，按时间合并为一个文件（以 .gz 结尾时压缩）\n"
+        "  --serve  常驻的脱敏服务，监听 127.0.0.1 的端口或 Unix 域套接字：POST /anonymize 上传日志（原始或 gzip），\n"
+        "         边上传边以分块响应返回脱敏结果；-j 为处理连接的线程数，规则与编号表在所有请求间共用\n"
+        "  --bench-scanner  对比扫描器与原正则实现的吞吐量；--bench-threads  单个文件分段并行的扩展性\n"
+        "图形界面程序 MCLogAnonymizer 也接受以上参数\n");
+}
+
+// 写出 JSON 报告，path 为 - 时写到标准输出
+static bool writeReport(const QString &path, const QJsonObject &report) {
+    const QByteArray json = QJsonDocument(report).toJson();
+    if (path == "-") return std::fwrite(json.constData(), 1, size_t(json.size()), stdout) == size_t(json.size());
+    return writeFileAtomically(path, false, [&](QIODevice &out) { return out.write(json) == json.size(); });
+}
+
+// 载入 --rules 指定的规则文件（未指定时为程序目录下的默认规则文件）并设为当前规则集，出错时打印说明并返回 false
+static bool applyRules(QString rulesPath) {
+    if (rulesPath.isEmpty() && QFileInfo::exists(defaultRulesPath())) rulesPath = defaultRulesPath();
+    if (rulesPath.isEmpty()) return true;
+    QString error;
+    RuleSetPtr rules = RuleSet::load(rulesPath, &error);
+    if (!rules) {
+        std::fprintf(stderr, "规则文件有误：%s  %s\n", qPrintable(rulesPath), qPrintable(error));
+        return false;
+    }
+    setActiveRuleSet(rules);
+    return true;
+}
+
+// 启用一致化替换；mapPath 存在时先载入其中的编号，出错时打印说明并返回空
+static PseudonymTablePtr applyPseudonyms(const QString &mapPath) {
+    auto pseudonyms = std::make_shared<PseudonymTable>();
+    QString error;
+    if (!mapPath.isEmpty() && QFileInfo::exists(mapPath) && !pseudonyms->load(mapPath, &error)) {
+        std::fprintf(stderr, "无法载入编号表：%s  %s\n", qPrintable(mapPath), qPrintable(error));
+        return nullptr;
+    }
+    setActivePseudonymTable(pseudonyms);
+    return pseudonyms;
+}
+
+static int runBatch(const QStringList &args) {
+    QStringList inputs;
+    QString outDir;
+    QString rulesPath;
+    QString mapPath;
+    QString reportPath;
+    QString cacheDir;
+    bool pseudonymize = false;
+    int jobs = QThread::idealThreadCount();
+    qint64 memoryLimit = 0;
+    qint64 cacheSize = ResultCache::kDefaultCapacity;
+
+    for (int i = 1; i < args.size(); ++i) {
+        const QString &a = args[i];
+        if (a == "--in") {
+            while (i + 1 < args.size() && !args[i + 1].startsWith('-')) inputs << args[++i];
+        } else if (a == "--out" && i + 1 < args.size()) {
+            outDir = args[++i];
+        } else if (a == "--rules" && i + 1 < args.size()) {
+            rulesPath = args[++i];
+        } else if (a == "--pseudonymize") {
+            pseudonymize = true;
+        } else if (a == "--map" && i + 1 < args.size()) {
+            mapPath = args[++i];
+            pseudonymize = true;
+        } else if (a == "--report" && i + 1 < args.size()) {
+            reportPath = args[++i];
+        } else if (a == "--max-memory" && i + 1 < args.size()) {
+            memoryLimit = args[++i].toLongLong() << 20;
+        } else if (a == "--cache" && i + 1 < args.size()) {
+            cacheDir = args[++i];
+        } else if (a == "--cache-size" && i + 1 < args.size()) {
+            cacheSize = args[++i].toLongLong() << 20;
+        } else if (a == "-j" && i + 1 < args.size()) {
+            jobs = args[++i].toInt();
+        } else if (a.startsWith("-j") && a.size() > 2) {
+            jobs = a.mid(2).toInt();
+        } else {
+            printBatchUsage();
+            return 2;
+        }
+    }
+    if (inputs.isEmpty() || outDir.isEmpty() || jobs < 1 || memoryLimit < 0 || cacheSize <= 0) {
+        printBatchUsage();
+        return 2;
+    }
+    if (!applyRules(rulesPath)) return 2;
+    PseudonymTablePtr pseudonyms;
+    if (pseudonymize && !(pseudonyms = applyPseudonyms(mapPath))) return 2;
+    if (!cacheDir.isEmpty()) setActiveResultCache(std::make_shared<ResultCache>(cacheDir, cacheSize));
+
+    QStringList relativeDirs, missing;
+    // 输出目录在输入目录之中时，不再处理上次的输出
+    const QStringList files = expandBatchInputs(inputs, &relativeDirs, &missing, outDir);
+    for (const QString &in : missing) std::fprintf(stderr, "跳过不存在的路径：%s\n", qPrintable(in));
+    QList<BatchJob> queue;
+    QSet<QString> used;
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        BatchJob job;
+        job.input = files[i];
+        job.outputDir = QDir::cleanPath(outDir + "/" + relativeDirs[i]);
+        job.memoryLimit = memoryLimit;
+        // 同一目录中的 x.log 与 x.log.gz、多个输入中的同名文件输出名相同，依次编号，避免并行写同一个文件
+        const QString name = batchTargetName(job.input);
+        job.targetName = name;
+        for (int n = 2; used.contains(job.outputDir + "/" + job.targetName); ++n)
+            job.targetName = numberedTargetName(name, n);
+        used.insert(job.outputDir + "/" + job.targetName);
+        queue.append(job);
+    }
+
+    // 文件少于线程数时，把剩余的核心分给单个文件内部（压缩包条目、分段扫描）
+    const int innerJobs = qMax(1, QThread::idealThreadCount() / int(qBound<qsizetype>(1, queue.size(), jobs)));
+    for (BatchJob &job : queue) job.innerJobs = innerJobs;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs);
+    QMutex printLock;
+    std::atomic<int> failed{0};
+    TaskProgress stats;
+    RunMetrics metrics;
+    QJsonArray files;   // 报告中每个文件的结果，受 printLock 保护
+    QElapsedTimer timer;
+    timer.start();
+
+    for (const BatchJob &job : queue) {
+        pool.start([job, &printLock, &failed, &stats, &metrics, &files] {
+            QElapsedTimer fileTimer;
+            fileTimer.start();
+            QString target;
+            const QString error = runBatchJob(job, stats, metrics, &target);
+            const qint64 ns = fileTimer.nsecsElapsed();
+            QMutexLocker lock(&printLock);
+            files.append(QJsonObject{
+                { "input", job.input },
+                { "output", error.isEmpty() ? target : QString() },
+                { "ok", error.isEmpty() },
+                { "error", error },
+                { "ms", ns / 1e6 },
+                { "bytesIn", QFileInfo(job.input).size() },
+                { "bytesOut", error.isEmpty() ? QFileInfo(target).size() : 0 },
+            });
+            if (error.isEmpty()) return;
+            failed.fetch_add(1, std::memory_order_relaxed);
+            std::fprintf(stderr, "失败：%s  %s\n", qPrintable(job.input), qPrintable(error));
+        });
+    }
+    pool.waitForDone();
+    const qint64 wallNs = timer.nsecsElapsed();
+
+    std::fprintf(stderr, "完成 %lld 个文件，失败 %d 个，用时 %.2f s（%d 线程）\n",
+                 static_cast<long long>(queue.size()), failed.load(), timer.elapsed() / 1000.0, jobs);
+    std::fprintf(stderr, "命中：%s\n", qPrintable(ruleHitSummary(*activeRuleSet(), stats)));
+    std::fprintf(stderr, "各阶段：%s\n", qPrintable(metrics.summary()));
+    if (!reportPath.isEmpty()) {
+        qint64 bytesIn = 0;
+        for (const BatchJob &job : queue) bytesIn += QFileInfo(job.input).size();
+        const QJsonObject report{
+            { "files", qint64(queue.size()) },
+            { "failed", failed.load() },
+            { "threads", jobs },
+            { "wallMs", wallNs / 1e6 },
+            { "bytesIn", bytesIn },
+            { "mibPerSec", wallNs > 0 ? bytesIn / (1024.0 * 1024.0) / (wallNs / 1e9) : 0 },
+            { "peakRssBytes", peakRssBytes() },
+            { "stages", metrics.toJson() },
+            { "hits", ruleHitsJson(*activeRuleSet(), stats) },
+            { "results", files },
+        };
+        if (!writeReport(reportPath, report)) std::fprintf(stderr, "无法写入报告：%s\n", qPrintable(reportPath));
+    }
+    if (pseudonyms) {
+        std::fprintf(stderr, "编号表：%lld 个 IP，%lld 个端口\n",
+                     static_cast<long long>(pseudonyms->ipCount()), static_cast<long long>(pseudonyms->portCount()));
+        QString error;
+        if (!mapPath.isEmpty() && !pseudonyms->save(mapPath, &error)) {
+            std::fprintf(stderr, "无法保存编号表：%s  %s\n", qPrintable(mapPath), qPrintable(error));
+            return 1;
+        }
+    }
+    return failed.load() == 0 ? 0 : 1;
+}
+
+// ---------------------------- 跟踪模式 ----------------------------
+// mcla-cli --follow <日志文件> [--out <输出文件>] [--from-start] [--rules <规则文件>] [--pseudonymize [--map <编号表>]]
+// 持续把新追加的行脱敏后写到标准输出（或追加到输出文件），直到进程被结束
+
+// 编号表在跟踪期间至多每隔这么久写回一次
+constexpr int kMapSaveIntervalMs = 10000;
+
+static int runFollow(const QStringList &args) {
+    QString input;
+    QString outPath;
+    QString rulesPath;
+    QString mapPath;
+    bool pseudonymize = false;
+    bool fromStart = false;
+
+    for (int i = 1; i < args.size(); ++i) {
+        const QString &a = args[i];
+        if (a == "--follow" && i + 1 < args.size()) {
+            input = args[++i];
+        } else if (a == "--out" && i + 1 < args.size()) {
+            outPath = args[++i];
+        } else if (a == "--from-start") {
+            fromStart = true;
+        } else if (a == "--rules" && i + 1 < args.size()) {
+            rulesPath = args[++i];
+        } else if (a == "--pseudonymize") {
+            pseudonymize = true;
+        } else if (a == "--map" && i + 1 < args.size()) {
+            mapPath = args[++i];
+            pseudonymize = true;
+        } else {
+            printBatchUsage();
+            return 2;
+        }
+    }
+    if (input.isEmpty()) {
+        printBatchUsage();
+        return 2;
+    }
+    if (!applyRules(rulesPath)) return 2;
+    PseudonymTablePtr pseudonyms;
+    if (pseudonymize && !(pseudonyms = applyPseudonyms(mapPath))) return 2;
+
+    QFile out(outPath);
+    const bool opened = outPath.isEmpty() ? out.open(stdout, QIODevice::WriteOnly)
+                                          : out.open(QIODevice::WriteOnly | QIODevice::Append);
+    if (!opened) {
+        std::fprintf(stderr, "无法写入 %s  %s\n", qPrintable(outPath), qPrintable(out.errorString()));
+        return 2;
+    }
+
+    LogFollower follower(input, [&out](QByteArrayView piece) { return out.write(piece.data(), piece.size()) == piece.size(); });
+    // 每次处理完新内容立即写出，外部程序可以马上读到
+    QObject::connect(&follower, &LogFollower::advanced, [&out] { out.flush(); });
+    QObject::connect(&follower, &LogFollower::rotated, [&input] {
+        std::fprintf(stderr, "检测到日志轮转，从新文件开头继续：%s\n", qPrintable(input));
+    });
+    QObject::connect(&follower, &LogFollower::failed, [](const QString &error) {
+        std::fprintf(stderr, "跟踪中止：%s\n", qPrintable(error));
+        // 可能在进入事件循环之前（开始时的第一次读取）就失败，排队退出
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [] { QCoreApplication::exit(1); }, Qt::QueuedConnection);
+    });
+    QTimer mapTimer;
+    if (pseudonyms && !mapPath.isEmpty()) {
+        QObject::connect(&mapTimer, &QTimer::timeout, [&pseudonyms, &mapPath] {
+            QString error;
+            if (!pseudonyms->save(mapPath, &error))
+                std::fprintf(stderr, "无法保存编号表：%s  %s\n", qPrintable(mapPath), qPrintable(error));
+        });
+        mapTimer.start(kMapSaveIntervalMs);
+    }
+
+    QString error;
+    if (!follower.start(fromStart, &error)) {
+        std::fprintf(stderr, "无法打开 %s  %s\n", qPrintable(input), qPrintable(error));
+        return 2;
+    }
+    return QCoreApplication::exec();
+}
+
+// ---------------------------- 轮转日志合并 ----------------------------
+// mcla-cli --merge <logs 目录> --out <输出文件> [-j N] [--rules <规则文件>] [--pseudonymize [--map <编号表>]]
+
+static int runMerge(const QStringList &args) {
+    QString dir;
+    QString outPath;
+    QString rulesPath;
+    QString mapPath;
+    bool pseudonymize = false;
+    int jobs = QThread::idealThreadCount();
+
+    for (int i = 1; i < args.size(); ++i) {
+        const QString &a = args[i];
+        if (a == "--merge" && i + 1 < args.size()) {
+            dir = args[++i];
+        } else if (a == "--out" && i + 1 < args.size()) {
+            outPath = args[++i];
+        } else if (a == "-j" && i + 1 < args.size()) {
+            jobs = qMax(1, args[++i].toInt());
+        } else if (a == "--rules" && i + 1 < args.size()) {
+            rulesPath = args[++i];
+        } else if (a == "--pseudonymize") {
+            pseudonymize = true;
+        } else if (a == "--map" && i + 1 < args.size()) {
+            mapPath = args[++i];
+            pseudonymize = true;
+        } else {
+            printBatchUsage();
+            return 2;
+        }
+    }
+    if (dir.isEmpty() || outPath.isEmpty()) {
+        printBatchUsage();
+        return 2;
+    }
+    if (!applyRules(rulesPath)) return 2;
+    PseudonymTablePtr pseudonyms;
+    if (pseudonymize && !(pseudonyms = applyPseudonyms(mapPath))) return 2;
+
+    const QList<RotationMember> members = findRotationSet(dir);
+    if (members.isEmpty()) {
+        std::fprintf(stderr, "没有找到轮转日志（latest.log 或 YYYY-MM-DD-N.log.gz）：%s\n", qPrintable(dir));
+        return 2;
+    }
+    TaskProgress stats;
+    for (const RotationMember &m : members) stats.total += m.size;
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    if (!mergeRotationSet(members, outPath, jobs, &error, &stats)) {
+        std::fprintf(stderr, "合并失败：%s\n", qPrintable(error));
+        return 1;
+    }
+    qint64 hits = 0;
+    for (const auto &h : stats.hits) hits += h.load(std::memory_order_relaxed);
+    std::fprintf(stderr, "已合并 %lld 个文件（%s 至 %s）→ %s，命中 %lld 处，%.1f 秒\n",
+                 static_cast<long long>(members.size()), qPrintable(members.first().date.toString(Qt::ISODate)),
+                 qPrintable(members.last().date.toString(Qt::ISODate)), qPrintable(outPath),
+                 static_cast<long long>(hits), timer.elapsed() / 1000.0);
+
+    if (pseudonyms && !mapPath.isEmpty() && !pseudonyms->save(mapPath, &error)) {
+        std::fprintf(stderr, "无法保存编号表：%s  %s\n", qPrintable(mapPath), qPrintable(error));
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------------------- 脱敏服务 ----------------------------
+// mcla-cli --serve <端口 | unix:路径> [-j N] [--rules <规则文件>] [--pseudonymize [--map <编号表>]]
+// 例：curl --unix-socket /tmp/mcla.sock --data-binary @latest.log.gz http://localhost/anonymize > latest.log
+
+static int runServe(const QStringList &args) {
+    QString address;
+    QString rulesPath;
+    QString mapPath;
+    bool pseudonymize = false;
+    int jobs = QThread::idealThreadCount();
+
+    for (int i = 1; i < args.size(); ++i) {
+        const QString &a = args[i];
+        if (a == "--serve" && i + 1 < args.size()) {
+            address = args[++i];
+        } else if (a == "-j" && i + 1 < args.size()) {
+            jobs = qMax(1, args[++i].toInt());
+        } else if (a == "--rules" && i + 1 < args.size()) {
+            rulesPath = args[++i];
+        } else if (a == "--pseudonymize") {
+            pseudonymize = true;
+        } else if (a == "--map" && i + 1 < args.size()) {
+            mapPath = args[++i];
+            pseudonymize = true;
+        } else {
+            printBatchUsage();
+            return 2;
+        }
+    }
+    if (address.isEmpty()) {
+        printBatchUsage();
+        return 2;
+    }
+    if (!applyRules(rulesPath)) return 2;
+    PseudonymTablePtr pseudonyms;
+    if (pseudonymize && !(pseudonyms = applyPseudonyms(mapPath))) return 2;
+
+    AnonymizeService service(jobs);
+    QString error;
+    if (!service.listen(address, &error)) {
+        std::fprintf(stderr, "无法监听 %s  %s\n", qPrintable(address), qPrintable(error));
+        return 2;
+    }
+    std::fprintf(stderr, "脱敏服务已启动：%s（%d 个线程）\n", qPrintable(service.listeningAddress()), jobs);
+
+    QTimer mapTimer;
+    if (pseudonyms && !mapPath.isEmpty()) {
+        QObject::connect(&mapTimer, &QTimer::timeout, [&pseudonyms, &mapPath] {
+            QString error;
+            if (!pseudonyms->save(mapPath, &error))
+                std::fprintf(stderr, "无法保存编号表：%s  %s\n", qPrintable(mapPath), qPrintable(error));
+        });
+        mapTimer.start(kMapSaveIntervalMs);
+    }
+    return QCoreApplication::exec();
+}
+
+// ---------------------------- 性能基准 ----------------------------
+
+// 对比扫描器与原正则实现的吞吐量：mcla-cli --bench-scanner <日志文件>
+static int runScannerBenchmark(const QString &path) {
+    const QByteArray raw = readPlainFile(path);
+    const TextEncoding enc = detectTextEncoding(raw.constData(), raw.size());
+    const QByteArray bytes = toWorkingBytes(raw, enc);
+    const QString text = enc.working().decoder().decode(bytes);
+    if (text.isEmpty()) {
+        std::fprintf(stderr, "无法读取文本文件：%s\n", qPrintable(path));
+        return 1;
+    }
+    const double mb = text.size() * 2 / (1024.0 * 1024.0);
+
+    QElapsedTimer t;
+    t.start();
+    QString viaRegex = anonymizeTextRegex(text);
+    const qint64 regexNs = t.nsecsElapsed();
+
+    t.restart();
+    QString viaScanner = anonymizeText(text);
+    const qint64 scannerNs = t.nsecsElapsed();
+
+    t.restart();
+    const QByteArray viaBytes = anonymizeBytes(bytes, enc.working());
+    const qint64 bytesNs = t.nsecsElapsed();
+    const double byteMb = bytes.size() / (1024.0 * 1024.0);
+    const bool identical = viaRegex == viaScanner && viaRegex == QString(enc.working().decoder().decode(viaBytes));
+
+    std::printf("input     %.1f MiB (UTF-16), %.1f MiB (%s)\n", mb, byteMb, qPrintable(enc.name()));
+    std::printf("regex     %8.1f ms  %8.1f MiB/s\n", regexNs / 1e6, mb / (regexNs / 1e9));
+    std::printf("scanner   %8.1f ms  %8.1f MiB/s\n", scannerNs / 1e6, mb / (scannerNs / 1e9));
+    std::printf("bytes     %8.1f ms  %8.1f MiB/s\n", bytesNs / 1e6, byteMb / (bytesNs / 1e9));
+    std::printf("identical %s\n", identical ? "yes" : "NO");
+    return identical ? 0 : 2;
+}
+
+// 单个文件分段并行脱敏的扩展性：mcla-cli --bench-threads <日志文件>
+// 线程数从 1 起按 2 倍递增到 CPU 核心数，每档取 3 次中最快的一次，并校验结果与单线程完全相同
+static int runThreadScalingBenchmark(const QString &path) {
+    std::shared_ptr<QFile> mapping;
+    const QByteArray raw = mapPlainFile(path, mapping);
+    if (raw.isEmpty()) {
+        std::fprintf(stderr, "无法读取文件：%s\n", qPrintable(path));
+        return 1;
+    }
+    const TextEncoding enc = detectTextEncoding(raw.constData(), raw.size());
+    const QByteArray bytes = toWorkingBytes(raw, enc);
+    const double mb = bytes.size() / (1024.0 * 1024.0);
+    std::printf("input     %.1f MiB (%s), %d cores\n", mb, qPrintable(enc.name()), QThread::idealThreadCount());
+
+    RedactedLog serial;
+    redactBytes(bytes, enc.working(), serial);
+    std::vector<int> counts;
+    for (int jobs = 1; jobs < QThread::idealThreadCount(); jobs *= 2) counts.push_back(jobs);
+    counts.push_back(QThread::idealThreadCount());
+
+    bool identical = true;
+    double base = 0;
+    for (int jobs : counts) {
+        qint64 best = std::numeric_limits<qint64>::max();
+        for (int round = 0; round < 3; ++round) {
+            RedactedLog r;
+            QElapsedTimer t;
+            t.start();
+            redactBytes(bytes, enc.working(), r, nullptr, jobs);
+            best = qMin(best, t.nsecsElapsed());
+            identical = identical && r.spans.size() == serial.spans.size() && r.replacements == serial.replacements
+                        && std::equal(r.spans.cbegin(), r.spans.cend(), serial.spans.cbegin(), [](const TextSpan &a, const TextSpan &b) {
+                               return a.start == b.start && a.end == b.end && a.rule == b.rule;
+                           });
+        }
+        const double rate = mb / (best / 1e9);
+        if (jobs == 1) base = rate;
+        std::printf("threads %3d  %8.1f ms  %8.1f MiB/s  x%.2f\n", jobs, best / 1e6, rate, rate / base);
+    }
+    std::printf("identical %s\n", identical ? "yes" : "NO");
+    return identical ? 0 : 2;
+}
+
+bool isCommandLineInvocation(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--in") == 0 || qstrcmp(argv[i], "--follow") == 0 || qstrcmp(argv[i], "--serve") == 0 ||
+            qstrcmp(argv[i], "--merge") == 0 ||
+            qstrncmp(argv[i], "--bench-", 8) == 0)
+            return true;
+    }
+    return false;
+}
+
+int runCommandLine(const QStringList &args) {
+    if (args.size() == 3 && args[1] == "--bench-scanner") return runScannerBenchmark(args[2]);
+    if (args.size() == 3 && args[1] == "--bench-threads") return runThreadScalingBenchmark(args[2]);
+    if (args.contains("--follow")) return runFollow(args);
+    if (args.contains("--serve")) return runServe(args);
+    if (args.contains("--merge")) return runMerge(args);
+    if (args.contains("--in")) return runBatch(args);
+    printBatchUsage();
+    return 2;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+// ---------------------------- 命令行 ----------------------------
+// 批处理、跟踪、轮转日志合并、脱敏服务与性能基准，由命令行工具 mcla-cli 与图形界面程序共用（图形界面收到这些参数时不创建窗口）
+
+#include <QStringList>
+
+// argv 中有批处理（--in）、跟踪（--follow）、合并（--merge）、服务（--serve）或基准测试（--bench-*）参数
+bool isCommandLineInvocation(int argc, char *argv[]);
+
+// 执行命令行操作并返回进程退出码；没有可识别的操作时打印用法并返回 2。需要已创建 QCoreApplication
+int runCommandLine(const QStringList &args);
@@ -0,0 +1,9 @@
+#include "commands.h"
+
+#include <QCoreApplication>
+
+// 命令行工具 mcla-cli：只链接核心库、QtCore 与 QtNetwork（脱敏服务），不依赖图形界面
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    return runCommandLine(app.arguments());
+}
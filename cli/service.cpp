@@ -0,0 +1,492 @@
+#include "service.h"
+
+#include "core/logsource.h"
+#include "core/redactor.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QHostAddress>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <utility>
+
+#if defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#endif
+
+namespace mcla {
+
+// 请求行与各请求头合计的上限
+constexpr qsizetype kMaxRequestHeadSize = 64 << 10;
+// 分块传输中块长度行（及尾部头）的上限
+constexpr qsizetype kMaxChunkLineSize = 4096;
+// 套接字读缓冲区的上限：攒满后不再从系统读取，上传方被 TCP 窗口或套接字缓冲区挡住
+constexpr qint64 kSocketReadBufferSize = 1 << 20;
+// 尚未发出的响应超过这么多时暂停处理输入，客户端读得慢时结果不会在内存中堆积
+constexpr qint64 kMaxPendingOutput = 4 << 20;
+// 请求体按片送入解压与脱敏，每片之后检查积压。deflate 的压缩比最高约 1032:1，
+// gzip 上传每片 4 KiB，一片解出的数据不超过约 4 MiB；未压缩的上传每片即一个流式块
+constexpr qsizetype kCompressedSliceSize = 4 << 10;
+
+namespace {
+
+class TcpListener : public QTcpServer {
+public:
+    TcpListener(std::function<void(qintptr)> accept, QObject *parent) : QTcpServer(parent), accept(std::move(accept)) {}
+
+protected:
+    void incomingConnection(qintptr descriptor) override { accept(descriptor); }
+
+private:
+    std::function<void(qintptr)> accept;
+};
+
+class LocalListener : public QLocalServer {
+public:
+    LocalListener(std::function<void(quintptr)> accept, QObject *parent) : QLocalServer(parent), accept(std::move(accept)) {}
+
+protected:
+    void incomingConnection(quintptr descriptor) override { accept(descriptor); }
+
+private:
+    std::function<void(quintptr)> accept;
+};
+
+// 一个连接上的一次请求：解析请求头后立即开始响应，请求体依次经过解分块、解压与脱敏，
+// 每块输入产生的结果写成响应的一个分块。响应都带 Connection: close，请求结束后关闭连接
+class Connection : public QObject {
+public:
+    explicit Connection(QObject *parent) : QObject(parent) {}
+
+    // close 在写完已排队的数据后关闭连接
+    void attach(QIODevice *socket, std::function<void()> close);
+    // 处理已收到的数据，直到数据用完、待发送的响应积压或请求结束；积压时未处理的部分留在 pending 中
+    void process();
+    void closed();
+
+private:
+    enum class Stage { Head, Body, Done };
+    enum class ChunkState { Size, Data, DataEnd, Trailer };
+
+    QIODevice *socket = nullptr;
+    std::function<void()> close;
+    Stage stage = Stage::Head;
+    bool responseStarted = false;
+    QByteArray pending;     // 已从套接字读出、因响应积压尚未处理的数据
+    QByteArray head;
+    QByteArray method;
+    QByteArray target;
+
+    bool chunked = false;
+    qint64 remaining = 0;   // Content-Length 剩余的字节数，或当前分块剩余的字节数
+    ChunkState chunkState = ChunkState::Size;
+    QByteArray chunkLine;
+
+    int gzip = -1;          // -1：未声明 Content-Encoding，由开头的字节识别
+    QByteArray prefix;      // 识别前攒下的开头数据
+    std::unique_ptr<GzipInflater> inflater;
+    std::unique_ptr<StreamAnonymizer> anonymizer;
+    QByteArray out;         // 尚未写成分块的输出
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+    QElapsedTimer timer;
+
+    void readHead(const QByteArray &data);
+    bool parseHead();
+    qsizetype readBody(QByteArrayView data);
+    qsizetype feedBody(QByteArrayView data);
+    bool feedSlice(QByteArrayView data);
+    bool decode(QByteArrayView data);
+    void startDecoding(bool compressed);
+    void finishBody();
+    void flushOutput();
+    void reply(int status, const char *reason, const QByteArray &body);
+    void fail(int status, const char *reason, const QString &detail);
+};
+
+void Connection::attach(QIODevice *s, std::function<void()> closeFn) {
+    socket = s;
+    close = std::move(closeFn);
+    connect(socket, &QIODevice::readyRead, this, [this] { process(); });
+    // 积压的响应发出一部分后继续处理读缓冲区中已有的数据（这些数据不会再触发 readyRead）
+    connect(socket, &QIODevice::bytesWritten, this, [this] { process(); });
+    timer.start();
+    process();
+}
+
+void Connection::process() {
+    while (stage != Stage::Done && socket->bytesToWrite() < kMaxPendingOutput) {
+        if (pending.isEmpty()) {
+            if (socket->bytesAvailable() <= 0) break;
+            pending = socket->read(stage == Stage::Head ? kMaxRequestHeadSize : kStreamChunkSize);
+            if (pending.isEmpty()) break;
+        }
+        if (stage == Stage::Head) {
+            readHead(std::exchange(pending, QByteArray()));
+        } else {
+            pending.remove(0, readBody(pending));
+        }
+    }
+}
+
+void Connection::closed() {
+    if (stage == Stage::Body)
+        std::fprintf(stderr, "%s %s 中止：连接在请求结束前断开\n", method.constData(), target.constData());
+    stage = Stage::Done;
+    deleteLater();
+}
+
+void Connection::readHead(const QByteArray &data) {
+    head.append(data);
+    const qsizetype end = head.indexOf("\r\n\r\n");
+    if (end < 0 || end > kMaxRequestHeadSize) {
+        if (head.size() > kMaxRequestHeadSize) fail(431, "Request Header Fields Too Large", "请求头过长");
+        return;
+    }
+    // 请求头之后已读到的请求体留给 process() 接着处理
+    pending = head.mid(end + 4);
+    head.truncate(end);
+    if (!parseHead()) return;
+    stage = Stage::Body;
+    if (!chunked && remaining == 0) finishBody();
+}
+
+bool Connection::parseHead() {
+    const QList<QByteArray> lines = head.split('\n');
+    const QList<QByteArray> request = lines.first().trimmed().split(' ');
+    if (request.size() != 3 || !request[2].startsWith("HTTP/1.")) {
+        fail(400, "Bad Request", "请求行有误");
+        return false;
+    }
+    method = request[0];
+    target = request[1];
+    QHash<QByteArray, QByteArray> headers;
+    for (qsizetype i = 1; i < lines.size(); ++i) {
+        const qsizetype colon = lines[i].indexOf(':');
+        if (colon > 0) headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+    }
+
+    const qsizetype query = target.indexOf('?');
+    const QByteArray path = query < 0 ? target : target.left(query);
+    if (path == "/health") {
+        if (method == "GET" || method == "HEAD") {
+            reply(200, "OK", "ok\n");
+        } else {
+            fail(405, "Method Not Allowed", "只接受 GET");
+        }
+        return false;
+    }
+    if (path != "/anonymize") {
+        fail(404, "Not Found", "请把日志 POST 到 /anonymize");
+        return false;
+    }
+    if (method != "POST" && method != "PUT") {
+        fail(405, "Method Not Allowed", "只接受 POST 或 PUT");
+        return false;
+    }
+
+    if (headers.value("transfer-encoding").toLower().contains("chunked")) {
+        chunked = true;
+    } else if (headers.contains("content-length")) {
+        bool ok = false;
+        remaining = headers.value("content-length").toLongLong(&ok);
+        if (!ok || remaining < 0) {
+            fail(400, "Bad Request", "Content-Length 有误");
+            return false;
+        }
+    } else {
+        fail(411, "Length Required", "需要 Content-Length 或分块传输");
+        return false;
+    }
+    const QByteArray contentEncoding = headers.value("content-encoding").toLower();
+    if (contentEncoding == "gzip" || contentEncoding == "x-gzip") {
+        gzip = 1;
+    } else if (!contentEncoding.isEmpty() && contentEncoding != "identity") {
+        fail(415, "Unsupported Media Type", "只支持未压缩或 gzip 压缩的上传");
+        return false;
+    }
+
+    if (headers.value("expect").toLower() == "100-continue") socket->write("HTTP/1.1 100 Continue\r\n\r\n");
+    // 输出保持上传内容的编码，不声明字符集
+    socket->write("HTTP/1.1 200 OK\r\n"
+                  "Content-Type: application/octet-stream\r\n"
+                  "Transfer-Encoding: chunked\r\n"
+                  "Connection: close\r\n\r\n");
+    responseStarted = true;
+    anonymizer = std::make_unique<StreamAnonymizer>([this](QByteArrayView piece) {
+        out.append(piece);
+        // 压缩率很高的上传一块输入可能解出大量数据，攒到一定大小就先写出
+        if (out.size() >= kStreamChunkSize) flushOutput();
+        return true;
+    });
+    if (gzip == 1) startDecoding(true);
+    return true;
+}
+
+// 返回处理掉的字节数；响应积压时只处理一部分，出错或请求结束时返回 data.size()
+qsizetype Connection::readBody(QByteArrayView data) {
+    if (!chunked) {
+        const qsizetype n = qsizetype(qMin<qint64>(remaining, data.size()));
+        const qsizetype used = feedBody(data.first(n));
+        if (used < 0) return data.size();
+        remaining -= used;
+        if (remaining == 0) {
+            finishBody();
+            return data.size();
+        }
+        return used;
+    }
+
+    qsizetype pos = 0;
+    while (pos < data.size()) {
+        if (chunkState == ChunkState::Data) {
+            const qsizetype n = qsizetype(qMin<qint64>(remaining, data.size() - pos));
+            const qsizetype used = feedBody(data.sliced(pos, n));
+            if (used < 0) return data.size();
+            pos += used;
+            remaining -= used;
+            // 块数据之后的 \r\n 当作一个空行读取
+            if (remaining == 0) chunkState = ChunkState::DataEnd;
+            if (used < n) return pos;
+            continue;
+        }
+        const qsizetype nl = data.sliced(pos).indexOf('\n');
+        chunkLine.append(data.sliced(pos, nl < 0 ? data.size() - pos : nl));
+        if (chunkLine.size() > kMaxChunkLineSize) {
+            fail(400, "Bad Request", "分块格式有误");
+            return data.size();
+        }
+        if (nl < 0) break;
+        pos += nl + 1;
+        const QByteArray line = std::exchange(chunkLine, QByteArray()).trimmed();
+        switch (chunkState) {
+        case ChunkState::DataEnd:
+            if (!line.isEmpty()) {
+                fail(400, "Bad Request", "分块格式有误");
+                return data.size();
+            }
+            chunkState = ChunkState::Size;
+            break;
+        case ChunkState::Size: {
+            // 忽略块扩展（; 之后的部分）
+            const qsizetype semicolon = line.indexOf(';');
+            bool ok = false;
+            remaining = (semicolon < 0 ? line : line.left(semicolon)).trimmed().toLongLong(&ok, 16);
+            if (!ok || remaining < 0) {
+                fail(400, "Bad Request", "分块长度有误");
+                return data.size();
+            }
+            chunkState = remaining > 0 ? ChunkState::Data : ChunkState::Trailer;
+            break;
+        }
+        case ChunkState::Trailer:
+            // 尾部头以空行结束
+            if (line.isEmpty()) {
+                finishBody();
+                return data.size();
+            }
+            break;
+        case ChunkState::Data:
+            break;
+        }
+    }
+    return data.size();
+}
+
+// 按片送入请求体，每片的结果立即写出；待发送的响应积压时停下，返回已送入的字节数，出错时返回 -1
+qsizetype Connection::feedBody(QByteArrayView data) {
+    qsizetype used = 0;
+    while (used < data.size() && socket->bytesToWrite() < kMaxPendingOutput) {
+        const qsizetype n = qMin<qsizetype>(data.size() - used, gzip == 0 ? kStreamChunkSize : kCompressedSliceSize);
+        if (!feedSlice(data.sliced(used, n))) return -1;
+        used += n;
+        flushOutput();
+    }
+    return used;
+}
+
+bool Connection::feedSlice(QByteArrayView data) {
+    bytesIn += data.size();
+    if (gzip >= 0) return decode(data);
+    // 未声明 Content-Encoding 时按开头的 gzip 标志（1f 8b）识别
+    prefix.append(data);
+    if (prefix.size() < 2) return true;
+    startDecoding(prefix.startsWith("\x1f\x8b"));
+    return decode(std::exchange(prefix, QByteArray()));
+}
+
+void Connection::startDecoding(bool compressed) {
+    gzip = compressed ? 1 : 0;
+    if (compressed) inflater = std::make_unique<GzipInflater>([this](QByteArrayView piece) { return anonymizer->feed(piece); });
+}
+
+bool Connection::decode(QByteArrayView data) {
+    if (inflater) {
+        if (inflater->feed(data)) return true;
+        fail(400, "Bad Request", "解压失败：" + inflater->errorString());
+        return false;
+    }
+    if (anonymizer->feed(data)) return true;
+    fail(500, "Internal Server Error", "脱敏失败");
+    return false;
+}
+
+void Connection::finishBody() {
+    if (gzip < 0) {
+        startDecoding(false);
+        if (!decode(std::exchange(prefix, QByteArray()))) return;
+    }
+    if (inflater && !inflater->finish()) return fail(400, "Bad Request", "解压失败：" + inflater->errorString());
+    if (!anonymizer->finish()) return fail(500, "Internal Server Error", "脱敏失败");
+    flushOutput();
+    socket->write("0\r\n\r\n");
+    stage = Stage::Done;
+
+    const auto hits = anonymizer->hitCounts();
+    std::fprintf(stderr, "%s %s  收到 %lld 字节，输出 %lld 字节，命中 %lld 处，%lld ms\n", method.constData(),
+                 target.constData(), static_cast<long long>(bytesIn), static_cast<long long>(bytesOut),
+                 static_cast<long long>(std::accumulate(hits.cbegin(), hits.cend(), qint64(0))),
+                 static_cast<long long>(timer.elapsed()));
+    close();
+}
+
+void Connection::flushOutput() {
+    if (out.isEmpty()) return;
+    socket->write(QByteArray::number(out.size(), 16) + "\r\n");
+    socket->write(out);
+    socket->write("\r\n");
+    bytesOut += out.size();
+    out.resize(0);   // 保留容量，下一块不再重新分配
+}
+
+void Connection::reply(int status, const char *reason, const QByteArray &body) {
+    socket->write(QByteArray("HTTP/1.1 ") + QByteArray::number(status) + ' ' + reason + "\r\n"
+                  "Content-Type: text/plain; charset=utf-8\r\n"
+                  "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                  "Connection: close\r\n\r\n");
+    if (method != "HEAD") socket->write(body);
+    stage = Stage::Done;
+    close();
+}
+
+void Connection::fail(int status, const char *reason, const QString &detail) {
+    std::fprintf(stderr, "%s %s 中止：%s\n", method.isEmpty() ? "-" : method.constData(),
+                 target.isEmpty() ? "-" : target.constData(), qPrintable(detail));
+    if (!responseStarted) return reply(status, reason, detail.toUtf8() + '\n');
+    // 响应已经开始，无法再改状态码：不写结束分块直接关闭，客户端据此知道结果不完整
+    stage = Stage::Done;
+    close();
+}
+
+// 在工作线程中接管已接受的连接
+void startConnection(QObject *context, qintptr descriptor, bool isLocal) {
+    auto *connection = new Connection(context);
+    if (isLocal) {
+        auto *socket = new QLocalSocket(connection);
+        if (!socket->setSocketDescriptor(quintptr(descriptor))) {
+            std::fprintf(stderr, "无法接受连接：%s\n", qPrintable(socket->errorString()));
+            delete connection;
+            return;
+        }
+        socket->setReadBufferSize(kSocketReadBufferSize);
+        QObject::connect(socket, &QLocalSocket::disconnected, connection, [connection] { connection->closed(); });
+        connection->attach(socket, [socket] { socket->disconnectFromServer(); });
+    } else {
+        auto *socket = new QTcpSocket(connection);
+        if (!socket->setSocketDescriptor(descriptor)) {
+            std::fprintf(stderr, "无法接受连接：%s\n", qPrintable(socket->errorString()));
+            delete connection;
+            return;
+        }
+        socket->setReadBufferSize(kSocketReadBufferSize);
+        QObject::connect(socket, &QTcpSocket::disconnected, connection, [connection] { connection->closed(); });
+        connection->attach(socket, [socket] { socket->disconnectFromHost(); });
+    }
+}
+
+// path 是否为 Unix 域套接字文件；其他平台上本地服务名不对应文件，总是返回 true
+bool isSocketFile(const QString &path) {
+#if defined(Q_OS_UNIX)
+    struct stat st;
+    return ::lstat(QFile::encodeName(path).constData(), &st) == 0 && S_ISSOCK(st.st_mode);
+#else
+    Q_UNUSED(path);
+    return true;
+#endif
+}
+
+} // namespace
+
+AnonymizeService::AnonymizeService(int workers, QObject *parent) : QObject(parent) {
+    for (int i = 0; i < qMax(1, workers); ++i) {
+        auto *thread = new QThread(this);
+        auto *context = new QObject;
+        context->moveToThread(thread);
+        // 线程结束时在该线程中删除，其下的连接与套接字随之删除
+        connect(thread, &QThread::finished, context, &QObject::deleteLater);
+        thread->start();
+        threads.push_back(thread);
+        contexts.push_back(context);
+    }
+}
+
+AnonymizeService::~AnonymizeService() {
+    for (QThread *thread : threads) thread->quit();
+    for (QThread *thread : threads) thread->wait();
+}
+
+bool AnonymizeService::listen(const QString &address, QString *errorOut) {
+    if (address.startsWith("unix:")) {
+        const QString path = address.mid(5);
+        // 上次异常退出时留下的套接字文件会导致监听失败，只移除无人监听的套接字；
+        // 同名的普通文件等不动，由 listen() 报错
+        if (isSocketFile(path)) {
+            QLocalSocket probe;
+            probe.connectToServer(path);
+            if (probe.waitForConnected(200)) {
+                if (errorOut) *errorOut = "已有服务在 " + path + " 上监听";
+                return false;
+            }
+            QLocalServer::removeServer(path);
+        }
+        local = new LocalListener([this](quintptr descriptor) { dispatch(qintptr(descriptor), true); }, this);
+        local->setSocketOptions(QLocalServer::UserAccessOption);
+        if (local->listen(path)) return true;
+        if (errorOut) *errorOut = local->errorString();
+        return false;
+    }
+    bool ok = false;
+    const uint port = address.toUInt(&ok);
+    if (!ok || port > 65535) {
+        if (errorOut) *errorOut = "监听地址应为端口号或 unix:路径";
+        return false;
+    }
+    tcp = new TcpListener([this](qintptr descriptor) { dispatch(descriptor, false); }, this);
+    if (tcp->listen(QHostAddress::LocalHost, quint16(port))) return true;
+    if (errorOut) *errorOut = tcp->errorString();
+    return false;
+}
+
+QString AnonymizeService::listeningAddress() const {
+    if (local) return "unix:" + local->fullServerName();
+    if (tcp) return QString("127.0.0.1:%1").arg(tcp->serverPort());
+    return QString();
+}
+
+void AnonymizeService::dispatch(qintptr descriptor, bool isLocal) {
+    QObject *context = contexts[nextWorker++ % contexts.size()];
+    QMetaObject::invokeMethod(context, [context, descriptor, isLocal] { startConnection(context, descriptor, isLocal); },
+                              Qt::QueuedConnection);
+}
+
+} // namespace mcla
@@ -0,0 +1,41 @@
+#pragma once
+
+// ---------------------------- 脱敏服务 ----------------------------
+// 常驻进程，在本机端口（只监听 127.0.0.1）或 Unix 域套接字上接受 HTTP 上传的日志（原始或 gzip），
+// 边接收边把脱敏结果以分块响应传回，不等上传结束。规则集与一致化替换的编号表在所有请求间共用。
+// 两种监听方式都使用 HTTP/1.1：请求体以 Content-Length 或分块传输给出长度，客户端不必半关闭连接，
+// 可直接用 curl（--unix-socket）测试
+
+#include <QObject>
+#include <QString>
+
+#include <vector>
+
+class QLocalServer;
+class QTcpServer;
+class QThread;
+
+namespace mcla {
+
+class AnonymizeService : public QObject {
+public:
+    // 连接分配到 workers 个工作线程上处理，每个线程可同时处理多个连接
+    explicit AnonymizeService(int workers, QObject *parent = nullptr);
+    ~AnonymizeService() override;
+
+    // address 为端口号（监听 127.0.0.1）或 unix:路径（无人监听的同名套接字会被移除，其他同名文件不动）
+    bool listen(const QString &address, QString *errorOut);
+    // 实际监听的地址，用于提示
+    QString listeningAddress() const;
+
+private:
+    QTcpServer *tcp = nullptr;
+    QLocalServer *local = nullptr;
+    std::vector<QThread*> threads;
+    std::vector<QObject*> contexts;   // 各工作线程中的连接都以对应的对象为父对象
+    size_t nextWorker = 0;
+
+    void dispatch(qintptr descriptor, bool isLocal);
+};
+
+} // namespace mcla
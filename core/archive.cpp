@@ -0,0 +1,565 @@
+#include "archive.h"
+
+#include "logfile.h"
+#include "logsource.h"
+#include "textencoding.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QThreadPool>
+#include <QtEndian>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <vector>
+
+namespace mcla {
+
+constexpr qint64 kSniffSize = 64 << 10;
+
+ArchiveKind archiveKindOf(const QString &path) {
+    const QString lower = QFileInfo(path).fileName().toLower();
+    if (lower.endsWith(".zip")) return ArchiveKind::Zip;
+    if (lower.endsWith(".tar.gz")) return ArchiveKind::TarGz;
+    return ArchiveKind::None;
+}
+
+QString anonymizedArchiveName(const QString &fileName) {
+    for (const char *ext : { ".tar.gz", ".zip" }) {
+        if (fileName.endsWith(QLatin1String(ext), Qt::CaseInsensitive))
+            return fileName.chopped(int(qstrlen(ext))) + "_Anonymized" + fileName.right(int(qstrlen(ext)));
+    }
+    return fileName + "_Anonymized";
+}
+
+static bool copyBytes(QIODevice &from, QIODevice &to, qint64 n) {
+    char buf[64 << 10];
+    while (n > 0) {
+        const qint64 got = from.read(buf, qMin<qint64>(n, sizeof(buf)));
+        if (got <= 0 || to.write(buf, got) != got) return false;
+        n -= got;
+    }
+    return true;
+}
+
+static quint32 fileCrc32(const QString &path) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return 0;
+    char buf[64 << 10];
+    uLong crc = crc32(0, Z_NULL, 0);
+    qint64 got;
+    while ((got = f.read(buf, sizeof(buf))) > 0)
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(buf), static_cast<uInt>(got));
+    return static_cast<quint32>(crc);
+}
+
+static bool sniffText(QIODevice &dev) {
+    QByteArray head(kSniffSize, Qt::Uninitialized);
+    const qint64 got = readChunk(dev, head.data(), head.size());
+    if (got <= 0) return false;
+    head.truncate(got);
+    return looksLikeText(head);
+}
+
+// 单个条目的处理结果；transformed 为 false 表示非文本，原样保留
+struct RepackedEntry {
+    bool ok = false;
+    bool transformed = false;
+    QString partPath;
+    quint16 method = 0;
+    quint32 crc = 0;
+    qint64 compressedSize = 0;
+    qint64 uncompressedSize = 0;
+    QString error;
+};
+
+// 脱敏一个条目写到 partPath。opener 每次返回条目原始数据的新数据流；
+// .gz 条目解开后脱敏再压回 gzip；deflateForZip 时文本直接压成 zip 用的原始 deflate
+static RepackedEntry repackEntry(const std::function<std::unique_ptr<QIODevice>()> &opener, bool nestedGz,
+                                 const QString &partPath, bool deflateForZip, TaskProgress *progress) {
+    RepackedEntry r;
+    auto openText = [&]() -> std::unique_ptr<QIODevice> {
+        auto raw = opener();
+        if (!raw || !nestedGz) return raw;
+        return std::make_unique<InflateDevice>(std::move(raw), InflateDevice::Format::Gzip);
+    };
+
+    {
+        // 打不开（加密、不支持的压缩方式）或不是文本的条目都原样保留
+        auto probe = openText();
+        if (!probe || !sniffText(*probe)) { r.ok = true; return r; }
+    }
+
+    auto source = openText();
+    QFile part(partPath);
+    if (!source || !part.open(QIODevice::WriteOnly)) { r.error = "无法写入临时文件"; return r; }
+
+    bool ok;
+    if (nestedGz) {
+        DeflateDevice gz(&part, DeflateDevice::Format::Gzip);
+        ok = anonymizeStream(*source, gz, progress) && gz.finish();
+    } else if (deflateForZip) {
+        DeflateDevice raw(&part, DeflateDevice::Format::RawDeflate);
+        ok = anonymizeStream(*source, raw, progress) && raw.finish();
+        r.method = 8;
+        r.crc = raw.inputCrc();
+        r.uncompressedSize = raw.inputSize();
+    } else {
+        ok = anonymizeStream(*source, part, progress);
+    }
+    part.close();
+    if (!ok) {
+        if (progress && progress->isCancelled())
+            r.error = "已取消";
+        else
+            r.error = source->errorString().isEmpty() ? part.errorString() : source->errorString();
+        part.remove();
+        return r;
+    }
+
+    r.ok = true;
+    r.transformed = true;
+    r.partPath = partPath;
+    r.compressedSize = part.size();
+    if (r.method == 0) {
+        r.uncompressedSize = r.compressedSize;
+        if (deflateForZip) r.crc = fileCrc32(partPath);
+    }
+    return r;
+}
+
+static void putLe16(QByteArray &b, quint16 v) { char t[2]; qToLittleEndian(v, t); b.append(t, 2); }
+static void putLe32(QByteArray &b, quint32 v) { char t[4]; qToLittleEndian(v, t); b.append(t, 4); }
+static void putLe64(QByteArray &b, quint64 v) { char t[8]; qToLittleEndian(v, t); b.append(t, 8); }
+
+// 顺序写出 zip：条目大小写入前已知，一般不需要数据描述符；超出 32 位时自动使用 Zip64
+class ZipWriter {
+public:
+    explicit ZipWriter(QIODevice *dst) : out(dst) {}
+
+    // 写入条目头并从 data 复制 info.compressedSize 字节的（已压缩）数据。
+    // 保留 info.flags 中的加密位与压缩方式相关的位，只去掉数据描述符位（大小已写在条目头中）；
+    // 名字按 UTF-8 写出，含非 ASCII 字符时置 UTF-8 标志位
+    bool addEntry(const ZipEntryInfo &info, QIODevice &data) {
+        ZipEntryInfo e = info;
+        e.localHeaderOffset = offset;
+        const QByteArray name = e.name.toUtf8();
+        const bool ascii = std::none_of(name.begin(), name.end(), [](char ch) { return ch & 0x80; });
+        // 传统加密的条目以数据描述符位决定口令校验字节取自 CRC 还是修改时间，不能改动，数据之后照样写出描述符
+        const bool descriptor = (e.flags & 0x0009) == 0x0009;
+        if (!descriptor) e.flags &= ~0x0008;
+        if (!ascii) e.flags |= 0x0800;
+        if (e.extra.size() > 0xFFFF - 28) e.extra.clear();
+        const bool zip64 = e.compressedSize >= 0xFFFFFFFFu || e.uncompressedSize >= 0xFFFFFFFFu;
+
+        QByteArray h;
+        putLe32(h, 0x04034b50);
+        putLe16(h, zip64 ? 45 : 20);
+        putLe16(h, e.flags);
+        putLe16(h, e.method);
+        putLe16(h, e.dosTime);
+        putLe16(h, e.dosDate);
+        putLe32(h, e.crc);
+        putLe32(h, zip64 ? 0xFFFFFFFFu : quint32(e.compressedSize));
+        putLe32(h, zip64 ? 0xFFFFFFFFu : quint32(e.uncompressedSize));
+        putLe16(h, quint16(name.size()));
+        putLe16(h, quint16((zip64 ? 20 : 0) + e.extra.size()));
+        h.append(name);
+        if (zip64) {
+            putLe16(h, 0x0001);
+            putLe16(h, 16);
+            putLe64(h, e.uncompressedSize);
+            putLe64(h, e.compressedSize);
+        }
+        h.append(e.extra);
+        if (!put(h) || !copyBytes(data, *out, qint64(e.compressedSize))) return false;
+        offset += e.compressedSize;
+        if (descriptor) {
+            QByteArray d;
+            putLe32(d, 0x08074b50);
+            putLe32(d, e.crc);
+            if (zip64) {
+                putLe64(d, e.compressedSize);
+                putLe64(d, e.uncompressedSize);
+            } else {
+                putLe32(d, quint32(e.compressedSize));
+                putLe32(d, quint32(e.uncompressedSize));
+            }
+            if (!put(d)) return false;
+        }
+        entries.append(e);
+        return true;
+    }
+
+    // 写出中央目录与结尾记录
+    bool finish() {
+        const quint64 cdOffset = offset;
+        for (const ZipEntryInfo &e : entries) {
+            const QByteArray name = e.name.toUtf8();
+            const bool bigU = e.uncompressedSize >= 0xFFFFFFFFu;
+            const bool bigC = e.compressedSize >= 0xFFFFFFFFu;
+            const bool bigO = e.localHeaderOffset >= 0xFFFFFFFFu;
+            QByteArray extra;
+            if (bigU || bigC || bigO) {
+                putLe16(extra, 0x0001);
+                putLe16(extra, quint16(8 * (int(bigU) + int(bigC) + int(bigO))));
+                if (bigU) putLe64(extra, e.uncompressedSize);
+                if (bigC) putLe64(extra, e.compressedSize);
+                if (bigO) putLe64(extra, e.localHeaderOffset);
+            }
+            extra.append(e.extra);
+            QByteArray c;
+            putLe32(c, 0x02014b50);
+            putLe16(c, 45);
+            putLe16(c, bigU || bigC || bigO ? 45 : 20);
+            putLe16(c, e.flags);
+            putLe16(c, e.method);
+            putLe16(c, e.dosTime);
+            putLe16(c, e.dosDate);
+            putLe32(c, e.crc);
+            putLe32(c, bigC ? 0xFFFFFFFFu : quint32(e.compressedSize));
+            putLe32(c, bigU ? 0xFFFFFFFFu : quint32(e.uncompressedSize));
+            putLe16(c, quint16(name.size()));
+            putLe16(c, quint16(extra.size()));
+            putLe16(c, 0);
+            putLe16(c, 0);
+            putLe16(c, 0);
+            putLe32(c, 0);
+            putLe32(c, bigO ? 0xFFFFFFFFu : quint32(e.localHeaderOffset));
+            c.append(name);
+            c.append(extra);
+            if (!put(c)) return false;
+        }
+        const quint64 cdSize = offset - cdOffset;
+        const quint64 count = quint64(entries.size());
+
+        QByteArray tail;
+        if (count >= 0xFFFF || cdOffset >= 0xFFFFFFFFu || cdSize >= 0xFFFFFFFFu) {
+            const quint64 z64Offset = offset;
+            putLe32(tail, 0x06064b50);
+            putLe64(tail, 44);
+            putLe16(tail, 45);
+            putLe16(tail, 45);
+            putLe32(tail, 0);
+            putLe32(tail, 0);
+            putLe64(tail, count);
+            putLe64(tail, count);
+            putLe64(tail, cdSize);
+            putLe64(tail, cdOffset);
+            putLe32(tail, 0x07064b50);
+            putLe32(tail, 0);
+            putLe64(tail, z64Offset);
+            putLe32(tail, 1);
+        }
+        putLe32(tail, 0x06054b50);
+        putLe16(tail, 0);
+        putLe16(tail, 0);
+        putLe16(tail, quint16(qMin<quint64>(count, 0xFFFF)));
+        putLe16(tail, quint16(qMin<quint64>(count, 0xFFFF)));
+        putLe32(tail, quint32(qMin<quint64>(cdSize, 0xFFFFFFFFu)));
+        putLe32(tail, quint32(qMin<quint64>(cdOffset, 0xFFFFFFFFu)));
+        putLe16(tail, 0);
+        return put(tail);
+    }
+
+private:
+    QIODevice *out;
+    quint64 offset = 0;
+    QList<ZipEntryInfo> entries;
+
+    bool put(const QByteArray &b) {
+        if (out->write(b) != b.size()) return false;
+        offset += quint64(b.size());
+        return true;
+    }
+};
+
+// 数值写成定宽八进制（末尾留 NUL），放不下时改用 GNU base-256
+static void putTarNumber(char *field, int width, quint64 v) {
+    if (v < (quint64(1) << (3 * (width - 1)))) {
+        for (int i = width - 2; i >= 0; --i, v >>= 3) field[i] = char('0' + (v & 7));
+        field[width - 1] = '\0';
+        return;
+    }
+    for (int i = width - 1; i > 0; --i, v >>= 8) field[i] = char(v & 0xFF);
+    field[0] = char(0x80);
+}
+
+static QByteArray tarHeaderBlock(const QByteArray &name, qint64 size, char type, quint32 mode, qint64 mtime) {
+    QByteArray h(512, '\0');
+    char *p = h.data();
+    std::memcpy(p, name.constData(), size_t(qMin<qsizetype>(name.size(), 100)));
+    putTarNumber(p + 100, 8, mode);
+    putTarNumber(p + 108, 8, 0);
+    putTarNumber(p + 116, 8, 0);
+    putTarNumber(p + 124, 12, quint64(size));
+    putTarNumber(p + 136, 12, quint64(mtime));
+    p[156] = type;
+    std::memcpy(p + 257, "ustar", 6);
+    std::memcpy(p + 263, "00", 2);
+    std::memset(p + 148, ' ', 8);
+    unsigned sum = 0;
+    for (int i = 0; i < 512; ++i) sum += static_cast<uchar>(p[i]);
+    putTarNumber(p + 148, 7, sum);
+    p[155] = ' ';
+    return h;
+}
+
+static bool writeTarPadding(QIODevice &out, qint64 size) {
+    const qint64 pad = (512 - size % 512) % 512;
+    return pad == 0 || out.write(QByteArray(pad, '\0')) == pad;
+}
+
+// GNU 长文件名（type 'L'）或长链接目标（type 'K'）条目
+static bool writeTarLongField(QIODevice &out, const QByteArray &value, char type) {
+    const QByteArray field = value + '\0';
+    return out.write(tarHeaderBlock("././@LongLink", field.size(), type, 0644, 0)) == 512
+        && out.write(field) == field.size() && writeTarPadding(out, field.size());
+}
+
+// 写出条目头；名字超过 100 字节时先写一个 GNU 长文件名条目。
+// 目录、链接等非普通文件写回原始条目头，只在名字或链接目标放不下时补上长名条目
+static bool writeTarHeader(QIODevice &out, const TarEntryInfo &e, qint64 size) {
+    const QByteArray name = e.name.toUtf8();
+    if (name.size() > 100 && !writeTarLongField(out, name, 'L')) return false;
+    if (!e.rawHeader.isEmpty()) {
+        const QByteArray link = e.linkName.toUtf8();
+        if (link.size() > 100 && !writeTarLongField(out, link, 'K')) return false;
+        return out.write(e.rawHeader) == 512;
+    }
+    return out.write(tarHeaderBlock(name, size, '0', e.mode, e.mtime)) == 512;
+}
+
+static bool isGzName(const QString &name) {
+    return name.endsWith(".gz", Qt::CaseInsensitive);
+}
+
+static bool repackZip(const QString &zipPath, QIODevice &out, int jobs, const QTemporaryDir &staging, QString *errorOut,
+                      TaskProgress *progress) {
+    QList<ZipEntryInfo> entries;
+    {
+        QFile f(zipPath);
+        if (!f.open(QIODevice::ReadOnly)) { if (errorOut) *errorOut = f.errorString(); return false; }
+        // 目录条目一并保留（原样复制），空目录不会丢失
+        if (!readZipDirectory(f, entries, errorOut, true)) return false;
+    }
+
+    const qsizetype n = entries.size();
+    std::vector<std::promise<RepackedEntry>> promises(static_cast<size_t>(n));
+    std::vector<std::future<RepackedEntry>> results;
+    for (auto &pr : promises) results.push_back(pr.get_future());
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs);
+    qsizetype submitted = 0;
+    auto submitUpTo = [&](qsizetype limit) {
+        for (; submitted < n && submitted < limit; ++submitted) {
+            const qsizetype i = submitted;
+            pool.start([&, i] {
+                const ZipEntryInfo &e = entries[i];
+                auto opener = [&] { return openZipEntry(zipPath, e, nullptr); };
+                promises[size_t(i)].set_value(repackEntry(opener, isGzName(e.name), staging.filePath(QString::number(i)), true, progress));
+            });
+        }
+    };
+
+    ZipWriter writer(&out);
+    bool ok = true;
+    for (qsizetype i = 0; i < n && ok; ++i) {
+        if (progress && progress->isCancelled()) {
+            if (errorOut) *errorOut = "已取消";
+            ok = false;
+            break;
+        }
+        submitUpTo(i + 2 * jobs);
+        RepackedEntry r = results[size_t(i)].get();
+        const ZipEntryInfo &e = entries[i];
+        if (!r.ok) {
+            if (errorOut) *errorOut = e.name + "：" + r.error;
+            ok = false;
+        } else if (r.transformed) {
+            ZipEntryInfo info = e;
+            // 重新压缩的数据：原来的压缩选项位不再适用
+            info.flags = 0;
+            info.method = r.method;
+            info.crc = r.crc;
+            info.compressedSize = quint64(r.compressedSize);
+            info.uncompressedSize = quint64(r.uncompressedSize);
+            QFile part(r.partPath);
+            ok = part.open(QIODevice::ReadOnly) && writer.addEntry(info, part);
+            part.close();
+            part.remove();
+        } else {
+            // 非文本条目：压缩数据原样复制，不重新压缩
+            QFile src(zipPath);
+            ok = src.open(QIODevice::ReadOnly) && seekZipEntryData(src, e) && writer.addEntry(e, src);
+        }
+        if (!ok && errorOut && errorOut->isEmpty()) *errorOut = "写入失败：" + e.name;
+    }
+    pool.waitForDone();
+    return ok && writer.finish();
+}
+
+static bool repackTarGz(const QString &tgzPath, QIODevice &out, int jobs, const QTemporaryDir &staging, QString *errorOut,
+                        TaskProgress *progress) {
+    auto reader = openTarGz(tgzPath, errorOut);
+    if (!reader) return false;
+
+    DeflateDevice gz(&out, DeflateDevice::Format::Gzip);
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs);
+
+    struct Pending {
+        TarEntryInfo info;
+        QString spoolPath;
+        std::future<RepackedEntry> result;
+    };
+    std::deque<Pending> pending;
+    bool ok = true;
+
+    // 按顺序写出已完成的条目；队列超过 maxPending 时等待队首完成
+    auto flush = [&](size_t maxPending) {
+        while (ok && !pending.empty()) {
+            Pending &p = pending.front();
+            if (pending.size() <= maxPending && p.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                break;
+            RepackedEntry r = p.result.get();
+            if (!r.ok) {
+                if (errorOut) *errorOut = p.info.name + "：" + r.error;
+                ok = false;
+                break;
+            }
+            QFile data(r.transformed ? r.partPath : p.spoolPath);
+            ok = data.open(QIODevice::ReadOnly) && writeTarHeader(gz, p.info, data.size())
+                 && copyBytes(data, gz, data.size()) && writeTarPadding(gz, data.size());
+            if (!ok && errorOut) *errorOut = "写入失败：" + p.info.name;
+            data.close();
+            QFile::remove(p.spoolPath);
+            if (r.transformed) QFile::remove(r.partPath);
+            pending.pop_front();
+        }
+    };
+
+    TarEntryInfo e;
+    for (int i = 0; ok && reader->next(e, true); ++i) {
+        if (progress && progress->isCancelled()) {
+            if (errorOut) *errorOut = "已取消";
+            ok = false;
+            break;
+        }
+        // tar 只能顺序读取：先把条目解到临时文件，再交给线程池
+        const QString spoolPath = staging.filePath(QString::number(i) + ".in");
+        QFile spool(spoolPath);
+        if (!spool.open(QIODevice::WriteOnly)) { if (errorOut) *errorOut = spool.errorString(); ok = false; break; }
+        char buf[64 << 10];
+        qint64 got;
+        while ((got = reader->readEntryData(buf, sizeof(buf))) > 0) {
+            if (spool.write(buf, got) != got) { got = -1; break; }
+        }
+        spool.close();
+        if (got < 0) { if (errorOut) *errorOut = reader->errorString(); ok = false; break; }
+
+        auto promise = std::make_shared<std::promise<RepackedEntry>>();
+        pending.push_back({ e, spoolPath, promise->get_future() });
+        if (!e.isRegular()) {
+            // 目录、链接等条目连同数据原样写回
+            RepackedEntry kept;
+            kept.ok = true;
+            promise->set_value(kept);
+            flush(size_t(2 * jobs));
+            continue;
+        }
+        const QString partPath = staging.filePath(QString::number(i) + ".out");
+        const bool nestedGz = isGzName(e.name);
+        pool.start([promise, spoolPath, partPath, nestedGz, progress] {
+            auto opener = [&]() -> std::unique_ptr<QIODevice> {
+                auto f = std::make_unique<QFile>(spoolPath);
+                if (!f->open(QIODevice::ReadOnly)) return nullptr;
+                return f;
+            };
+            promise->set_value(repackEntry(opener, nestedGz, partPath, false, progress));
+        });
+        flush(size_t(2 * jobs));
+    }
+    if (ok && !reader->errorString().isEmpty()) {
+        if (errorOut) *errorOut = reader->errorString();
+        ok = false;
+    }
+    flush(0);
+    pool.waitForDone();
+    return ok && gz.write(QByteArray(1024, '\0')) == 1024 && gz.finish();
+}
+
+bool anonymizeArchive(const QString &archivePath, const QString &targetPath, int jobs, QString *errorOut,
+                      TaskProgress *progress) {
+    const ArchiveKind kind = archiveKindOf(archivePath);
+    if (kind == ArchiveKind::None) {
+        if (errorOut) *errorOut = "不是受支持的压缩包";
+        return false;
+    }
+    QTemporaryDir staging;
+    QSaveFile out(targetPath);
+    if (!staging.isValid() || !out.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = staging.isValid() ? out.errorString() : "无法创建临时目录";
+        return false;
+    }
+    jobs = qMax(1, jobs);
+    const bool ok = kind == ArchiveKind::Zip ? repackZip(archivePath, out, jobs, staging, errorOut, progress)
+                                             : repackTarGz(archivePath, out, jobs, staging, errorOut, progress);
+    if (!ok) {
+        out.cancelWriting();
+        return false;
+    }
+    return out.commit();
+}
+
+bool packFile(const QString &sourcePath, const QString &entryName, ArchiveKind kind, const QString &targetPath,
+              QString *errorOut) {
+    QFile in(sourcePath);
+    QSaveFile out(targetPath);
+    if (kind == ArchiveKind::None || !in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = kind == ArchiveKind::None ? "不是受支持的压缩包" : in.isOpen() ? out.errorString() : in.errorString();
+        return false;
+    }
+    const QDateTime now = QDateTime::currentDateTime();
+    bool ok;
+    if (kind == ArchiveKind::Zip) {
+        // 先压缩到临时文件，得到压缩后的大小与 CRC 后再写条目头
+        QTemporaryFile deflated;
+        ok = deflated.open();
+        ZipEntryInfo e;
+        if (ok) {
+            DeflateDevice raw(&deflated, DeflateDevice::Format::RawDeflate);
+            ok = copyBytes(in, raw, in.size()) && raw.finish();
+            e.crc = raw.inputCrc();
+            e.uncompressedSize = quint64(raw.inputSize());
+        }
+        e.name = entryName;
+        e.method = 8;
+        e.dosDate = quint16(((now.date().year() - 1980) << 9) | (now.date().month() << 5) | now.date().day());
+        e.dosTime = quint16((now.time().hour() << 11) | (now.time().minute() << 5) | (now.time().second() / 2));
+        e.compressedSize = quint64(deflated.size());
+        ZipWriter zip(&out);
+        ok = ok && deflated.seek(0) && zip.addEntry(e, deflated) && zip.finish();
+    } else {
+        DeflateDevice gz(&out, DeflateDevice::Format::Gzip);
+        const TarEntryInfo e{ entryName, in.size(), 0644, now.toSecsSinceEpoch() };
+        ok = writeTarHeader(gz, e, e.size) && copyBytes(in, gz, e.size) && writeTarPadding(gz, e.size)
+             && gz.write(QByteArray(1024, '\0')) == 1024 && gz.finish();
+    }
+    if (!ok) {
+        if (errorOut) *errorOut = out.error() != QFileDevice::NoError ? out.errorString() : "压缩失败";
+        out.cancelWriting();
+        return false;
+    }
+    return out.commit();
+}
+
+} // namespace mcla
@@ -0,0 +1,28 @@
+#pragma once
+
+// ---------------------------- 整包脱敏 ----------------------------
+// 把 zip / tar.gz 中所有文本条目（含嵌套的 .gz）并行脱敏，按原顺序重新打包成同类型的压缩包。
+// 每个条目的结果先暂存在临时目录，写入新包后立即删除；同时在处理中的条目数有上限
+
+#include "progress.h"
+
+#include <QString>
+
+namespace mcla {
+
+enum class ArchiveKind { None, Zip, TarGz };
+
+ArchiveKind archiveKindOf(const QString &path);
+
+// a.zip → a_Anonymized.zip，a.tar.gz → a_Anonymized.tar.gz
+QString anonymizedArchiveName(const QString &fileName);
+
+// 把整个压缩包脱敏后写成同类型的新压缩包（原子替换目标文件）。progress 按脱敏的文本字节数累加
+bool anonymizeArchive(const QString &archivePath, const QString &targetPath, int jobs, QString *errorOut,
+                      TaskProgress *progress = nullptr);
+
+// 把一个文件打包成只含这一个条目（名为 entryName）的 zip（deflate）或 tar.gz，用于生成测试语料
+bool packFile(const QString &sourcePath, const QString &entryName, ArchiveKind kind, const QString &targetPath,
+              QString *errorOut);
+
+} // namespace mcla
@@ -0,0 +1,150 @@
+#include "batch.h"
+
+#include "archive.h"
+#include "contenthash.h"
+#include "exportcache.h"
+#include "logfile.h"
+#include "logsource.h"
+#include "redactor.h"
+#include "resultcache.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+
+namespace mcla {
+
+// 日志的压缩比通常在 10 倍左右
+constexpr qint64 kCompressionRatioEstimate = 10;
+
+bool isBatchCandidate(const QString &fileName) {
+    if (fileName.contains("_Anonymized")) return false;
+    const QString lower = fileName.toLower();
+    return lower.contains(".log") || lower.endsWith(".txt") || lower.endsWith(".gz") || lower.endsWith(".zip");
+}
+
+QStringList expandBatchInputs(const QStringList &inputs, QStringList *relativeDirsOut, QStringList *missingOut,
+                              const QString &excludeDir) {
+    const QString excluded = excludeDir.isEmpty() ? QString() : QDir(excludeDir).absolutePath() + "/";
+    QStringList files;
+    for (const QString &in : inputs) {
+        QFileInfo fi(in);
+        if (fi.isDir()) {
+            QDir root(fi.absoluteFilePath());
+            QDirIterator it(root.absolutePath(), QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                const QString file = it.next();
+                if (!isBatchCandidate(it.fileName())) continue;
+                if (!excluded.isEmpty() && file.startsWith(excluded)) continue;
+                files << file;
+                if (relativeDirsOut) *relativeDirsOut << root.relativeFilePath(QFileInfo(file).absolutePath());
+            }
+        } else if (fi.isFile()) {
+            files << fi.absoluteFilePath();
+            if (relativeDirsOut) *relativeDirsOut << QString();
+        } else if (missingOut) {
+            *missingOut << in;
+        }
+    }
+    return files;
+}
+
+qint64 estimatedLoadBytes(const QFileInfo &fi) {
+    const bool compressed = archiveKindOf(fi.fileName()) != ArchiveKind::None
+                            || fi.fileName().endsWith(".gz", Qt::CaseInsensitive);
+    return compressed ? fi.size() * kCompressionRatioEstimate : fi.size();
+}
+
+// 普通文件与 .gz 的输出文件名，与读取时的显示名一致（.gz 去掉后缀）
+static QString plainTargetName(const QFileInfo &fi) {
+    QString base = fi.fileName();
+    if (base.endsWith(".gz", Qt::CaseInsensitive)) base.chop(3);
+    return anonymizedFileName(base.isEmpty() ? fi.completeBaseName() + ".txt" : base);
+}
+
+QString batchTargetName(const QString &input) {
+    const QFileInfo fi(input);
+    return archiveKindOf(input) != ArchiveKind::None ? anonymizedArchiveName(fi.fileName()) : plainTargetName(fi);
+}
+
+QString numberedTargetName(const QString &name, int n) {
+    static const QString marker = QStringLiteral("_Anonymized");
+    const QString number = QString(" (%1)").arg(n);
+    const qsizetype at = name.lastIndexOf(marker);
+    if (at < 0) return name + number;
+    return QString(name).insert(at + marker.size(), number);
+}
+
+static QString anonymizeArchiveJob(const BatchJob &job, const QString &target, TaskProgress &stats,
+                                   RunMetrics &metrics, QElapsedTimer &timer) {
+    QString error;
+    if (!anonymizeArchive(job.input, target, job.innerJobs, &error, &stats)) return error;
+    metrics.add("archive", timer.nsecsElapsed(), QFileInfo(job.input).size(), QFileInfo(target).size());
+    return QString();
+}
+
+static QString anonymizeFileJob(const BatchJob &job, const QString &target, TaskProgress &stats,
+                                RunMetrics &metrics, QElapsedTimer &timer) {
+    QFileInfo fi(job.input);
+    // 超过内存上限的文件与大文件一样流式处理，内存占用只取决于块大小
+    if (shouldStream(fi) || (job.memoryLimit > 0 && estimatedLoadBytes(fi) > job.memoryLimit)) {
+        QString error;
+        auto source = openLogSource(job.input, nullptr, &error);
+        if (!source) return error;
+        if (!anonymizeDeviceToFile(*source, target, &stats)) {
+            return stats.isCancelled() ? QString("已取消") : "流式处理失败：" + source->errorString();
+        }
+        metrics.add("stream", timer.nsecsElapsed(), fi.size(), QFileInfo(target).size());
+        return QString();
+    }
+
+    LoadedLog log = loadLogFile(job.input);
+    if (log.bytes.isEmpty()) return log.error;
+    metrics.add("load", timer.nsecsElapsed() - log.detectNs, fi.size(), log.bytes.size());
+    metrics.add("detect", log.detectNs, log.bytes.size());
+    RedactedLog redacted;
+    timer.restart();
+    if (!redactBytes(log.bytes, log.encoding.working(), redacted, &stats, job.innerJobs)) return "已取消";
+    metrics.add("redact", timer.nsecsElapsed(), log.bytes.size(), redacted.outputSize(log.bytes.size()));
+    timer.restart();
+    if (!writeRedactedFile(target, log.bytes, redacted, log.encoding)) return "无法写入 " + target;
+    metrics.add("write", timer.nsecsElapsed(), redacted.outputSize(log.bytes.size()), QFileInfo(target).size());
+    return QString();
+}
+
+QString runBatchJob(const BatchJob &job, TaskProgress &stats, RunMetrics &metrics, QString *targetOut) {
+    QFileInfo fi(job.input);
+    if (!QDir().mkpath(job.outputDir)) return "无法创建输出目录 " + job.outputDir;
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool archive = archiveKindOf(job.input) != ArchiveKind::None;
+    const QString target = *targetOut = job.outputDir + "/"
+                                        + (job.targetName.isEmpty() ? batchTargetName(job.input) : job.targetName);
+
+    // 结果缓存：按源文件原样（压缩文件不解压）的哈希查找，命中时复制上次的结果
+    const ResultCachePtr cache = activeResultCache();
+    QString cacheKey;
+    if (cache) {
+        quint64 hash = 0;
+        if (!hashFile(job.input, &hash)) return "无法读取 " + job.input;
+        cacheKey = ResultCache::key(hash, *activeRuleSet(), archive ? CachedResult::Archive : CachedResult::Output);
+        std::array<qint64, kMaxRules> cachedHits{};
+        const QString cached = cache->lookup(cacheKey, &cachedHits);
+        if (!cached.isEmpty() && copyToUserFile(cached, target, nullptr)) {
+            stats.addHits(cachedHits);
+            metrics.add("cache", timer.nsecsElapsed(), fi.size(), QFileInfo(target).size());
+            return QString();
+        }
+        metrics.add("hash", timer.nsecsElapsed(), fi.size());
+        timer.restart();
+    }
+    // 本文件的命中次数另外记下，随结果放入缓存
+    TaskProgress jobStats(&stats);
+    const QString error = archive ? anonymizeArchiveJob(job, target, jobStats, metrics, timer)
+                                  : anonymizeFileJob(job, target, jobStats, metrics, timer);
+    if (error.isEmpty() && cache) cache->insert(cacheKey, target, jobStats.hitCounts());
+    return error;
+}
+
+} // namespace mcla
@@ -0,0 +1,49 @@
+#pragma once
+
+// ---------------------------- 批量处理 ----------------------------
+// 多个文件的处理：展开输入的文件与目录，逐个文件脱敏写到输出目录。命令行批处理与界面中的文件队列共用
+
+#include "metrics.h"
+#include "progress.h"
+
+#include <QFileInfo>
+#include <QString>
+#include <QStringList>
+
+namespace mcla {
+
+struct BatchJob {
+    QString input;
+    QString outputDir;
+    // 输出文件名，为空时取 batchTargetName(input)；同一输出目录中名字相同的文件由调用方编号区分
+    QString targetName;
+    // 单个文件内部的并行线程数：压缩包的条目并行处理，大的普通文件分段并行扫描
+    int innerJobs = 1;
+    // 整体载入内存的上限（见 estimatedLoadBytes），超过的文件改为流式处理；0 表示不限制
+    qint64 memoryLimit = 0;
+};
+
+// 目录中参与批处理的文件：日志、文本及压缩包（含 latest.log.1 这类轮转名），已脱敏的输出（名字含 _Anonymized）除外
+bool isBatchCandidate(const QString &fileName);
+
+// 展开输入：文件原样保留，目录递归遍历其中参与批处理的文件。
+// relativeDirsOut 为每个文件所在目录相对于输入目录的路径（输入本身是文件时为空），missingOut 为不存在的输入；
+// excludeDir 下的文件（输出目录位于输入目录之中时）不参与遍历
+QStringList expandBatchInputs(const QStringList &inputs, QStringList *relativeDirsOut = nullptr,
+                              QStringList *missingOut = nullptr, const QString &excludeDir = QString());
+
+// 输出文件名：压缩包为 xxx_Anonymized.zip / .tar.gz，普通文件与 .gz 为解压后的名字加 _Anonymized（x.log 与 x.log.gz 相同）
+QString batchTargetName(const QString &input);
+
+// 同名输出的第 n 个：“ (n)”插在 _Anonymized 之后、已知后缀之前，如 x_Anonymized (2).log、
+// x_Anonymized (2).tar.gz；没有后缀时加在末尾，不留多余的点
+QString numberedTargetName(const QString &name, int n);
+
+// 整体载入处理时大约占用的内存：.gz 与压缩包按解压后约为 10 倍估计，普通文件按文件大小
+qint64 estimatedLoadBytes(const QFileInfo &fi);
+
+// 处理单个文件，失败时返回错误说明；进度与各规则的命中次数累加到 stats，各阶段的耗时累加到 metrics，
+// 输出文件的路径写到 targetOut
+QString runBatchJob(const BatchJob &job, TaskProgress &stats, RunMetrics &metrics, QString *targetOut);
+
+} // namespace mcla
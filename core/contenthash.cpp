@@ -0,0 +1,136 @@
+#include "contenthash.h"
+
+#include "logsource.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace mcla {
+
+static constexpr quint64 kPrime1 = 0x9E3779B185EBCA87ull;
+static constexpr quint64 kPrime2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr quint64 kPrime3 = 0x165667B19E3779F9ull;
+static constexpr quint64 kPrime4 = 0x85EBCA77C2B2AE63ull;
+static constexpr quint64 kPrime5 = 0x27D4EB2F165667C5ull;
+
+static inline quint64 rotl(quint64 x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline quint64 read64(const unsigned char *p) {
+    return qFromLittleEndian<quint64>(p);
+}
+
+static inline quint64 round64(quint64 acc, quint64 input) {
+    acc += input * kPrime2;
+    return rotl(acc, 31) * kPrime1;
+}
+
+static inline quint64 mergeRound(quint64 h, quint64 acc) {
+    h ^= round64(0, acc);
+    return h * kPrime1 + kPrime4;
+}
+
+// 每 32 字节为一组，分别累加到 4 个通道
+static const unsigned char *consumeStripes(quint64 acc[4], const unsigned char *p, const unsigned char *end) {
+    quint64 a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3];
+    for (; end - p >= 32; p += 32) {
+        a0 = round64(a0, read64(p));
+        a1 = round64(a1, read64(p + 8));
+        a2 = round64(a2, read64(p + 16));
+        a3 = round64(a3, read64(p + 24));
+    }
+    acc[0] = a0; acc[1] = a1; acc[2] = a2; acc[3] = a3;
+    return p;
+}
+
+ContentHasher::ContentHasher(quint64 seed)
+    : seed(seed), acc{ seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1 } {}
+
+void ContentHasher::add(QByteArrayView data) {
+    auto p = reinterpret_cast<const unsigned char *>(data.data());
+    const unsigned char *end = p + data.size();
+    total += quint64(data.size());
+    if (pendingSize > 0) {
+        const int take = int(qMin<qsizetype>(32 - pendingSize, end - p));
+        std::memcpy(pending + pendingSize, p, size_t(take));
+        pendingSize += take;
+        p += take;
+        if (pendingSize < 32) return;
+        consumeStripes(acc, pending, pending + 32);
+        pendingSize = 0;
+    }
+    p = consumeStripes(acc, p, end);
+    pendingSize = int(end - p);
+    std::memcpy(pending, p, size_t(pendingSize));
+}
+
+quint64 ContentHasher::result() const {
+    quint64 h;
+    if (total >= 32) {
+        h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+        for (quint64 a : acc) h = mergeRound(h, a);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += total;
+
+    const unsigned char *p = pending;
+    const unsigned char *end = pending + pendingSize;
+    for (; end - p >= 8; p += 8) {
+        h ^= round64(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (end - p >= 4) {
+        h ^= quint64(qFromLittleEndian<quint32>(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= *p * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+quint64 contentHash(QByteArrayView data, quint64 seed) {
+    ContentHasher hasher(seed);
+    hasher.add(data);
+    return hasher.result();
+}
+
+bool hashFile(const QString &path, quint64 *hashOut, TaskProgress *progress) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    ContentHasher hasher;
+    // 能映射时直接在映射上计算，否则分块读取
+    const qint64 size = f.size();
+    if (const uchar *mapped = size > 0 ? f.map(0, size) : nullptr) {
+        for (qint64 pos = 0; pos < size; pos += kStreamChunkSize) {
+            const qint64 n = qMin<qint64>(kStreamChunkSize, size - pos);
+            hasher.add(QByteArrayView(reinterpret_cast<const char *>(mapped) + pos, n));
+            if (progress && !progress->advance(n)) return false;
+        }
+    } else {
+        QByteArray buf(kStreamChunkSize, Qt::Uninitialized);
+        for (;;) {
+            const qint64 got = readChunk(f, buf.data(), buf.size());
+            if (got < 0) return false;
+            if (got == 0) break;
+            hasher.add(QByteArrayView(buf.constData(), got));
+            if (progress && !progress->advance(got)) return false;
+        }
+    }
+    *hashOut = hasher.result();
+    return true;
+}
+
+} // namespace mcla
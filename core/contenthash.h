@@ -0,0 +1,35 @@
+#pragma once
+
+// ---------------------------- 内容哈希 ----------------------------
+// 64 位非加密哈希（XXH64 算法，每周期处理 32 字节，速度接近内存带宽），用于结果缓存的键与规则集的版本。
+// 结果与平台无关，可以保存到磁盘
+
+#include "progress.h"
+
+#include <QByteArrayView>
+#include <QString>
+
+namespace mcla {
+
+// 分块计算：依次 add 的结果与对拼接后的数据一次计算相同
+class ContentHasher {
+public:
+    explicit ContentHasher(quint64 seed = 0);
+
+    void add(QByteArrayView data);
+    quint64 result() const;
+
+private:
+    quint64 seed;
+    quint64 acc[4];
+    quint64 total = 0;
+    unsigned char pending[32];
+    int pendingSize = 0;
+};
+
+quint64 contentHash(QByteArrayView data, quint64 seed = 0);
+
+// 文件原样（压缩文件不解压）的哈希；progress 按读取的字节数累加，读取失败或被取消时返回 false
+bool hashFile(const QString &path, quint64 *hashOut, TaskProgress *progress = nullptr);
+
+} // namespace mcla
@@ -0,0 +1,127 @@
+#include "exportcache.h"
+
+#include "logsource.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+namespace mcla {
+
+ExportArtifact ExportArtifact::capture(const QString &path) {
+    const QFileInfo fi(path);
+    if (!fi.isFile()) return {};
+    return { fi.absoluteFilePath(), fi.size(), fi.lastModified() };
+}
+
+bool ExportArtifact::isValid() const {
+    if (path.isEmpty()) return false;
+    const QFileInfo fi(path);
+    return fi.isFile() && fi.size() == size && fi.lastModified() == modified;
+}
+
+// 在 target（不能已存在）建立 source 的硬链接，两者须在同一文件系统上
+static bool hardLink(const QString &source, const QString &target) {
+#if defined(Q_OS_WIN)
+    const QString to = QDir::toNativeSeparators(QFileInfo(target).absoluteFilePath());
+    const QString from = QDir::toNativeSeparators(QFileInfo(source).absoluteFilePath());
+    return CreateHardLinkW(reinterpret_cast<LPCWSTR>(to.utf16()), reinterpret_cast<LPCWSTR>(from.utf16()), nullptr);
+#elif defined(Q_OS_UNIX)
+    return ::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(target);
+    return false;
+#endif
+}
+
+// 由内核完成复制，数据不经过用户态：支持的文件系统上让 out 与 in 共享数据块（reflink），
+// 否则用 copy_file_range。返回已复制的字节数，之后的部分由调用方接着普通复制
+static qint64 copyInKernel(QFile &in, QFileDevice &out, qint64 size) {
+#if defined(Q_OS_LINUX)
+#ifdef FICLONE
+    if (::ioctl(out.handle(), FICLONE, in.handle()) == 0) return size;
+#endif
+    qint64 done = 0;
+    while (done < size) {
+        const ssize_t n = ::copy_file_range(in.handle(), nullptr, out.handle(), nullptr, size_t(size - done), 0);
+        if (n <= 0) break;
+        done += n;
+    }
+    return done;
+#else
+    Q_UNUSED(in);
+    Q_UNUSED(out);
+    Q_UNUSED(size);
+    return 0;
+#endif
+}
+
+// 复制到同目录的临时文件，完成后替换 target
+static bool copyFileData(const QString &source, const QString &target, QString *errorOut) {
+    QFile in(source);
+    if (!in.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = in.errorString();
+        return false;
+    }
+    QSaveFile out(target);
+    if (!out.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = out.errorString();
+        return false;
+    }
+    const qint64 size = in.size();
+    const qint64 shared = copyInKernel(in, out, size);
+    bool ok = in.seek(shared) && out.seek(shared);
+    QByteArray buf(kStreamChunkSize, Qt::Uninitialized);
+    while (ok) {
+        const qint64 got = readChunk(in, buf.data(), buf.size());
+        if (got <= 0) {
+            ok = got == 0;
+            break;
+        }
+        ok = out.write(buf.constData(), got) == got;
+    }
+    if (!ok) {
+        if (errorOut) *errorOut = in.error() != QFileDevice::NoError ? in.errorString() : out.errorString();
+        out.cancelWriting();
+        return false;
+    }
+    if (out.commit()) return true;
+    if (errorOut) *errorOut = out.errorString();
+    return false;
+}
+
+bool placeFileCopy(const QString &source, const QString &target, QString *errorOut) {
+    const QFileInfo si(source), ti(target);
+    if (ti.exists() && si.canonicalFilePath() == ti.canonicalFilePath()) return true;
+    // 硬链接不能覆盖已有的文件：先链接到同目录的临时名，再换成目标
+    const QString linkPath = ti.absoluteFilePath() + ".mcla-link";
+    QFile::remove(linkPath);
+    if (hardLink(source, linkPath)) {
+        if ((!ti.exists() || QFile::remove(target)) && QFile::rename(linkPath, target)) return true;
+        QFile::remove(linkPath);
+    }
+    return copyFileData(source, target, errorOut);
+}
+
+bool copyToUserFile(const QString &source, const QString &target, QString *errorOut) {
+    const QFileInfo si(source), ti(target);
+    if (ti.exists() && si.canonicalFilePath() == ti.canonicalFilePath()) return true;
+    return copyFileData(source, target, errorOut);
+}
+
+} // namespace mcla
@@ -0,0 +1,30 @@
+#pragma once
+
+// ---------------------------- 导出缓存 ----------------------------
+// 脱敏结果只写出一次，之后的拖拽导出与“导出文件”都复用这个文件。
+// 交给用户的文件只用共享数据块（Linux 上的 reflink / copy_file_range）或普通复制，
+// 硬链接只用于程序私有的文件，否则改动其中一个会连带改动另一个
+
+#include <QDateTime>
+#include <QString>
+
+namespace mcla {
+
+// 已写好的导出文件；记录大小与修改时间，文件被改动、移走或删除后不再复用
+struct ExportArtifact {
+    QString path;
+    qint64 size = -1;
+    QDateTime modified;
+
+    static ExportArtifact capture(const QString &path);
+    bool isValid() const;
+};
+
+// 把 source 的内容放到 target（已存在时替换），尽量不复制数据；失败时 errorOut 为原因。
+// 可能建立硬链接，source 与 target 都须是程序私有的文件
+bool placeFileCopy(const QString &source, const QString &target, QString *errorOut);
+
+// 同上，但从不建立硬链接，target 与 source 互不影响；用于另存为等交给用户的文件，以及在用户文件与结果缓存之间复制
+bool copyToUserFile(const QString &source, const QString &target, QString *errorOut);
+
+} // namespace mcla
@@ -0,0 +1,210 @@
+#include "follower.h"
+
+#include "logsource.h"
+#include "rules.h"
+#include "textencoding.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#endif
+
+namespace mcla {
+
+// 只读打开。Windows 上 QFile 打开的文件不能被其他程序改名或删除，改用带 FILE_SHARE_DELETE 的句柄，
+// 跟踪期间游戏仍能轮转日志
+static std::unique_ptr<QFile> openShared(const QString &path, QString *errorOut) {
+    auto file = std::make_unique<QFile>(path);
+#if defined(Q_OS_WIN)
+    const HANDLE h = CreateFileW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(path).utf16()), GENERIC_READ,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        if (errorOut) *errorOut = QString("无法打开文件（错误 %1）").arg(GetLastError());
+        return nullptr;
+    }
+    const int fd = _open_osfhandle(reinterpret_cast<intptr_t>(h), _O_RDONLY);
+    if (fd < 0) {
+        CloseHandle(h);
+        if (errorOut) *errorOut = "无法打开文件";
+        return nullptr;
+    }
+    if (!file->open(fd, QIODevice::ReadOnly, QFileDevice::AutoCloseHandle)) {
+        _close(fd);
+        if (errorOut) *errorOut = file->errorString();
+        return nullptr;
+    }
+#else
+    if (!file->open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = file->errorString();
+        return nullptr;
+    }
+#endif
+    return file;
+}
+
+// 文件标识（卷与文件编号、设备与 inode）：改名后不变，重建后不同。取不到时为空，只按开头的内容判断
+static QByteArray fileIdentity(QFile &file) {
+#if defined(Q_OS_WIN)
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle())), &info)) return {};
+    return QByteArray::number(quint64(info.dwVolumeSerialNumber)) + ':'
+           + QByteArray::number((quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow);
+#elif defined(Q_OS_UNIX)
+    struct stat st;
+    if (::fstat(file.handle(), &st) != 0) return {};
+    return QByteArray::number(quint64(st.st_dev)) + ':' + QByteArray::number(quint64(st.st_ino));
+#else
+    Q_UNUSED(file);
+    return {};
+#endif
+}
+
+LogFollower::LogFollower(const QString &path, OutputSink sink, QObject *parent)
+    : QObject(parent), path(QFileInfo(path).absoluteFilePath()), sink(std::move(sink)) {
+    connect(&watcher, &QFileSystemWatcher::fileChanged, this, &LogFollower::poll);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &LogFollower::poll);
+    connect(&timer, &QTimer::timeout, this, &LogFollower::poll);
+}
+
+bool LogFollower::start(bool fromStart, QString *errorOut) {
+    file = openShared(path, errorOut);
+    if (!file) return false;
+    fileId = fileIdentity(*file);
+    anonymizer = std::make_unique<StreamAnonymizer>(sink);
+    anonymizer->setLineBuffered(true);
+    // 从末尾开始时按文件开头识别编码，而不是按之后追加的零散几行
+    const QByteArray head = file->read(kEncodingSampleSize);
+    if (!head.isEmpty()) anonymizer->detectEncoding(head);
+    fingerprint = head.left(kFingerprintSize);
+    readOffset = fromStart ? 0 : file->size();
+    buf.resize(kStreamChunkSize);
+
+    watcher.addPath(path);
+    watcher.addPath(QFileInfo(path).absolutePath());
+    timer.start(kPollIntervalMs);
+    poll();
+    return true;
+}
+
+void LogFollower::stop() {
+    if (!anonymizer) return;
+    timer.stop();
+    watcher.removePaths(watcher.files() + watcher.directories());
+    // 停止前已写入的内容也要输出
+    if (!readToEnd()) return;
+    finishFile();
+    anonymizer.reset();
+    file.reset();
+}
+
+void LogFollower::poll() {
+    if (!anonymizer) return;
+    // 先把持有的文件读到末尾：它若已被改名轮转，读到的就是轮转前最后写入的内容
+    if (!readToEnd()) return;
+
+    // 路径上现在的文件；轮转过程中可能暂时不存在，等下一次通知或轮询
+    std::unique_ptr<QFile> current = openShared(path, nullptr);
+    if (!current) return;
+    // 文件被改名后监视随之失效，重建后重新加入
+    if (!watcher.files().contains(path)) watcher.addPath(path);
+    const QByteArray currentId = fileIdentity(*current);
+    if ((fileId.isEmpty() || currentId == fileId) && isSameFile(*current)) return;
+
+    // 轮转后的新文件（或原地重写了开头的同一个文件）：从它的开头接着处理
+    if (!restart(std::move(current))) return;
+    readToEnd();
+}
+
+std::array<qint64, kMaxRules> LogFollower::hitCounts() const {
+    std::array<qint64, kMaxRules> hits = finishedHits;
+    if (anonymizer) {
+        const std::array<qint64, kMaxRules> current = anonymizer->hitCounts();
+        for (size_t i = 0; i < hits.size(); ++i) hits[i] += current[i];
+    }
+    return hits;
+}
+
+// 把持有的文件从 readOffset 读到末尾并脱敏输出；文件比已读到的位置还短说明被原地截断，从头开始。
+// 失败时停止跟踪并返回 false
+bool LogFollower::readToEnd() {
+    if (file->size() < readOffset && !restart(nullptr)) return false;
+    if (file->size() == readOffset) return true;
+    if (!file->seek(readOffset)) {
+        fail(file->errorString());
+        return false;
+    }
+    for (;;) {
+        const qint64 got = readChunk(*file, buf.data(), buf.size());
+        if (got < 0) {
+            fail(file->errorString());
+            return false;
+        }
+        if (got == 0) break;
+        readOffset += got;
+        if (!anonymizer->feed(QByteArrayView(buf.constData(), got))) {
+            fail("输出失败");
+            return false;
+        }
+    }
+    emit advanced(readOffset);
+    return true;
+}
+
+// other 的开头与记录的指纹不同即为另一个文件；指纹不足 kFingerprintSize 时随文件增长补齐
+bool LogFollower::isSameFile(QFile &other) {
+    if (!other.seek(0)) return false;
+    QByteArray head(kFingerprintSize, Qt::Uninitialized);
+    const qint64 got = readChunk(other, head.data(), head.size());
+    if (got < 0) return false;
+    head.truncate(got);
+    if (!head.startsWith(fingerprint)) return false;
+    fingerprint = head;
+    return true;
+}
+
+// 输出当前文件最后未完的行，并累计它的命中次数
+bool LogFollower::finishFile() {
+    const bool ok = anonymizer->finish();
+    const std::array<qint64, kMaxRules> current = anonymizer->hitCounts();
+    for (size_t i = 0; i < finishedHits.size(); ++i) finishedHits[i] += current[i];
+    return ok;
+}
+
+// 结束当前文件，改为从 next（为空时为截断后的同一个文件）的开头处理
+bool LogFollower::restart(std::unique_ptr<QFile> next) {
+    if (!finishFile()) {
+        fail("输出失败");
+        return false;
+    }
+    anonymizer = std::make_unique<StreamAnonymizer>(sink);
+    anonymizer->setLineBuffered(true);
+    if (next) {
+        file = std::move(next);
+        fileId = fileIdentity(*file);
+    }
+    fingerprint.clear();
+    readOffset = 0;
+    isSameFile(*file);
+    emit rotated();
+    return true;
+}
+
+void LogFollower::fail(const QString &error) {
+    timer.stop();
+    watcher.removePaths(watcher.files() + watcher.directories());
+    anonymizer.reset();
+    file.reset();
+    emit failed(error);
+}
+
+} // namespace mcla
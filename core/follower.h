@@ -0,0 +1,76 @@
+#pragma once
+
+// ---------------------------- 跟踪模式 ----------------------------
+// 类似 tail -F：监视不断增长的日志（如 latest.log），只读取并脱敏新追加的字节，按完整的行交出。
+// 记住已处理到的偏移与未完的行，每次追加的处理时间只取决于追加的字节数，与文件已有的大小无关。
+// 跟踪期间一直持有文件句柄（Windows 上允许其他程序改名、删除）：文件被轮转（改名后重建）时，
+// 先经句柄把旧文件读到末尾，轮转前最后写入的内容（如关服时的几行）照常输出，再从新文件开头接着处理。
+// 原地截断（同一个文件被清空重写）时，上次检查之后、截断之前写入的内容已不存在，无法找回
+
+#include "progress.h"
+#include "redactor.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <array>
+#include <memory>
+
+namespace mcla {
+
+class LogFollower : public QObject {
+    Q_OBJECT
+
+public:
+    // sink 依次收到脱敏后的完整行（保持原编码），返回 false 时停止跟踪
+    LogFollower(const QString &path, OutputSink sink, QObject *parent = nullptr);
+
+    // 开始跟踪；fromStart 为 false 时跳过文件现有的内容，只处理之后追加的部分
+    bool start(bool fromStart, QString *errorOut);
+    // 停止跟踪，输出最后未完的行
+    void stop();
+
+    // 检查文件是否有新内容（文件变化通知与定时轮询都会调用）
+    void poll();
+
+    qint64 offset() const { return readOffset; }
+    std::array<qint64, kMaxRules> hitCounts() const;
+
+signals:
+    // 处理了新追加的内容，offset 为当前文件中已处理到的位置
+    void advanced(qint64 offset);
+    // 检测到轮转或截断，之后从新文件开头处理
+    void rotated();
+    // 读取或输出失败，跟踪已停止
+    void failed(const QString &error);
+
+private:
+    // 用文件开头这么多字节识别轮转后的新文件
+    static constexpr qsizetype kFingerprintSize = 1024;
+    // 文件变化通知可能丢失（网络盘、改名后失效），同时定时轮询
+    static constexpr int kPollIntervalMs = 1000;
+
+    QString path;
+    OutputSink sink;
+    QFileSystemWatcher watcher;
+    QTimer timer;
+    std::unique_ptr<QFile> file;   // 正在跟踪的文件，轮转后改名了也仍可读取
+    QByteArray fileId;             // file 的文件标识（设备与 inode 等），取不到时为空
+    std::unique_ptr<StreamAnonymizer> anonymizer;
+    std::array<qint64, kMaxRules> finishedHits{};   // 已轮转掉的文件的命中次数
+    QByteArray fingerprint;
+    QByteArray buf;
+    qint64 readOffset = 0;
+
+    bool readToEnd();
+    bool isSameFile(QFile &other);
+    bool finishFile();
+    bool restart(std::unique_ptr<QFile> next);
+    void fail(const QString &error);
+};
+
+} // namespace mcla
@@ -0,0 +1,43 @@
+#include "ipscanner.h"
+
+#include <QRegularExpression>
+
+namespace mcla {
+
+QString anonymizeText(const QString &text, QList<TextSpan> *spansOut, TaskProgress *progress) {
+    const auto *s = reinterpret_cast<const char16_t*>(text.utf16());
+    const qsizetype n = text.size();
+    QString out;
+    out.reserve(n);
+    qsizetype last = 0;
+    auto onMatch = [&](qsizetype start, qsizetype end, IpMatchKind) {
+        out.append(text.constData() + last, start - last);
+        last = end;
+        if (spansOut) spansOut->append({ start, end });
+    };
+    for (qsizetype pos = 0; pos < n;) {
+        const qsizetype limit = qMin(n, pos + kScanSliceSize);
+        const qsizetype next = scanIpv4(s, pos, limit, limit == n, onMatch);
+        if (progress && !progress->advance(next - pos)) return {};
+        pos = next;
+    }
+    out.append(text.constData() + last, n - last);
+    return out;
+}
+
+QString anonymizeTextRegex(const QString &text) {
+    const QString octet = "(?:25[0-5]|2[0-4]\\d|1?\\d?\\d)";
+    const QString ipPattern = QString("%1\\.%1\\.%1\\.%1").arg(octet);
+    const QString ipPortPattern = QString("\\b%1:\\d{1,5}\\b").arg(ipPattern);
+    const QString ipOnlyPattern = QString("\\b%1\\b").arg(ipPattern);
+
+    QRegularExpression reIpPort(ipPortPattern);
+    QRegularExpression reIp(ipOnlyPattern);
+
+    QString out = text;
+    out.replace(reIpPort, "");
+    out.replace(reIp, "");
+    return out;
+}
+
+} // namespace mcla
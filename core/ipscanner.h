@@ -0,0 +1,187 @@
+#pragma once
+
+// ---------------------------- IP 扫描 ----------------------------
+// 手写的单遍扫描器，结果与原来的两条正则完全一致：
+//   第一遍 \b<IP>:\d{1,5}\b，第二遍在剩余文本上 \b<IP>\b，
+//   其中 octet = 25[0-5]|2[0-4]\d|1?\d?\d。
+// QRegularExpression 默认不开启 UseUnicodePropertiesOption，所以 \b / \d 只认 ASCII。
+
+#include "progress.h"
+#include "textencoding.h"
+
+#include <QList>
+#include <QString>
+
+#include <type_traits>
+
+namespace mcla {
+
+enum class IpMatchKind { IpPort, Ip };
+
+template <typename CharT>
+inline unsigned charCode(CharT c) {
+    return static_cast<std::make_unsigned_t<CharT>>(c);
+}
+
+template <typename CharT>
+inline bool isAsciiDigit(CharT c) {
+    return charCode(c) - '0' < 10u;
+}
+
+template <typename CharT>
+inline bool isAsciiWordChar(CharT c) {
+    const unsigned u = charCode(c);
+    return u - '0' < 10u || (u | 0x20u) - 'a' < 26u || u == '_';
+}
+
+// 跳到下一个 ASCII 数字；没有数字的区段用 SSE2 每次跨 16 字节
+inline qsizetype findNextDigit(const char *s, qsizetype i, qsizetype n) {
+#if MCLA_HAVE_SSE2
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)), zero);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, nine), v));
+        if (mask) return i + qCountTrailingZeroBits(static_cast<quint32>(mask));
+    }
+#endif
+    for (; i < n; ++i)
+        if (isAsciiDigit(s[i])) return i;
+    return n;
+}
+
+inline qsizetype findNextDigit(const char16_t *s, qsizetype i, qsizetype n) {
+#if MCLA_HAVE_SSE2
+    const __m128i zero = _mm_set1_epi16('0');
+    const __m128i nine = _mm_set1_epi16(9);
+    const __m128i none = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)), zero);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_subs_epu16(v, nine), none));
+        if (mask) return i + qCountTrailingZeroBits(static_cast<quint32>(mask)) / 2;
+    }
+#endif
+    for (; i < n; ++i)
+        if (isAsciiDigit(s[i])) return i;
+    return n;
+}
+
+template <typename CharT>
+inline bool isValidOctet(const CharT *d, qsizetype len) {
+    if (len == 1 || len == 2) return true;
+    if (len != 3) return false;
+    if (d[0] == '1') return true;
+    if (d[0] != '2') return false;
+    if (charCode(d[1]) < '5') return true;
+    return d[1] == '5' && charCode(d[2]) <= '5';
+}
+
+// 从 p 开始解析 a.b.c.d，每段必须吃满整段数字（正则回溯也只能如此）
+struct DottedQuad {
+    qsizetype runStart[4];
+    qsizetype end;
+};
+
+template <typename CharT>
+bool parseDottedQuad(const CharT *s, qsizetype p, qsizetype n, DottedQuad &q) {
+    for (int k = 0; k < 4; ++k) {
+        if (k > 0) {
+            if (p >= n || s[p] != '.') return false;
+            ++p;
+        }
+        qsizetype start = p;
+        while (p < n && p - start < 4 && isAsciiDigit(s[p])) ++p;
+        if (!isValidOctet(s + start, p - start) || (p < n && isAsciiDigit(s[p]))) return false;
+        q.runStart[k] = start;
+    }
+    q.end = p;
+    return true;
+}
+
+// 第一遍的匹配：\b<IP>:\d{1,5}\b，成功时返回端口末尾位置，否则返回 -1
+template <typename CharT>
+qsizetype matchIpPortAt(const CharT *s, qsizetype p, qsizetype n) {
+    DottedQuad q;
+    if (!parseDottedQuad(s, p, n, q)) return -1;
+    qsizetype i = q.end;
+    if (i >= n || s[i] != ':') return -1;
+    const qsizetype portStart = ++i;
+    while (i < n && i - portStart < 6 && isAsciiDigit(s[i])) ++i;
+    const qsizetype portLen = i - portStart;
+    if (portLen < 1 || portLen > 5) return -1;
+    if (i < n && isAsciiWordChar(s[i])) return -1;
+    return i;
+}
+
+// 判定一个候选位置最多需要向后看的字符数：IP:端口 最长 21 个字符，加上后随的 \b 字符；
+// 候选内部的第一遍重试最多从第 12 个字符开始，这里留足余量
+constexpr qsizetype kIpv4Lookahead = 40;
+
+// 在候选位置 p（数字且前面不是单词字符）上按两条正则的语义判定，命中时给出区间与类别。
+// 第一遍优先：若 IP:端口 从 IP 的某段内部开始，则该 IP 在第二遍时已被截断，结果是内部的 IP:端口
+template <typename CharT>
+bool matchIpv4Candidate(const CharT *s, qsizetype p, qsizetype n, qsizetype &start, qsizetype &end, IpMatchKind &kind) {
+    qsizetype e = matchIpPortAt(s, p, n);
+    if (e >= 0) {
+        start = p; end = e; kind = IpMatchKind::IpPort;
+        return true;
+    }
+    DottedQuad q;
+    if (!parseDottedQuad(s, p, n, q) || (q.end < n && isAsciiWordChar(s[q.end]))) return false;
+    for (int k = 1; k < 4; ++k) {
+        e = matchIpPortAt(s, q.runStart[k], n);
+        if (e >= 0) {
+            start = q.runStart[k]; end = e; kind = IpMatchKind::IpPort;
+            return true;
+        }
+    }
+    start = p; end = q.end; kind = IpMatchKind::Ip;
+    return true;
+}
+
+// 按从左到右的顺序回调每个需要删除的区间 [start, end)，扫描从 begin 开始（s[begin-1] 作为 \b 的上下文）。
+// atEnd 为 false 时表示 n 之后还有数据：距离末尾不足 kIpv4Lookahead 的候选不作判定，
+// 返回值为下一次应当继续扫描的位置，其之前的文本都已判定完毕。
+template <typename CharT, typename OnMatch>
+qsizetype scanIpv4(const CharT *s, qsizetype begin, qsizetype n, bool atEnd, OnMatch &&onMatch) {
+    qsizetype p = begin;
+    while ((p = findNextDigit(s, p, n)) < n) {
+        if (!atEnd && n - p < kIpv4Lookahead) return p;
+        if (p > 0 && isAsciiWordChar(s[p - 1])) {
+            while (p < n && isAsciiDigit(s[p])) ++p;
+            continue;
+        }
+        qsizetype start, end;
+        IpMatchKind kind;
+        if (matchIpv4Candidate(s, p, n, start, end, kind)) {
+            onMatch(start, end, kind);
+            p = end;
+            continue;
+        }
+        while (p < n && isAsciiDigit(s[p])) ++p;
+    }
+    return n;
+}
+
+template <typename CharT, typename OnMatch>
+void scanIpv4(const CharT *s, qsizetype n, OnMatch &&onMatch) {
+    scanIpv4(s, 0, n, true, onMatch);
+}
+
+// 文本中的一段区间 [start, end)
+struct TextSpan {
+    qsizetype start;
+    qsizetype end;
+    int rule = -1;   // 命中的规则（RuleSet 中的下标），-1 表示未知
+};
+
+// 删除 text 中所有 IP 及 IP:端口，只复制一次未命中的区段；spansOut 非空时记录被删除的区间。
+// 按 kScanSliceSize 分段扫描以便汇报进度（单位为字符），被取消时返回空串
+constexpr qsizetype kScanSliceSize = 8 << 20;
+
+QString anonymizeText(const QString &text, QList<TextSpan> *spansOut = nullptr, TaskProgress *progress = nullptr);
+
+// 原来的正则实现，保留用于对比基准与结果校验
+QString anonymizeTextRegex(const QString &text);
+
+} // namespace mcla
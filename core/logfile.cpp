@@ -0,0 +1,239 @@
+#include "logfile.h"
+
+#include "archive.h"
+#include "logsource.h"
+
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QStringDecoder>
+#include <QStringEncoder>
+
+namespace mcla {
+
+bool anonymizeStream(QIODevice &in, QIODevice &out, TaskProgress *progress) {
+    QByteArray buf(kStreamChunkSize, Qt::Uninitialized);
+    // 小的输出片段先攒成块再写，大的片段直接写出
+    QByteArray block;
+    block.reserve(kStreamChunkSize);
+    auto flush = [&] {
+        const bool ok = block.isEmpty() || out.write(block) == block.size();
+        block.resize(0);
+        return ok;
+    };
+    StreamAnonymizer anonymizer([&](QByteArrayView piece) {
+        if (block.size() + piece.size() > kStreamChunkSize && !flush()) return false;
+        if (piece.size() >= kStreamChunkSize) return out.write(piece.data(), piece.size()) == piece.size();
+        block.append(piece);
+        return true;
+    });
+
+    for (;;) {
+        const qint64 got = readChunk(in, buf.data(), buf.size());
+        if (got < 0 || (progress && progress->isCancelled())) return false;
+        if (got == 0) break;
+        if (progress) progress->advance(got);
+        if (!anonymizer.feed(QByteArrayView(buf.constData(), got))) return false;
+    }
+    if (!anonymizer.finish() || !flush()) return false;
+    if (progress) progress->addHits(anonymizer.hitCounts());
+    return true;
+}
+
+bool shouldStream(const QFileInfo &fi) {
+    const QString lower = fi.fileName().toLower();
+    if (lower.endsWith(".gz") || lower.endsWith(".zip")) return fi.size() > kStreamingThreshold / 8;
+    return QT_POINTER_SIZE < 8 && fi.size() > kStreamingThreshold;
+}
+
+// 读取大文件开头的一段（在最后一个换行处截断）用于预览
+static QByteArray readStreamHead(const QString &path, QString *entryNameOut) {
+    auto source = openLogSource(path, entryNameOut);
+    if (!source) return {};
+    QByteArray head(kStreamPreviewSize, Qt::Uninitialized);
+    const qint64 got = readChunk(*source, head.data(), head.size());
+    if (got <= 0) return {};
+    head.truncate(got);
+    const qsizetype nl = head.lastIndexOf('\n');
+    if (nl >= 0 && got == kStreamPreviewSize) head.truncate(nl + 1);
+    return head;
+}
+
+bool anonymizeDeviceToFile(QIODevice &source, const QString &targetPath, TaskProgress *progress, bool gzip) {
+    return writeFileAtomically(targetPath, gzip, [&](QIODevice &out) { return anonymizeStream(source, out, progress); });
+}
+
+bool anonymizeFileStreaming(const QString &sourcePath, const QString &targetPath, TaskProgress *progress, bool gzip) {
+    auto source = openLogSource(sourcePath);
+    return source && anonymizeDeviceToFile(*source, targetPath, progress, gzip);
+}
+
+bool writeFileAtomically(const QString &targetPath, bool gzip, const std::function<bool(QIODevice &)> &write) {
+    QSaveFile file(targetPath);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    bool ok;
+    if (gzip) {
+        DeflateDevice gz(&file, DeflateDevice::Format::Gzip);
+        ok = write(gz) && gz.finish();
+    } else {
+        ok = write(file);
+    }
+    if (!ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+// ---- 文件读取 ----
+
+// 识别编码并保存日志字节，同时记录识别结果与耗时；只有 UTF-16 需要转换一次
+static bool acceptLogBytes(const QByteArray &bytes, LoadedLog &log) {
+    if (bytes.isEmpty()) return false;
+    QElapsedTimer timer;
+    timer.start();
+    log.encoding = detectTextEncoding(bytes.constData(), bytes.size());
+    log.detectNs = timer.nsecsElapsed();
+    log.encodingName = log.encoding.name();
+    log.bytes = toWorkingBytes(bytes, log.encoding);
+    return !log.bytes.isEmpty();
+}
+
+qint64 progressTotalHint(const QString &path) {
+    const QFileInfo fi(path);
+    if (archiveKindOf(path) != ArchiveKind::None || fi.fileName().endsWith(".gz", Qt::CaseInsensitive)) return 0;
+    return fi.size();
+}
+
+LoadedLog loadLogFile(const QString &path, TaskProgress *progress) {
+    QFileInfo fi(path);
+    LoadedLog log;
+
+    // 后缀判断（低优先级，真实处理看内容）
+    const QString lower = fi.fileName().toLower();
+
+    // 压缩包读取
+    if (lower.endsWith(".tar.gz")) {
+        QString pickedName;
+        QByteArray bytes = readTarGzEntryText(path, &pickedName, progress);
+        if (bytes.isEmpty()) {
+            log.error = "无法解压或未找到可读取的日志文件（.log/.txt），压缩包可能已损坏。";
+            log.note = "(tar.gz 读取失败)";
+            return log;
+        }
+        if (!acceptLogBytes(bytes, log)) {
+            log.error = "从压缩包中读取到的文件不是可识别的文本或编码识别失败。";
+            log.note = "(tar.gz 非文本)";
+            return log;
+        }
+        log.displayName = pickedName.isEmpty() ? fi.completeBaseName() + ".txt" : pickedName;
+        log.note = "(已从 tar.gz 读取)";
+        return log;
+    }
+    else if (lower.endsWith(".gz")) {
+        QByteArray bytes = readGzFile(path, progress);
+        if (bytes.isEmpty()) {
+            log.error = "无法解压 .gz，文件可能已损坏。";
+            log.note = "(gz 读取失败)";
+            return log;
+        }
+        if (!acceptLogBytes(bytes, log)) {
+            log.error = ".gz 内容不是可识别的文本或编码识别失败。";
+            log.note = "(gz 非文本)";
+            return log;
+        }
+        QString base = fi.fileName();
+        if (base.endsWith(".gz", Qt::CaseInsensitive)) base.chop(3);
+        log.displayName = base.isEmpty() ? fi.completeBaseName() + ".txt" : base;
+        log.note = "(已从 gz 读取)";
+        return log;
+    }
+    else if (lower.endsWith(".zip")) {
+        QString pickedName;
+        QByteArray bytes = readZipEntryText(path, &pickedName, progress);
+        if (bytes.isEmpty()) {
+            log.error = "无法解压或未找到可读取的日志文件（.log/.txt），压缩包可能已损坏或使用了不支持的压缩方式。";
+            log.note = "(zip 读取失败)";
+            return log;
+        }
+        if (!acceptLogBytes(bytes, log)) {
+            log.error = "从 zip 中读取到的文件不是可识别的文本或编码识别失败。";
+            log.note = "(zip 非文本)";
+            return log;
+        }
+        log.displayName = pickedName.isEmpty() ? fi.completeBaseName() + ".txt" : pickedName;
+        log.note = "(已从 zip 读取)";
+        return log;
+    }
+
+    std::shared_ptr<QFile> mapping;
+    if (!acceptLogBytes(mapPlainFile(path, mapping, progress), log)) {
+        log.error = "非文本文件或无法识别编码，或不是受支持的压缩包。";
+        log.note = "(非文本/不支持)";
+        return log;
+    }
+    // UTF-16 已转换成新的缓冲区，不再需要映射
+    if (log.encoding.isAsciiCompatible()) log.mapping = std::move(mapping);
+    log.displayName = fi.fileName();
+    return log;
+}
+
+LoadedLog loadLogHead(const QString &path) {
+    LoadedLog log;
+    if (!acceptLogBytes(readStreamHead(path, &log.displayName), log)) {
+        log.error = "无法读取文件开头，或不是可识别的文本。";
+        log.note = "(读取失败)";
+        return log;
+    }
+    log.note = "(大文件：仅预览开头部分，导出时流式处理完整文件)";
+    return log;
+}
+
+QString anonymizedFileName(const QString &displayName) {
+    QFileInfo fdn(displayName);
+
+    QString base = fdn.completeBaseName();
+    QString suffix = fdn.suffix();
+    if (suffix.isEmpty()) suffix = "txt";
+
+    return base + "_Anonymized." + suffix;
+}
+
+bool writeRedacted(QIODevice &out, const QByteArray &data, const RedactedLog &r, const TextEncoding &enc,
+                   TaskProgress *progress) {
+    const bool transcode = !enc.isAsciiCompatible();
+    QStringDecoder utf8(QStringConverter::Utf8);
+    QStringEncoder encoder = enc.encoder(enc.bom ? QStringConverter::Flag::WriteBom : QStringConverter::Flag::Default);
+    QByteArray buf;
+    buf.reserve(kStreamChunkSize);
+
+    auto writeOut = [&](const char *p, qsizetype n) {
+        if (progress && !progress->advance(n)) return false;
+        return out.write(p, n) == n;
+    };
+    auto flush = [&] {
+        if (buf.isEmpty()) return true;
+        const QByteArray encoded = transcode ? QByteArray(encoder.encode(QString(utf8.decode(buf)))) : QByteArray();
+        const bool ok = transcode ? writeOut(encoded.constData(), encoded.size()) : writeOut(buf.constData(), buf.size());
+        buf.resize(0);
+        return ok;
+    };
+    const bool ok = forEachRedactedPiece(data, r, [&](const char *p, qsizetype n) {
+        if (!transcode && n >= kStreamChunkSize) return flush() && writeOut(p, n);
+        while (n > 0) {
+            const qsizetype take = qMin(n, qsizetype(kStreamChunkSize) - buf.size());
+            buf.append(p, take);
+            p += take;
+            n -= take;
+            if (buf.size() == kStreamChunkSize && !flush()) return false;
+        }
+        return true;
+    });
+    return ok && flush();
+}
+
+bool writeRedactedFile(const QString &targetPath, const QByteArray &data, const RedactedLog &r,
+                       const TextEncoding &enc, TaskProgress *progress, bool gzip) {
+    return writeFileAtomically(targetPath, gzip, [&](QIODevice &out) { return writeRedacted(out, data, r, enc, progress); });
+}
+
+} // namespace mcla
@@ -0,0 +1,83 @@
+#pragma once
+
+// ---------------------------- 流式处理 ----------------------------
+// 大文件不再整体载入内存，而是按固定大小分块读取、解码、脱敏并直接写入目标文件
+
+#include "progress.h"
+#include "redactor.h"
+#include "textencoding.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QString>
+
+#include <functional>
+#include <memory>
+
+namespace mcla {
+
+// 超过其 1/8 的压缩包（32 位系统上为超过该大小的普通文件）改用流式处理
+constexpr qint64 kStreamingThreshold = 256ll << 20;
+// 流式模式下预览区只显示文件开头这么多字节
+constexpr qint64 kStreamPreviewSize = 4 << 20;
+
+// 从 in 分块读取并脱敏（见 StreamAnonymizer），按原编码写入 out；内存占用只取决于块大小。
+// progress 按读入的字节数累加，被取消时返回 false
+bool anonymizeStream(QIODevice &in, QIODevice &out, TaskProgress *progress = nullptr);
+
+// 普通文件在 64 位系统上整个映射到内存（见 mapPlainFile），不占堆内存，无需流式处理
+bool shouldStream(const QFileInfo &fi);
+
+// 把数据流脱敏后写入目标文件（见 writeFileAtomically），gzip 为 true 时写成 .gz
+bool anonymizeDeviceToFile(QIODevice &source, const QString &targetPath, TaskProgress *progress = nullptr,
+                           bool gzip = false);
+
+// 从源文件（普通文件或压缩包中的日志）流式脱敏到目标文件
+bool anonymizeFileStreaming(const QString &sourcePath, const QString &targetPath, TaskProgress *progress = nullptr,
+                            bool gzip = false);
+
+// 原子地写出 targetPath：write 先写入同目录的临时文件，成功后才替换目标，失败或被取消时不留下不完整的文件。
+// gzip 为 true 时 write 写入的数据边写边压缩为 gzip 格式
+bool writeFileAtomically(const QString &targetPath, bool gzip, const std::function<bool(QIODevice &)> &write);
+
+// ---------------------------- 文件读取 ----------------------------
+
+// 读取结果：成功时 bytes 非空；失败时 error 为显示在预览区的说明。note 附加在文件名标签后
+struct LoadedLog {
+    QByteArray bytes;        // 日志内容；UTF-16 已转成 UTF-8，其余保持原编码
+    std::shared_ptr<QFile> mapping;   // bytes 直接指向文件映射时持有映射，使用 bytes 期间不能释放
+    TextEncoding encoding;   // 原文件编码，bytes 的编码为 encoding.working()
+    QString displayName;
+    QString note;
+    QString error;
+    QString encodingName;
+    qint64 detectNs = 0;   // 编码识别耗时
+    qint64 loadNs = 0;     // 读取（含解压、识别、解码）总耗时，由调用方填写
+    quint64 sourceHash = 0;   // 源文件原样的内容哈希（见 hashFile），启用结果缓存时由调用方填写，0 表示没有
+};
+
+// 进度条的总量：未压缩的普通文件即文件大小；压缩包解出的大小事先未知，返回 0
+qint64 progressTotalHint(const QString &path);
+
+// 按后缀选择读取方式（普通文本 / .gz / .zip / .tar.gz）并识别编码；被取消时 bytes 为空
+LoadedLog loadLogFile(const QString &path, TaskProgress *progress = nullptr);
+
+// 大文件只读取开头一段用于预览，导出时再从源文件流式处理
+LoadedLog loadLogHead(const QString &path);
+
+// 脱敏后的文件名：name_Anonymized.suffix
+QString anonymizedFileName(const QString &displayName);
+
+// 把脱敏结果按原文件的编码 enc 写入 out（data 为 enc.working() 编码），不生成完整的脱敏副本：
+// ASCII 兼容编码时大的区段直接从 data 写出，小的区段先攒成块；UTF-16 按块转换编码后写出。
+// progress 按写出的字节数累加，被取消时返回 false
+bool writeRedacted(QIODevice &out, const QByteArray &data, const RedactedLog &r, const TextEncoding &enc,
+                   TaskProgress *progress = nullptr);
+
+// 写出脱敏后的文件（见 writeFileAtomically），gzip 为 true 时写成 .gz
+bool writeRedactedFile(const QString &targetPath, const QByteArray &data, const RedactedLog &r,
+                       const TextEncoding &enc, TaskProgress *progress = nullptr, bool gzip = false);
+
+} // namespace mcla
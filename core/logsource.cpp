@@ -0,0 +1,358 @@
+#include "logsource.h"
+
+#include "textencoding.h"
+
+#include <QFileInfo>
+#include <QStringList>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+namespace mcla {
+
+qint64 readChunk(QIODevice &in, char *data, qint64 maxSize) {
+    qint64 total = 0;
+    while (total < maxSize) {
+        const qint64 got = in.read(data + total, maxSize - total);
+        if (got < 0) return -1;
+        if (got == 0) break;
+        total += got;
+    }
+    return total;
+}
+
+bool readWholeDevice(QIODevice &in, QByteArray &out, TaskProgress *progress) {
+    out.clear();
+    for (;;) {
+        const qsizetype used = out.size();
+        if (out.capacity() < used + kStreamChunkSize)
+            out.reserve(qMax<qsizetype>(out.capacity() * 2, used + kStreamChunkSize));
+        out.resize(used + kStreamChunkSize);
+        const qint64 got = readChunk(in, out.data() + used, kStreamChunkSize);
+        if (got < 0 || (progress && !progress->advance(got))) { out.clear(); return false; }
+        out.resize(used + got);
+        if (got < kStreamChunkSize) return true;
+    }
+}
+
+GzipInflater::GzipInflater(Sink sink) : sink(std::move(sink)) {
+    zlibReady = inflateInit2(&zs, 16 + MAX_WBITS) == Z_OK;
+    output.resize(kInflateInputSize);
+}
+
+GzipInflater::~GzipInflater() {
+    if (zlibReady) inflateEnd(&zs);
+}
+
+bool GzipInflater::fail(const QString &message) {
+    if (error.isEmpty()) error = message;
+    return false;
+}
+
+bool GzipInflater::feed(QByteArrayView data) {
+    if (!zlibReady) return fail("zlib 初始化失败");
+    if (!error.isEmpty()) return false;
+    for (qsizetype done = 0; done < data.size() && !trailing;) {
+        const uInt n = static_cast<uInt>(qMin<qsizetype>(data.size() - done, 1 << 30));
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + done));
+        zs.avail_in = n;
+        // 输出缓冲区被填满时 zlib 内部可能还有数据，继续取出
+        do {
+            zs.next_out = reinterpret_cast<Bytef*>(output.data());
+            zs.avail_out = static_cast<uInt>(output.size());
+            const int rc = inflate(&zs, Z_NO_FLUSH);
+            const qsizetype have = output.size() - zs.avail_out;
+            if (have > 0 && !sink(QByteArrayView(output.constData(), have))) return fail("输出被中止");
+            if (rc == Z_STREAM_END) {
+                // gzip 可能由多个成员拼接而成（如 cat a.gz b.gz）
+                memberDone = true;
+                inflateReset(&zs);
+            } else if (rc == Z_DATA_ERROR && memberDone && zs.total_out == 0) {
+                trailing = true;
+                break;
+            } else if (rc == Z_BUF_ERROR) {
+                break;
+            } else if (rc != Z_OK) {
+                return fail(zs.msg ? QString::fromLatin1(zs.msg) : QString("解压失败"));
+            }
+        } while (zs.avail_in > 0 || zs.avail_out == 0);
+        done += n;
+    }
+    return true;
+}
+
+bool GzipInflater::finish() {
+    if (!error.isEmpty()) return false;
+    if (trailing || (memberDone && zs.total_in == 0)) return true;
+    return fail("压缩数据被截断");
+}
+
+static bool isLogEntryName(const QString &name) {
+    const QString low = name.toLower();
+    return low.endsWith(".log") || low.endsWith(".txt");
+}
+
+// 按原来的规则挑选条目：优先第一个 .log/.txt，否则取第一个文件
+static qsizetype pickLogEntry(const QStringList &names) {
+    for (qsizetype i = 0; i < names.size(); ++i)
+        if (isLogEntryName(names[i])) return i;
+    return names.isEmpty() ? -1 : 0;
+}
+
+QString decodeEntryName(const QByteArray &raw, bool utf8Flag) {
+    if (utf8Flag || isValidUtf8(raw)) return QString::fromUtf8(raw);
+    return QString::fromLocal8Bit(raw);
+}
+
+// ---- zip ----
+
+bool readZipDirectory(QFile &f, QList<ZipEntryInfo> &entries, QString *errorOut, bool withDirectories) {
+    const qint64 fileSize = f.size();
+    const qint64 tailSize = qMin<qint64>(fileSize, 0xFFFF + 22);
+    if (tailSize < 22 || !f.seek(fileSize - tailSize)) { if (errorOut) *errorOut = "不是有效的 zip 文件"; return false; }
+    const QByteArray tail = f.read(tailSize);
+    const auto *t = reinterpret_cast<const uchar*>(tail.constData());
+
+    qsizetype eocd = -1;
+    for (qsizetype i = tail.size() - 22; i >= 0; --i) {
+        if (qFromLittleEndian<quint32>(t + i) == 0x06054b50) { eocd = i; break; }
+    }
+    if (eocd < 0) { if (errorOut) *errorOut = "找不到 zip 中央目录"; return false; }
+
+    quint64 count = qFromLittleEndian<quint16>(t + eocd + 10);
+    quint64 cdSize = qFromLittleEndian<quint32>(t + eocd + 12);
+    quint64 cdOffset = qFromLittleEndian<quint32>(t + eocd + 16);
+
+    // Zip64：定位记录紧挨在 EOCD 之前
+    if (eocd >= 20 && qFromLittleEndian<quint32>(t + eocd - 20) == 0x07064b50) {
+        const quint64 z64Offset = qFromLittleEndian<quint64>(t + eocd - 20 + 8);
+        uchar rec[56];
+        if (!f.seek(qint64(z64Offset)) || f.read(reinterpret_cast<char*>(rec), 56) != 56
+            || qFromLittleEndian<quint32>(rec) != 0x06064b50) {
+            if (errorOut) *errorOut = "Zip64 目录损坏";
+            return false;
+        }
+        count = qFromLittleEndian<quint64>(rec + 32);
+        cdSize = qFromLittleEndian<quint64>(rec + 40);
+        cdOffset = qFromLittleEndian<quint64>(rec + 48);
+    }
+
+    if (cdOffset + cdSize > quint64(fileSize) || !f.seek(qint64(cdOffset))) {
+        if (errorOut) *errorOut = "zip 中央目录越界";
+        return false;
+    }
+    const QByteArray cd = f.read(qint64(cdSize));
+    const auto *c = reinterpret_cast<const uchar*>(cd.constData());
+    const qsizetype cdLen = cd.size();
+
+    qsizetype pos = 0;
+    for (quint64 k = 0; k < count; ++k) {
+        if (pos + 46 > cdLen || qFromLittleEndian<quint32>(c + pos) != 0x02014b50) {
+            if (errorOut) *errorOut = "zip 中央目录损坏";
+            return false;
+        }
+        ZipEntryInfo e;
+        e.flags = qFromLittleEndian<quint16>(c + pos + 8);
+        e.method = qFromLittleEndian<quint16>(c + pos + 10);
+        e.dosTime = qFromLittleEndian<quint16>(c + pos + 12);
+        e.dosDate = qFromLittleEndian<quint16>(c + pos + 14);
+        e.crc = qFromLittleEndian<quint32>(c + pos + 16);
+        e.compressedSize = qFromLittleEndian<quint32>(c + pos + 20);
+        e.uncompressedSize = qFromLittleEndian<quint32>(c + pos + 24);
+        const quint16 nameLen = qFromLittleEndian<quint16>(c + pos + 28);
+        const quint16 extraLen = qFromLittleEndian<quint16>(c + pos + 30);
+        const quint16 commentLen = qFromLittleEndian<quint16>(c + pos + 32);
+        e.localHeaderOffset = qFromLittleEndian<quint32>(c + pos + 42);
+        if (pos + 46 + nameLen + extraLen + commentLen > cdLen) {
+            if (errorOut) *errorOut = "zip 中央目录损坏";
+            return false;
+        }
+        e.name = decodeEntryName(QByteArray(cd.constData() + pos + 46, nameLen), e.flags & 0x800);
+
+        // Zip64 扩展字段：只包含 32 位字段为 0xFFFFFFFF 的那几项，按固定顺序排列
+        const uchar *x = c + pos + 46 + nameLen;
+        for (qsizetype xp = 0; xp + 4 <= extraLen;) {
+            const quint16 id = qFromLittleEndian<quint16>(x + xp);
+            const quint16 len = qFromLittleEndian<quint16>(x + xp + 2);
+            if (id != 0x0001) {
+                e.extra.append(reinterpret_cast<const char*>(x + xp), qMin<qsizetype>(4 + len, extraLen - xp));
+            } else {
+                const uchar *v = x + xp + 4;
+                const uchar *vEnd = v + qMin<qsizetype>(len, extraLen - xp - 4);
+                if (e.uncompressedSize == 0xFFFFFFFFu && v + 8 <= vEnd) { e.uncompressedSize = qFromLittleEndian<quint64>(v); v += 8; }
+                if (e.compressedSize == 0xFFFFFFFFu && v + 8 <= vEnd) { e.compressedSize = qFromLittleEndian<quint64>(v); v += 8; }
+                if (e.localHeaderOffset == 0xFFFFFFFFu && v + 8 <= vEnd) { e.localHeaderOffset = qFromLittleEndian<quint64>(v); }
+            }
+            xp += 4 + len;
+        }
+        pos += 46 + nameLen + extraLen + commentLen;
+
+        if (!withDirectories && (e.name.endsWith('/') || e.name.endsWith('\\'))) continue; // 目录
+        entries.append(e);
+    }
+    return true;
+}
+
+bool seekZipEntryData(QFile &file, const ZipEntryInfo &entry) {
+    uchar local[30];
+    if (!file.seek(qint64(entry.localHeaderOffset))
+        || file.read(reinterpret_cast<char*>(local), 30) != 30 || qFromLittleEndian<quint32>(local) != 0x04034b50)
+        return false;
+    const qint64 dataStart = qint64(entry.localHeaderOffset) + 30
+        + qFromLittleEndian<quint16>(local + 26) + qFromLittleEndian<quint16>(local + 28);
+    return file.seek(dataStart);
+}
+
+std::unique_ptr<QIODevice> openZipEntry(const QString &zipPath, const ZipEntryInfo &entry, QString *errorOut) {
+    auto fail = [&](const QString &message) -> std::unique_ptr<QIODevice> {
+        if (errorOut) *errorOut = message;
+        return nullptr;
+    };
+    if (entry.flags & 0x1) return fail("不支持加密的 zip 条目：" + entry.name);
+    if (entry.method != 0 && entry.method != 8) return fail(QString("不支持的 zip 压缩方式 %1：").arg(entry.method) + entry.name);
+
+    auto file = std::make_unique<QFile>(zipPath);
+    if (!file->open(QIODevice::ReadOnly) || !seekZipEntryData(*file, entry))
+        return fail("zip 条目头损坏：" + entry.name);
+
+    const auto format = entry.method == 8 ? InflateDevice::Format::RawDeflate : InflateDevice::Format::Stored;
+    return std::make_unique<InflateDevice>(std::move(file), format, qint64(entry.compressedSize));
+}
+
+// 打开 zip 中的日志条目（优先 .log/.txt）
+static std::unique_ptr<QIODevice> openZipLogEntry(const QString &zipPath, QString *entryNameOut, QString *errorOut) {
+    QFile f(zipPath);
+    if (!f.open(QIODevice::ReadOnly)) { if (errorOut) *errorOut = f.errorString(); return nullptr; }
+    QList<ZipEntryInfo> entries;
+    if (!readZipDirectory(f, entries, errorOut)) return nullptr;
+    QStringList names;
+    for (const auto &e : entries) names << e.name;
+    const qsizetype picked = pickLogEntry(names);
+    if (picked < 0) { if (errorOut) *errorOut = "zip 中没有文件"; return nullptr; }
+    if (entryNameOut) *entryNameOut = entries[picked].name;
+    return openZipEntry(zipPath, entries[picked], errorOut);
+}
+
+// ---- tar ----
+
+// tar 中当前条目的数据流，持有整个 TarReader
+class TarEntryDevice : public QIODevice {
+public:
+    explicit TarEntryDevice(std::unique_ptr<TarReader> r) : reader(std::move(r)) {
+        open(QIODevice::ReadOnly);
+    }
+
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override {
+        const qint64 got = reader->readEntryData(data, maxSize);
+        if (got < 0) setErrorString(reader->errorString());
+        return got;
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    std::unique_ptr<TarReader> reader;
+};
+
+std::unique_ptr<TarReader> openTarGz(const QString &path, QString *errorOut) {
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = file->errorString();
+        return nullptr;
+    }
+    return std::make_unique<TarReader>(std::make_unique<InflateDevice>(std::move(file), InflateDevice::Format::Gzip));
+}
+
+// 打开 .tar.gz 中的日志条目：优先第一个 .log/.txt；没有时重新读一遍取第一个文件
+static std::unique_ptr<QIODevice> openTarGzLogEntry(const QString &path, QString *entryNameOut, QString *errorOut) {
+    for (int pass = 0; pass < 2; ++pass) {
+        auto reader = openTarGz(path, errorOut);
+        if (!reader) return nullptr;
+        TarEntryInfo e;
+        while (reader->next(e)) {
+            if (pass == 1 || isLogEntryName(e.name)) {
+                if (entryNameOut) *entryNameOut = e.name;
+                return std::make_unique<TarEntryDevice>(std::move(reader));
+            }
+        }
+        if (!reader->errorString().isEmpty()) {
+            if (errorOut) *errorOut = reader->errorString();
+            return nullptr;
+        }
+    }
+    if (errorOut) *errorOut = "tar.gz 中没有文件";
+    return nullptr;
+}
+
+std::unique_ptr<QIODevice> openLogSource(const QString &path, QString *entryNameOut, QString *errorOut) {
+    QFileInfo fi(path);
+    const QString lower = fi.fileName().toLower();
+    if (lower.endsWith(".tar.gz")) return openTarGzLogEntry(path, entryNameOut, errorOut);
+    if (lower.endsWith(".zip")) return openZipLogEntry(path, entryNameOut, errorOut);
+
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = file->errorString();
+        return nullptr;
+    }
+    if (lower.endsWith(".gz")) {
+        if (entryNameOut) *entryNameOut = fi.fileName().chopped(3);
+        return std::make_unique<InflateDevice>(std::move(file), InflateDevice::Format::Gzip);
+    }
+    if (entryNameOut) *entryNameOut = fi.fileName();
+    return file;
+}
+
+QByteArray readPlainFile(const QString &path, TaskProgress *progress) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return {};
+    QByteArray data;
+    if (!readWholeDevice(f, data, progress)) return {};
+    return data;
+}
+
+QByteArray mapPlainFile(const QString &path, std::shared_ptr<QFile> &mapping, TaskProgress *progress) {
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) return {};
+    const qint64 size = file->size();
+    if (size > 0 && size < qint64(std::numeric_limits<qsizetype>::max())) {
+        if (const uchar *p = file->map(0, size)) {
+            if (progress) progress->advance(size);
+            mapping = std::move(file);
+            return QByteArray::fromRawData(reinterpret_cast<const char*>(p), qsizetype(size));
+        }
+    }
+    QByteArray data;
+    if (!readWholeDevice(*file, data, progress)) return {};
+    return data;
+}
+
+// 从 .gz 读取
+QByteArray readGzFile(const QString &path, TaskProgress *progress) {
+    auto dev = openLogSource(path);
+    QByteArray out;
+    if (!dev || !readWholeDevice(*dev, out, progress)) return {};
+    return out;
+}
+
+// 从 .zip 读取
+QByteArray readZipEntryText(const QString &zipPath, QString *pickedNameOut, TaskProgress *progress) {
+    auto dev = openZipLogEntry(zipPath, pickedNameOut, nullptr);
+    QByteArray out;
+    if (!dev || !readWholeDevice(*dev, out, progress)) return {};
+    return out;
+}
+
+// 从 .tar.gz 读取
+QByteArray readTarGzEntryText(const QString &tgzPath, QString *pickedNameOut, TaskProgress *progress) {
+    auto dev = openTarGzLogEntry(tgzPath, pickedNameOut, nullptr);
+    QByteArray out;
+    if (!dev || !readWholeDevice(*dev, out, progress)) return {};
+    return out;
+}
+
+} // namespace mcla
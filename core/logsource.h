@@ -0,0 +1,440 @@
+#pragma once
+
+// ---------------------------- 内置解压 ----------------------------
+// 用 zlib 在进程内解压 .gz / .zip / .tar.gz，不再启动 7z、gzip、unzip、tar 子进程。
+// 解压器都是顺序读取的 QIODevice，解出的数据可以边读边解码、脱敏
+
+#include "progress.h"
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFile>
+#include <QIODevice>
+#include <QList>
+#include <QString>
+
+#include <functional>
+#include <memory>
+
+#include <zlib.h>
+
+namespace mcla {
+
+constexpr qint64 kStreamChunkSize = 1 << 20;
+constexpr qint64 kInflateInputSize = 256 << 10;
+
+// 读满 maxSize 字节或到达结尾，返回 0 表示结束，-1 表示读取出错
+qint64 readChunk(QIODevice &in, char *data, qint64 maxSize);
+
+// 读出设备中的全部数据；progress 按读出的字节数累加，被取消时返回 false
+bool readWholeDevice(QIODevice &in, QByteArray &out, TaskProgress *progress = nullptr);
+
+// 把 source 中的 gzip（可含多个成员）/ 原始 deflate / 未压缩数据读成顺序流。
+// limit 为最多读取的源数据字节数（zip 条目的压缩大小），-1 表示读到源结尾
+class InflateDevice : public QIODevice {
+public:
+    enum class Format { Gzip, RawDeflate, Stored };
+
+    InflateDevice(std::unique_ptr<QIODevice> src, Format fmt, qint64 limit = -1)
+        : source(std::move(src)), format(fmt), remaining(limit) {
+        if (format != Format::Stored) {
+            zlibReady = inflateInit2(&zs, format == Format::Gzip ? 16 + MAX_WBITS : -MAX_WBITS) == Z_OK;
+            input.resize(kInflateInputSize);
+        }
+        open(QIODevice::ReadOnly);
+    }
+
+    ~InflateDevice() override {
+        if (zlibReady) inflateEnd(&zs);
+    }
+
+    bool isSequential() const override { return true; }
+
+    bool atEnd() const override {
+        return finished && QIODevice::bytesAvailable() == 0;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override {
+        if (finished || maxSize <= 0) return 0;
+        return format == Format::Stored ? readStored(data, maxSize) : readInflated(data, maxSize);
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    std::unique_ptr<QIODevice> source;
+    Format format;
+    qint64 remaining;
+    z_stream zs{};
+    bool zlibReady = false;
+    bool finished = false;
+    // 已解完至少一个 gzip 成员，之后出现的无法识别的数据视为尾部填充
+    bool memberDone = false;
+    QByteArray input;
+
+    qint64 fail(const QString &message) {
+        setErrorString(message);
+        finished = true;
+        return -1;
+    }
+
+    qint64 readStored(char *data, qint64 maxSize) {
+        const qint64 want = remaining < 0 ? maxSize : qMin(maxSize, remaining);
+        if (want == 0) { finished = true; return 0; }
+        const qint64 got = source->read(data, want);
+        if (got < 0) return fail(source->errorString());
+        if (got == 0) {
+            if (remaining > 0) return fail("压缩包数据被截断");
+            finished = true;
+            return 0;
+        }
+        if (remaining > 0) remaining -= got;
+        return got;
+    }
+
+    qint64 fillInput() {
+        qint64 want = input.size();
+        if (remaining >= 0) want = qMin(want, remaining);
+        const qint64 got = want > 0 ? readChunk(*source, input.data(), want) : 0;
+        if (got > 0 && remaining > 0) remaining -= got;
+        zs.next_in = reinterpret_cast<Bytef*>(input.data());
+        zs.avail_in = got > 0 ? static_cast<uInt>(got) : 0;
+        return got;
+    }
+
+    qint64 readInflated(char *data, qint64 maxSize) {
+        if (!zlibReady) return fail("zlib 初始化失败");
+        zs.next_out = reinterpret_cast<Bytef*>(data);
+        zs.avail_out = static_cast<uInt>(qMin<qint64>(maxSize, 1 << 30));
+        const uInt outSize = zs.avail_out;
+
+        while (zs.avail_out > 0 && !finished) {
+            if (zs.avail_in == 0) {
+                const qint64 got = fillInput();
+                if (got < 0) return fail(source->errorString());
+                if (got == 0) {
+                    if (memberDone && zs.total_out == 0) { finished = true; break; }
+                    return fail("压缩数据被截断");
+                }
+            }
+            const int rc = inflate(&zs, Z_NO_FLUSH);
+            if (rc == Z_STREAM_END) {
+                if (format != Format::Gzip) { finished = true; break; }
+                // gzip 可能由多个成员拼接而成（如 cat a.gz b.gz）
+                memberDone = true;
+                if (zs.avail_in == 0) {
+                    const qint64 got = fillInput();
+                    if (got < 0) return fail(source->errorString());
+                    if (got == 0) { finished = true; break; }
+                }
+                inflateReset(&zs);
+            } else if (rc == Z_DATA_ERROR && memberDone && zs.total_out == 0) {
+                finished = true;
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                return fail(zs.msg ? QString::fromLatin1(zs.msg) : QString("解压失败"));
+            }
+        }
+        return outSize - zs.avail_out;
+    }
+};
+
+// 把写入的数据压缩为 gzip 或原始 deflate 写到 target，写完后调用 finish() 输出剩余数据。
+// 同时记录未压缩数据的 CRC32 与长度（zip 条目头需要）
+class DeflateDevice : public QIODevice {
+public:
+    enum class Format { Gzip, RawDeflate };
+
+    DeflateDevice(QIODevice *dst, Format fmt, int level = Z_DEFAULT_COMPRESSION) : target(dst) {
+        zlibReady = deflateInit2(&zs, level, Z_DEFLATED, fmt == Format::Gzip ? 16 + MAX_WBITS : -MAX_WBITS,
+                                 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        output.resize(kInflateInputSize);
+        open(QIODevice::WriteOnly);
+    }
+
+    ~DeflateDevice() override {
+        if (zlibReady) deflateEnd(&zs);
+    }
+
+    bool isSequential() const override { return true; }
+
+    bool finish() {
+        return zlibReady && pump(Z_FINISH);
+    }
+
+    quint32 inputCrc() const { return crc; }
+    qint64 inputSize() const { return inSize; }
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+
+    qint64 writeData(const char *data, qint64 size) override {
+        if (!zlibReady) return -1;
+        for (qint64 done = 0; done < size;) {
+            const uInt n = static_cast<uInt>(qMin<qint64>(size - done, 1 << 30));
+            const auto *p = reinterpret_cast<const Bytef*>(data + done);
+            crc = static_cast<quint32>(crc32(crc, p, n));
+            zs.next_in = const_cast<Bytef*>(p);
+            zs.avail_in = n;
+            if (!pump(Z_NO_FLUSH)) {
+                setErrorString(target->errorString());
+                return -1;
+            }
+            done += n;
+        }
+        inSize += size;
+        return size;
+    }
+
+private:
+    QIODevice *target;
+    z_stream zs{};
+    bool zlibReady = false;
+    QByteArray output;
+    quint32 crc = 0;
+    qint64 inSize = 0;
+
+    bool pump(int flush) {
+        for (;;) {
+            zs.next_out = reinterpret_cast<Bytef*>(output.data());
+            zs.avail_out = static_cast<uInt>(output.size());
+            const int rc = deflate(&zs, flush);
+            if (rc == Z_STREAM_ERROR) return false;
+            const qint64 have = output.size() - zs.avail_out;
+            if (have > 0 && target->write(output.constData(), have) != have) return false;
+            if (flush == Z_FINISH) {
+                if (rc == Z_STREAM_END) return true;
+            } else if (zs.avail_in == 0 && zs.avail_out != 0) {
+                return true;
+            }
+        }
+    }
+};
+
+// 推送式的 gzip 解压（可含多个成员）：feed() 依次送入任意切分的压缩数据，解出的数据通过 sink 交出（视图只在回调期间有效）。
+// 用于数据由外部推送进来、不能按需读取的场合，如脱敏服务收到的上传
+class GzipInflater {
+public:
+    using Sink = std::function<bool(QByteArrayView)>;
+
+    explicit GzipInflater(Sink sink);
+    ~GzipInflater();
+    GzipInflater(const GzipInflater &) = delete;
+    GzipInflater &operator=(const GzipInflater &) = delete;
+
+    // 数据有误或 sink 中止时返回 false，原因见 errorString()
+    bool feed(QByteArrayView data);
+    // 输入结束；最后一个成员不完整时返回 false
+    bool finish();
+
+    const QString &errorString() const { return error; }
+
+private:
+    Sink sink;
+    z_stream zs{};
+    bool zlibReady = false;
+    bool memberDone = false;   // 已解完至少一个成员
+    bool trailing = false;     // 最后一个成员之后无法识别的数据，视为尾部填充
+    QByteArray output;
+    QString error;
+
+    bool fail(const QString &message);
+};
+
+// 压缩包中的文件名：合法 UTF-8 按 UTF-8，否则按本地编码
+QString decodeEntryName(const QByteArray &raw, bool utf8Flag);
+
+// ---- zip ----
+
+struct ZipEntryInfo {
+    QString name;
+    quint16 flags = 0;
+    quint16 method = 0;
+    quint16 dosTime = 0;
+    quint16 dosDate = 0;
+    quint32 crc = 0;
+    quint64 compressedSize = 0;
+    quint64 uncompressedSize = 0;
+    quint64 localHeaderOffset = 0;
+    QByteArray extra;   // 中央目录中除 Zip64 以外的扩展字段（时间戳、AES 加密参数等），重新打包时原样写回
+};
+
+
+// 读取 zip 中央目录（支持 Zip64）；withDirectories 为 false 时只返回文件条目
+bool readZipDirectory(QFile &f, QList<ZipEntryInfo> &entries, QString *errorOut, bool withDirectories = false);
+
+// 定位到条目的压缩数据开头（跳过本地文件头）
+bool seekZipEntryData(QFile &file, const ZipEntryInfo &entry);
+
+// 打开 zip 中的一个条目，返回解压后的数据流（支持存储与 deflate）
+std::unique_ptr<QIODevice> openZipEntry(const QString &zipPath, const ZipEntryInfo &entry, QString *errorOut);
+
+// ---- tar ----
+
+struct TarEntryInfo {
+    QString name;
+    qint64 size = 0;
+    quint32 mode = 0644;
+    qint64 mtime = 0;
+    char type = '0';        // 条目类型：'0' 普通文件，'5' 目录，'2' 符号链接，'1' 硬链接等
+    QString linkName;       // 链接的目标
+    QByteArray rawHeader;   // 非普通文件的原始条目头，重新打包时原样写回
+
+    bool isRegular() const { return type == '0' || type == '\0' || type == '7'; }
+};
+
+// GNU 长文件名 / pax 扩展头的大小上限，超过视为损坏
+constexpr qint64 kTarMetaLimit = 1 << 20;
+
+// 顺序读取 tar 流（通常套在 gzip 解压流之上），支持 ustar 前缀、GNU 长文件名与 pax path/size
+class TarReader {
+public:
+    explicit TarReader(std::unique_ptr<QIODevice> src) : source(std::move(src)) {}
+
+    // 前进到下一个条目（自动跳过当前条目余下的数据），结束或出错时返回 false。
+    // allTypes 为 false 时只返回普通文件，跳过目录、链接等其他条目
+    bool next(TarEntryInfo &entry, bool allTypes = false) {
+        if (!skip(entryRemaining + entryPadding)) return false;
+        entryRemaining = entryPadding = 0;
+
+        QByteArray longName;
+        QByteArray longLink;
+        qint64 paxSize = -1;
+        for (;;) {
+            char h[512];
+            const qint64 got = readChunk(*source, h, 512);
+            if (got < 0) { error = source->errorString(); return false; }
+            if (got == 0 || isZeroBlock(h)) return false;
+            if (got != 512) { error = "tar 数据被截断"; return false; }
+
+            const char type = h[156];
+            const bool isMeta = type == 'L' || type == 'K' || type == 'x';
+            const qint64 size = !isMeta && paxSize >= 0 ? paxSize : parseSize(h + 124);
+            if (size < 0 || (isMeta && size > kTarMetaLimit)) { error = "tar 条目头损坏"; return false; }
+            const qint64 padding = (512 - size % 512) % 512;
+
+            if (isMeta) {
+                QByteArray meta(size, Qt::Uninitialized);
+                if (readChunk(*source, meta.data(), size) != size || !skip(padding)) { error = "tar 数据被截断"; return false; }
+                if (type == 'L') longName = QByteArray(meta.constData());
+                else if (type == 'K') longLink = QByteArray(meta.constData());
+                else parsePax(meta, longName, longLink, paxSize);
+                continue;
+            }
+            entry.type = type;
+            // pax 全局头只是元数据，不是条目
+            if (type == 'g' || (!allTypes && !entry.isRegular())) {
+                if (!skip(size + padding)) return false;
+                longName.clear();
+                longLink.clear();
+                paxSize = -1;
+                continue;
+            }
+
+            QByteArray raw = longName;
+            if (raw.isEmpty()) {
+                raw = QByteArray(h, int(qstrnlen(h, 100)));
+                if (std::memcmp(h + 257, "ustar", 5) == 0 && h[345] != '\0')
+                    raw = QByteArray(h + 345, int(qstrnlen(h + 345, 155))) + '/' + raw;
+            }
+            entry.name = decodeEntryName(raw, false);
+            entry.size = size;
+            entry.mode = quint32(qMax<qint64>(parseSize(h + 100, 8), 0) & 07777);
+            entry.mtime = qMax<qint64>(parseSize(h + 136), 0);
+            if (longLink.isEmpty()) longLink = QByteArray(h + 157, int(qstrnlen(h + 157, 100)));
+            entry.linkName = decodeEntryName(longLink, false);
+            entry.rawHeader = entry.isRegular() ? QByteArray() : QByteArray(h, 512);
+            entryRemaining = size;
+            entryPadding = padding;
+            return true;
+        }
+    }
+
+    // 读取当前条目的数据，条目结束时返回 0
+    qint64 readEntryData(char *data, qint64 maxSize) {
+        const qint64 want = qMin(maxSize, entryRemaining);
+        if (want <= 0) return 0;
+        const qint64 got = source->read(data, want);
+        if (got < 0) { error = source->errorString(); return -1; }
+        if (got == 0) { error = "tar 数据被截断"; return -1; }
+        entryRemaining -= got;
+        return got;
+    }
+
+    QString errorString() const { return error; }
+
+private:
+    std::unique_ptr<QIODevice> source;
+    qint64 entryRemaining = 0;
+    qint64 entryPadding = 0;
+    QString error;
+
+    static bool isZeroBlock(const char *h) {
+        for (int i = 0; i < 512; ++i)
+            if (h[i]) return false;
+        return true;
+    }
+
+    // 八进制文本，或 GNU 的 base-256 二进制（首字节最高位为 1）；width 为字段宽度
+    static qint64 parseSize(const char *f, int width = 12) {
+        const auto *u = reinterpret_cast<const uchar*>(f);
+        qint64 v = 0;
+        if (u[0] & 0x80) {
+            for (int i = 1; i < width; ++i) v = (v << 8) | u[i];
+            return v;
+        }
+        for (int i = 0; i < width && f[i]; ++i) {
+            if (f[i] == ' ') continue;
+            if (f[i] < '0' || f[i] > '7') return -1;
+            v = v * 8 + (f[i] - '0');
+        }
+        return v;
+    }
+
+    // pax 记录格式："<长度> <键>=<值>\n"
+    static void parsePax(const QByteArray &meta, QByteArray &path, QByteArray &linkPath, qint64 &size) {
+        qsizetype pos = 0;
+        while (pos < meta.size()) {
+            const qsizetype sp = meta.indexOf(' ', pos);
+            if (sp < 0) break;
+            const qsizetype len = meta.mid(pos, sp - pos).toLongLong();
+            if (len <= 0 || pos + len > meta.size()) break;
+            const QByteArray record = meta.mid(sp + 1, pos + len - sp - 2);
+            if (record.startsWith("path=")) path = record.mid(5);
+            else if (record.startsWith("linkpath=")) linkPath = record.mid(9);
+            else if (record.startsWith("size=")) size = record.mid(5).toLongLong();
+            pos += len;
+        }
+    }
+
+    bool skip(qint64 n) {
+        char buf[4096];
+        while (n > 0) {
+            const qint64 got = source->read(buf, qMin<qint64>(n, sizeof(buf)));
+            if (got <= 0) { error = got < 0 ? source->errorString() : QString("tar 数据被截断"); return false; }
+            n -= got;
+        }
+        return true;
+    }
+};
+
+
+std::unique_ptr<TarReader> openTarGz(const QString &path, QString *errorOut);
+
+// 打开日志源：普通文件直接读取，压缩包返回其中日志条目解压后的数据流
+std::unique_ptr<QIODevice> openLogSource(const QString &path, QString *entryNameOut = nullptr, QString *errorOut = nullptr);
+
+// 读取普通文本文件
+QByteArray readPlainFile(const QString &path, TaskProgress *progress = nullptr);
+
+// 把普通文件映射到内存，返回直接指向映射的 QByteArray（fromRawData，不复制、不占堆内存），
+// 编码识别、扫描与预览索引都直接在映射上进行。mapping 持有打开的文件（关闭即解除映射），
+// 使用返回值期间必须保持其存活。映射失败（如 32 位系统上的超大文件）时退回整体读取，mapping 为空
+QByteArray mapPlainFile(const QString &path, std::shared_ptr<QFile> &mapping, TaskProgress *progress = nullptr);
+
+// 读取 .gz / .zip / .tar.gz 中的日志；压缩包中优先第一个 .log/.txt，pickedNameOut 为选中的条目名
+QByteArray readGzFile(const QString &path, TaskProgress *progress = nullptr);
+QByteArray readZipEntryText(const QString &zipPath, QString *pickedNameOut = nullptr, TaskProgress *progress = nullptr);
+QByteArray readTarGzEntryText(const QString &tgzPath, QString *pickedNameOut = nullptr, TaskProgress *progress = nullptr);
+
+} // namespace mcla
@@ -0,0 +1,114 @@
+#include "metrics.h"
+
+#include <QMutexLocker>
+#include <QStringList>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace mcla {
+
+void RunMetrics::add(const QString &stage, qint64 ns, qint64 bytesIn, qint64 bytesOut) {
+    QMutexLocker locker(&lock);
+    auto it = stats.find(stage);
+    if (it == stats.end()) {
+        order.append(stage);
+        it = stats.insert(stage, StageStats());
+    }
+    it->ns += ns;
+    it->bytesIn += bytesIn;
+    it->bytesOut += bytesOut;
+    ++it->count;
+}
+
+void RunMetrics::set(const QString &stage, qint64 ns, qint64 bytesIn, qint64 bytesOut) {
+    QMutexLocker locker(&lock);
+    if (!stats.contains(stage)) order.append(stage);
+    stats.insert(stage, StageStats{ ns, bytesIn, bytesOut, 1 });
+}
+
+void RunMetrics::clear() {
+    QMutexLocker locker(&lock);
+    order.clear();
+    stats.clear();
+}
+
+QList<QPair<QString, StageStats>> RunMetrics::stages() const {
+    QMutexLocker locker(&lock);
+    QList<QPair<QString, StageStats>> result;
+    for (const QString &stage : order) result.append({ stage, stats.value(stage) });
+    return result;
+}
+
+// 状态栏中显示的阶段名
+static QString stageLabel(const QString &stage) {
+    static const QHash<QString, QString> labels{
+        { "load", "读取" }, { "detect", "编码识别" }, { "redact", "脱敏" }, { "write", "写出" },
+        { "stream", "流式脱敏" }, { "archive", "整包脱敏" }, { "copy", "复制" },
+        { "hash", "内容哈希" }, { "cache", "缓存命中" },
+    };
+    return labels.value(stage, stage);
+}
+
+QString RunMetrics::summary() const {
+    QStringList parts;
+    for (const auto &[stage, s] : stages()) {
+        QString part = QString("%1 %2 ms").arg(stageLabel(stage)).arg(s.ns / 1e6, 0, 'f', s.ns < 10000000 ? 1 : 0);
+        if (s.bytesIn >= (1 << 20)) part += QString("（%1 MiB/s）").arg(s.mibPerSecond(), 0, 'f', 0);
+        parts << part;
+    }
+    const qint64 rss = peakRssBytes();
+    if (rss > 0) parts << QString("峰值内存 %1 MiB").arg(rss >> 20);
+    return parts.join(" · ");
+}
+
+QJsonObject RunMetrics::toJson() const {
+    QJsonObject json;
+    for (const auto &[stage, s] : stages()) {
+        json.insert(stage, QJsonObject{
+            { "ms", s.ns / 1e6 },
+            { "bytesIn", s.bytesIn },
+            { "bytesOut", s.bytesOut },
+            { "mibPerSec", s.mibPerSecond() },
+            { "count", s.count },
+        });
+    }
+    return json;
+}
+
+qint64 peakRssBytes() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+    return qint64(counters.PeakWorkingSetSize);
+#elif defined(Q_OS_UNIX)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#if defined(Q_OS_DARWIN)
+    return qint64(usage.ru_maxrss);          // macOS 以字节为单位
+#else
+    return qint64(usage.ru_maxrss) * 1024;   // Linux 以 KiB 为单位
+#endif
+#else
+    return -1;
+#endif
+}
+
+QJsonObject ruleHitsJson(const RuleSet &rules, const TaskProgress &stats) {
+    QJsonObject json;
+    for (int i = 0; i < rules.ruleCount(); ++i) {
+        const QString &name = rules.rule(i).name;
+        const qint64 hits = stats.hits[size_t(i)].load(std::memory_order_relaxed);
+        json.insert(name, json.value(name).toInteger() + hits);
+    }
+    return json;
+}
+
+} // namespace mcla
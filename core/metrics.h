@@ -0,0 +1,58 @@
+#pragma once
+
+// ---------------------------- 性能统计 ----------------------------
+// 记录各处理阶段（读取、编码识别、脱敏、写出……）的耗时与数据量，以及进程的峰值内存。
+// 图形界面在状态栏显示，命令行批处理可输出 JSON 报告（--report），便于发现性能退化与估算机器配置
+
+#include "progress.h"
+#include "rules.h"
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+namespace mcla {
+
+// 一个阶段累计的耗时与数据量；多个文件（或线程）的同一阶段累加在一起
+struct StageStats {
+    qint64 ns = 0;
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+    qint64 count = 0;   // 累加的次数
+
+    double mibPerSecond() const { return ns > 0 ? bytesIn / (1024.0 * 1024.0) / (ns / 1e9) : 0; }
+};
+
+// 一次运行（界面中的一个文件，或一次批处理）的各阶段统计，可由多个线程同时累加
+class RunMetrics {
+public:
+    // 阶段名用 load / detect / redact / write / stream / archive 等英文键，JSON 报告中原样输出
+    void add(const QString &stage, qint64 ns, qint64 bytesIn, qint64 bytesOut = 0);
+    // 与 add 相同，但替换该阶段之前的记录（界面中重复的操作只显示最近一次）
+    void set(const QString &stage, qint64 ns, qint64 bytesIn, qint64 bytesOut = 0);
+    void clear();
+
+    // 按首次出现的顺序
+    QList<QPair<QString, StageStats>> stages() const;
+
+    // 状态栏用的一行说明，如“读取 120 ms · 脱敏 40 ms（1024 MiB/s） · 峰值内存 350 MiB”
+    QString summary() const;
+
+    // {"<阶段>": {"ms", "bytesIn", "bytesOut", "mibPerSec", "count"}, ...}
+    QJsonObject toJson() const;
+
+private:
+    mutable QMutex lock;
+    QList<QString> order;
+    QHash<QString, StageStats> stats;
+};
+
+// 进程启动以来的峰值常驻内存（字节），不支持的平台返回 -1
+qint64 peakRssBytes();
+
+// 各规则的命中次数：{"<规则名>": 次数}，同名规则累加
+QJsonObject ruleHitsJson(const RuleSet &rules, const TaskProgress &stats);
+
+} // namespace mcla
@@ -0,0 +1,52 @@
+#pragma once
+
+// ---------------------------- 进度与取消 ----------------------------
+
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+
+namespace mcla {
+
+// 一个规则文件中最多的规则条数
+constexpr int kMaxRules = 64;
+
+// 后台任务的进度：工作线程累加 done，界面线程定时读取；cancelled 由界面线程设置，工作线程在每块数据后检查。
+// hits 为各条规则的命中次数，由各个工作线程在处理完一段数据后累加。
+// 设置了 parent 的是其中一个子任务：进度与命中次数同时累加到 parent，parent 被取消时子任务也视为取消
+struct TaskProgress {
+    std::atomic<qint64> done{0};
+    std::atomic<qint64> total{0};   // 0 表示总量未知
+    std::atomic<bool> cancelled{false};
+    std::array<std::atomic<qint64>, kMaxRules> hits{};
+    TaskProgress *parent = nullptr;
+
+    TaskProgress() = default;
+    explicit TaskProgress(TaskProgress *parent) : parent(parent) {}
+
+    void addHits(const std::array<qint64, kMaxRules> &counts) {
+        for (int i = 0; i < kMaxRules; ++i)
+            if (counts[size_t(i)]) hits[size_t(i)].fetch_add(counts[size_t(i)], std::memory_order_relaxed);
+        if (parent) parent->addHits(counts);
+    }
+
+    std::array<qint64, kMaxRules> hitCounts() const {
+        std::array<qint64, kMaxRules> counts{};
+        for (int i = 0; i < kMaxRules; ++i) counts[size_t(i)] = hits[size_t(i)].load(std::memory_order_relaxed);
+        return counts;
+    }
+
+    // 记录又处理了 n 个单位，返回 false 表示任务已被取消
+    bool advance(qint64 n) {
+        done.fetch_add(n, std::memory_order_relaxed);
+        if (parent) parent->done.fetch_add(n, std::memory_order_relaxed);
+        return !isCancelled();
+    }
+
+    bool isCancelled() const {
+        return cancelled.load(std::memory_order_relaxed) || (parent && parent->isCancelled());
+    }
+};
+
+} // namespace mcla
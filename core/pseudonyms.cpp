@@ -0,0 +1,169 @@
+#include "pseudonyms.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstdio>
+#include <cstring>
+
+namespace mcla {
+
+PseudonymTable::PseudonymTable() : ports(new std::atomic<quint32>[kMaxPort + 1]) {
+    for (quint32 p = 0; p <= kMaxPort; ++p) ports[p].store(0, std::memory_order_relaxed);
+    for (Shard &shard : shards) shard.slots.assign(kInitialSlots, 0);
+}
+
+quint32 PseudonymTable::ipIndex(quint32 addr, LocalCache *cache) {
+    if (cache) {
+        if (const quint32 hit = cache->find(addr)) return hit;
+    }
+    const quint64 h = hashOf(addr);
+    Shard &shard = shards[h >> (64 - kShardBits)];
+    QMutexLocker lock(&shard.lock);
+    quint64 *slot = findSlot(shard, h, addr);
+    if (!*slot) {
+        if ((shard.used + 1) * 4 > qsizetype(shard.slots.size()) * 3) {
+            grow(shard);
+            slot = findSlot(shard, h, addr);
+        }
+        *slot = (quint64(nextIp.fetch_add(1, std::memory_order_relaxed)) << 32) | addr;
+        ++shard.used;
+    }
+    const quint32 index = quint32(*slot >> 32);
+    if (cache) cache->store(addr, index);
+    return index;
+}
+
+bool PseudonymTable::appendToken(QByteArray &out, const char *s, qsizetype start, qsizetype end, LocalCache *cache) {
+    qsizetype p = start;
+    while (p < end && !isAsciiDigit(s[p])) ++p;
+    DottedQuad q;
+    if (p == end || !parseDottedQuad(s, p, end, q)) return false;
+    qint64 port = -1;
+    if (q.end < end) {
+        if (s[q.end] != ':' || end - q.end - 1 < 1 || end - q.end - 1 > 5) return false;
+        port = 0;
+        for (qsizetype i = q.end + 1; i < end; ++i) {
+            if (!isAsciiDigit(s[i])) return false;
+            port = port * 10 + (s[i] - '0');
+        }
+    }
+    quint32 addr = 0;
+    for (int k = 0; k < 4; ++k) {
+        const qsizetype runEnd = k < 3 ? q.runStart[k + 1] - 1 : q.end;
+        quint32 octet = 0;
+        for (qsizetype i = q.runStart[k]; i < runEnd; ++i) octet = octet * 10 + quint32(s[i] - '0');
+        addr = (addr << 8) | octet;
+    }
+    out.append(s + start, p - start);
+    appendNumbered(out, "IP-", ipIndex(addr, cache), 4);
+    if (port >= 0) {
+        out.append(':');
+        appendNumbered(out, "PORT-", portIndex(quint32(port)), 2);
+    }
+    return true;
+}
+
+bool PseudonymTable::load(const QString &path, QString *errorOut) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = f.errorString();
+        return false;
+    }
+    const QByteArray data = f.readAll();
+    const char *d = data.constData();
+    if (data.size() < 16 || !data.startsWith(kMagic)) {
+        if (errorOut) *errorOut = "不是有效的编号表文件";
+        return false;
+    }
+    const quint32 ipN = qFromLittleEndian<quint32>(d + 8);
+    const quint32 portN = qFromLittleEndian<quint32>(d + 12);
+    if (data.size() != 16 + 4 * (qint64(ipN) + portN) || portN > kMaxPort + 1) {
+        if (errorOut) *errorOut = "编号表文件已损坏";
+        return false;
+    }
+    // 只能载入到空表中，保证文件中的编号原样保留
+    if (ipCount() != 0 || portCount() != 0) {
+        if (errorOut) *errorOut = "编号表已在使用中";
+        return false;
+    }
+    for (quint32 i = 0; i < ipN; ++i) ipIndex(qFromLittleEndian<quint32>(d + 16 + 4 * qint64(i)));
+    for (quint32 i = 0; i < portN; ++i) {
+        const quint32 port = qFromLittleEndian<quint32>(d + 16 + 4 * (qint64(ipN) + i));
+        if (port > kMaxPort || portIndex(port) != i + 1) {
+            if (errorOut) *errorOut = "编号表文件已损坏";
+            return false;
+        }
+    }
+    if (ipCount() != qsizetype(ipN)) {
+        if (errorOut) *errorOut = "编号表文件中有重复的地址";
+        return false;
+    }
+    return true;
+}
+
+bool PseudonymTable::save(const QString &path, QString *errorOut) const {
+    const quint32 ipN = quint32(ipCount());
+    const quint32 portN = quint32(portCount());
+    QByteArray data(16 + 4 * (qint64(ipN) + portN), Qt::Uninitialized);
+    char *d = data.data();
+    std::memcpy(d, kMagic, 8);
+    qToLittleEndian(ipN, d + 8);
+    qToLittleEndian(portN, d + 12);
+    for (const Shard &shard : shards) {
+        QMutexLocker lock(&shard.lock);
+        for (quint64 v : shard.slots)
+            if (v && quint32(v >> 32) <= ipN) qToLittleEndian(quint32(v), d + 16 + 4 * (qint64(v >> 32) - 1));
+    }
+    for (quint32 port = 0; port <= kMaxPort; ++port) {
+        const quint32 index = ports[port].load(std::memory_order_relaxed);
+        if (index && index <= portN) qToLittleEndian(port, d + 16 + 4 * (qint64(ipN) + index - 1));
+    }
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly) || f.write(data) != data.size() || !f.commit()) {
+        if (errorOut) *errorOut = f.errorString();
+        return false;
+    }
+    return true;
+}
+
+quint64 *PseudonymTable::findSlot(Shard &shard, quint64 h, quint32 addr) {
+    const size_t mask = shard.slots.size() - 1;
+    for (size_t i = size_t(h) & mask;; i = (i + 1) & mask) {
+        quint64 &slot = shard.slots[i];
+        if (!slot || quint32(slot) == addr) return &slot;
+    }
+}
+
+void PseudonymTable::grow(Shard &shard) {
+    std::vector<quint64> old(shard.slots.size() * 2, 0);
+    old.swap(shard.slots);
+    for (quint64 v : old)
+        if (v) *findSlot(shard, hashOf(quint32(v)), quint32(v)) = v;
+}
+
+void PseudonymTable::appendNumbered(QByteArray &out, const char *prefix, quint32 value, int width) {
+    char buf[24];
+    const int len = std::snprintf(buf, sizeof buf, "%s%0*u", prefix, width, value);
+    out.append(buf, len);
+}
+
+bool ruleMayContainIpv4(RuleKind kind) {
+    return kind == RuleKind::Ipv4Port || kind == RuleKind::Ipv4 || kind == RuleKind::Connection;
+}
+
+static QMutex activePseudonymsMutex;
+static PseudonymTablePtr activePseudonyms;
+
+PseudonymTablePtr activePseudonymTable() {
+    QMutexLocker lock(&activePseudonymsMutex);
+    return activePseudonyms;
+}
+
+void setActivePseudonymTable(PseudonymTablePtr table) {
+    QMutexLocker lock(&activePseudonymsMutex);
+    activePseudonyms = std::move(table);
+}
+
+} // namespace mcla
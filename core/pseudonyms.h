@@ -0,0 +1,107 @@
+#pragma once
+
+// ---------------------------- 一致化替换 ----------------------------
+// 不再直接删除 IPv4 地址，而是把每个不同的地址、端口换成固定编号（IP-0001:PORT-07），
+// 同一玩家的多次连接仍能对上号。编号表可保存到文件，批处理的所有文件共用同一份编号
+
+#include "rules.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace mcla {
+
+// 地址 → 编号的开放寻址哈希表（线性探测）。每个槽位 8 字节：高 32 位为编号（从 1 开始，0 表示空槽），
+// 低 32 位为地址。按哈希值的高位分成若干分片各自加锁，多个线程同时处理不同文件时很少互相等待
+class PseudonymTable {
+public:
+    static constexpr quint32 kMaxPort = 99999;   // 与 \d{1,5} 一致
+
+    // 每个处理线程各自持有的直接映射缓存，命中时不需要加锁。
+    // 槽位在第一次 store() 时才分配：每个 Redactor 都带一个，不做一致化替换的（如界面中只找命中的扫描器）不占内存
+    class LocalCache {
+    public:
+        quint32 find(quint32 addr) const {
+            if (slots.empty()) return 0;
+            const quint64 v = slots[hashOf(addr) & (kSize - 1)];
+            return quint32(v) == addr ? quint32(v >> 32) : 0;
+        }
+        void store(quint32 addr, quint32 index) {
+            if (slots.empty()) slots.assign(kSize, 0);
+            slots[hashOf(addr) & (kSize - 1)] = (quint64(index) << 32) | addr;
+        }
+    private:
+        static constexpr size_t kSize = 1 << 14;
+        std::vector<quint64> slots;
+    };
+
+    PseudonymTable();
+
+    // 地址的编号，没有时分配一个新编号
+    quint32 ipIndex(quint32 addr, LocalCache *cache = nullptr);
+
+    quint32 portIndex(quint32 port) {
+        std::atomic<quint32> &entry = ports[port];
+        if (const quint32 index = entry.load(std::memory_order_acquire)) return index;
+        QMutexLocker lock(&portLock);
+        if (!entry.load(std::memory_order_relaxed)) entry.store(nextPort++, std::memory_order_release);
+        return entry.load(std::memory_order_relaxed);
+    }
+
+    qsizetype ipCount() const { return qsizetype(nextIp.load()) - 1; }
+    qsizetype portCount() const { QMutexLocker lock(&portLock); return qsizetype(nextPort) - 1; }
+
+    // 在 out 后追加匹配区间 s[start, end) 的替换文本：区间内的 IPv4 地址与端口换成编号，
+    // 前缀（连接串开头的 /）原样保留。区间中没有 IPv4 地址（如 /主机名:端口）时返回 false
+    bool appendToken(QByteArray &out, const char *s, qsizetype start, qsizetype end, LocalCache *cache = nullptr);
+
+    // 文件格式（小端）："MCLAMAP1"、IP 个数、端口个数（各 4 字节），随后按编号顺序依次为
+    // 每个 IP 地址（4 字节）与每个端口（4 字节），编号即在表中的位置
+    bool load(const QString &path, QString *errorOut);
+    bool save(const QString &path, QString *errorOut) const;
+
+private:
+    static constexpr char kMagic[] = "MCLAMAP1";
+    static constexpr int kShardBits = 6;
+    static constexpr size_t kInitialSlots = 1024;
+
+    struct Shard {
+        mutable QMutex lock;
+        std::vector<quint64> slots;   // 大小为 2 的幂，装填率不超过 3/4
+        qsizetype used = 0;
+    };
+
+    Shard shards[1 << kShardBits];
+    std::atomic<quint32> nextIp{1};
+    std::unique_ptr<std::atomic<quint32>[]> ports;
+    mutable QMutex portLock;
+    quint32 nextPort = 1;
+
+    // splitmix64 的末尾混合：地址各位都会影响低位（槽位）与高位（分片）
+    static quint64 hashOf(quint32 addr) {
+        quint64 h = addr + 0x9E3779B97F4A7C15ull;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+        return h ^ (h >> 31);
+    }
+
+    static quint64 *findSlot(Shard &shard, quint64 h, quint32 addr);
+    static void grow(Shard &shard);
+    static void appendNumbered(QByteArray &out, const char *prefix, quint32 value, int width);
+};
+
+using PseudonymTablePtr = std::shared_ptr<PseudonymTable>;
+
+// 命中内容中可能有 IPv4 地址、一致化替换时需要编号的规则
+bool ruleMayContainIpv4(RuleKind kind);
+
+// 一致化替换使用的编号表，空表示直接删除（或按规则的替换文本替换）
+PseudonymTablePtr activePseudonymTable();
+void setActivePseudonymTable(PseudonymTablePtr table);
+
+} // namespace mcla
@@ -0,0 +1,288 @@
+#include "redactor.h"
+
+#include <QThreadPool>
+
+#include <cstring>
+
+namespace mcla {
+
+void DbcsTrailMask::apply(const char *src, char *dst, qsizetype n) {
+    for (qsizetype i = 0; i < n; ++i) {
+        const unsigned c = static_cast<unsigned char>(src[i]);
+        if (trailLeft > 0) {
+            dst[i] = char(0x80);
+            --trailLeft;
+            continue;
+        }
+        if (trailLeft < 0) {
+            // 首字节之后：按第二字节决定字符长度；不合法的第二字节按普通字符处理
+            trailLeft = 0;
+            if (c >= 0x30 && c <= 0x39) { dst[i] = char(0x80); trailLeft = 2; continue; }
+            if (c >= 0x40 && c != 0x7F && c != 0xFF) { dst[i] = char(0x80); continue; }
+        }
+        dst[i] = src[i];
+        if (c >= 0x81 && c != 0xFF) trailLeft = -1;
+    }
+}
+
+// 各规则的替换文本按 enc 编码好
+static QList<QByteArray> encodedReplacements(const RuleSet &rules, const TextEncoding &enc) {
+    QList<QByteArray> out;
+    QStringEncoder encoder = enc.encoder();
+    for (int i = 0; i < rules.ruleCount(); ++i) out << QByteArray(encoder.encode(rules.rule(i).replacement));
+    return out;
+}
+
+Redactor::Redactor(RuleSetPtr rules, const TextEncoding &enc, bool pseudonymize)
+    : rules(std::move(rules)), pseudonyms(pseudonymize ? activePseudonymTable() : nullptr) {
+    replacements = encodedReplacements(*this->rules, enc);
+}
+
+std::vector<qsizetype> lineAlignedChunks(const QByteArray &data, qsizetype sliceSize) {
+    std::vector<qsizetype> bounds{ 0 };
+    const qsizetype n = data.size();
+    for (qsizetype target = sliceSize; target < n; target = bounds.back() + sliceSize) {
+        const void *nl = std::memchr(data.constData() + target, '\n', size_t(n - target));
+        if (!nl) break;
+        bounds.push_back(static_cast<const char*>(nl) - data.constData() + 1);
+    }
+    if (bounds.back() != n) bounds.push_back(n);
+    return bounds;
+}
+
+bool redactBytes(const QByteArray &data, const TextEncoding &enc, RedactedLog &result,
+                 TaskProgress *progress, int jobs) {
+    const RuleSetPtr rules = activeRuleSet();
+    const qsizetype n = data.size();
+    const std::vector<qsizetype> bounds = lineAlignedChunks(data, kScanSliceSize);
+    const qsizetype chunkCount = qsizetype(bounds.size()) - 1;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(int(qBound<qsizetype>(1, jobs, qMax<qsizetype>(1, chunkCount))));
+    auto forEachChunk = [&](const std::function<void(qsizetype)> &work) {
+        if (pool.maxThreadCount() == 1) {
+            for (qsizetype k = 0; k < chunkCount; ++k) work(k);
+            return;
+        }
+        for (qsizetype k = 0; k < chunkCount; ++k) pool.start([&work, k] { work(k); });
+        pool.waitForDone();
+    };
+
+    QByteArray shadow;
+    const char *s = data.constData();
+    if (enc.isDoubleByte()) {
+        shadow.resize(n);
+        char *dst = shadow.data();
+        // 各段从初始状态并行改写；前一段结尾停在多字节字符中间时（只有不合法的数据会这样）按实际状态重做
+        std::vector<int> endState(size_t(chunkCount), 0);
+        forEachChunk([&](qsizetype k) {
+            DbcsTrailMask mask;
+            mask.apply(data.constData() + bounds[k], dst + bounds[k], bounds[k + 1] - bounds[k]);
+            endState[size_t(k)] = mask.state();
+        });
+        for (qsizetype k = 1; k < chunkCount; ++k) {
+            if (endState[size_t(k - 1)] == 0) continue;
+            DbcsTrailMask mask(endState[size_t(k - 1)]);
+            mask.apply(data.constData() + bounds[k], dst + bounds[k], bounds[k + 1] - bounds[k]);
+            endState[size_t(k)] = mask.state();
+        }
+        s = shadow.constData();
+    }
+
+    // 一致化替换的编号按首次出现的顺序分配，多段并行时先不分配，拼接后再按顺序补上
+    const bool deferPseudonyms = chunkCount > 1 && activePseudonymTable();
+    std::vector<RedactedLog> parts(size_t(chunkCount));
+    forEachChunk([&](qsizetype k) {
+        if (progress && progress->isCancelled()) return;
+        Redactor redactor(rules, enc, !deferPseudonyms);
+        RedactedLog &part = parts[size_t(k)];
+        rules->scan(s, data.constData(), bounds[k], bounds[k + 1], true, [&](qsizetype start, qsizetype end, int rule) {
+            redactor.append(part.replacements, s, start, end, rule);
+            part.replacementEnds.append(part.replacements.size());
+            part.spans.append({ start, end, rule });
+        });
+        if (progress) {
+            progress->addHits(redactor.hitCounts());
+            progress->advance(bounds[k + 1] - bounds[k]);
+        }
+    });
+    if (progress && progress->isCancelled()) return false;
+
+    result = RedactedLog();
+    qsizetype spanCount = 0, replacementSize = 0;
+    for (const RedactedLog &part : parts) {
+        spanCount += part.spans.size();
+        replacementSize += part.replacements.size();
+    }
+    result.spans.reserve(spanCount);
+    result.replacementEnds.reserve(spanCount);
+    result.replacements.reserve(replacementSize);
+    for (RedactedLog &part : parts) {
+        const qsizetype offset = result.replacements.size();
+        result.spans.append(part.spans);
+        for (qsizetype end : part.replacementEnds) result.replacementEnds.append(offset + end);
+        result.replacements.append(part.replacements);
+        part = RedactedLog();
+    }
+
+    if (deferPseudonyms) {
+        Redactor redactor(rules, enc);
+        QByteArray replacements;
+        QList<qsizetype> ends;
+        replacements.reserve(result.replacements.size());
+        ends.reserve(spanCount);
+        for (qsizetype i = 0; i < result.spans.size(); ++i) {
+            const TextSpan &span = result.spans[i];
+            if (!redactor.appendPseudonym(replacements, s, span.start, span.end, span.rule))
+                replacements.append(result.replacement(i));
+            ends.append(replacements.size());
+        }
+        result.replacements = replacements;
+        result.replacementEnds = ends;
+    }
+    return true;
+}
+
+void redactSegment(Redactor &redactor, QByteArrayView text, RedactedLog &result) {
+    const char *s = text.data();
+    redactor.ruleSet().scan(s, s, 0, text.size(), true, [&](qsizetype start, qsizetype end, int rule) {
+        redactor.append(result.replacements, s, start, end, rule);
+        result.replacementEnds.append(result.replacements.size());
+        result.spans.append({ start, end, rule });
+    });
+}
+
+QByteArray anonymizeBytes(const QByteArray &data, const TextEncoding &enc, int jobs) {
+    RedactedLog r;
+    redactBytes(data, enc, r, nullptr, jobs);
+    QByteArray out;
+    out.reserve(data.size());
+    forEachRedactedPiece(data, r, [&](const char *p, qsizetype n) { out.append(p, n); return true; });
+    return out;
+}
+
+ByteStreamAnonymizer::ByteStreamAnonymizer(RuleSetPtr rules, const TextEncoding &enc, OutputSink sink)
+    : redactor(std::move(rules), enc), sink(std::move(sink)), doubleByte(enc.isDoubleByte()) {}
+
+bool ByteStreamAnonymizer::feed(QByteArrayView chunk) {
+    pending.append(chunk);
+    if (doubleByte) {
+        const qsizetype old = shadow.size();
+        shadow.resize(old + chunk.size());
+        mask.apply(chunk.data(), shadow.data() + old, chunk.size());
+    }
+    if (lineBuffered) {
+        // 只在本块中找换行，之前留下的未完行里没有换行
+        const qsizetype tail = QByteArrayView(pending).sliced(pending.size() - chunk.size()).lastIndexOf('\n');
+        if (tail >= 0) return drain(pending.size() - chunk.size() + tail + 1, true);
+        if (pending.size() <= kMaxPartialLine) return true;
+    }
+    return drain(pending.size(), false);
+}
+
+bool ByteStreamAnonymizer::finish() {
+    return drain(pending.size(), true);
+}
+
+bool ByteStreamAnonymizer::drain(qsizetype limit, bool atEnd) {
+    const char *raw = pending.constData();
+    const char *s = doubleByte ? shadow.constData() : raw;
+    const qsizetype begin = atStart ? 0 : 1;
+    qsizetype last = begin;
+    bool ok = true;
+    auto put = [&](QByteArrayView piece) {
+        ok = ok && (piece.isEmpty() || sink(piece));
+    };
+    const qsizetype resume = redactor.ruleSet().scan(s, raw, begin, limit, atEnd,
+                                                     [&](qsizetype start, qsizetype end, int rule) {
+        put(QByteArrayView(raw + last, start - last));
+        put(redactor.replacement(s, start, end, rule));
+        last = end;
+    });
+    if (resume > last) put(QByteArrayView(raw + last, resume - last));
+
+    // 尚未判定的尾部连同一个上下文字节移到缓冲区开头，容量保持不变；
+    // atEnd 时 limit 之前已全部输出，之后的数据（换行后的未完行）不需要上下文字节
+    if (atEnd || resume > 0) {
+        const qsizetype from = atEnd ? limit : resume - 1;
+        const qsizetype keep = pending.size() - from;
+        std::memmove(pending.data(), pending.constData() + from, size_t(keep));
+        pending.resize(keep);
+        if (doubleByte) {
+            std::memmove(shadow.data(), shadow.constData() + from, size_t(keep));
+            shadow.resize(keep);
+        }
+        atStart = atEnd;
+    }
+    return ok;
+}
+
+StreamAnonymizer::StreamAnonymizer(OutputSink sink, RuleSetPtr rules)
+    : sink(std::move(sink)), rules(std::move(rules)) {}
+
+bool StreamAnonymizer::feed(QByteArrayView chunk) {
+    if (bytes) return process(chunk);
+    // 攒够样本再识别编码，避免调用方送入的小块导致误判；按行输出时不等待
+    head.append(chunk);
+    if (head.size() < kEncodingSampleSize && !lineBuffered) return true;
+    start(head);
+    const bool ok = process(head);
+    head = QByteArray();
+    return ok;
+}
+
+bool StreamAnonymizer::finish() {
+    if (!bytes) {
+        if (head.isEmpty()) return true;
+        start(head);
+        if (!process(head)) return false;
+        head = QByteArray();
+    }
+    return bytes->finish() && flushRedacted();
+}
+
+std::array<qint64, kMaxRules> StreamAnonymizer::hitCounts() const {
+    return bytes ? bytes->hitCounts() : std::array<qint64, kMaxRules>{};
+}
+
+void StreamAnonymizer::detectEncoding(QByteArrayView sample) {
+    if (!bytes) start(sample);
+}
+
+void StreamAnonymizer::start(QByteArrayView sample) {
+    enc = detectTextEncoding(sample.data(), sample.size());
+    if (enc.isAsciiCompatible()) {
+        bytes = std::make_unique<ByteStreamAnonymizer>(rules, enc, [this](QByteArrayView piece) { return sink(piece); });
+    } else {
+        decoder = enc.decoder();
+        encoder = enc.encoder(enc.bom ? QStringConverter::Flag::WriteBom : QStringConverter::Flag::Default);
+        bytes = std::make_unique<ByteStreamAnonymizer>(rules, enc.working(), [this](QByteArrayView piece) {
+            redacted.append(piece);
+            return true;
+        });
+    }
+    bytes->setLineBuffered(lineBuffered);
+}
+
+bool StreamAnonymizer::process(QByteArrayView chunk) {
+    if (enc.isAsciiCompatible()) return bytes->feed(chunk);
+    // UTF-16 → UTF-8：解码器与编码器各自保存跨块的状态（半个字符、落单的高位代理）
+    text.resize(decoder.requiredSpace(chunk.size()));
+    text.resize(decoder.appendToBuffer(text.data(), chunk) - text.constData());
+    working.resize(toUtf8.requiredSpace(text.size()));
+    working.resize(toUtf8.appendToBuffer(working.data(), text) - working.constData());
+    return bytes->feed(working) && flushRedacted();
+}
+
+// 把本块的脱敏结果从 UTF-8 编码回原编码后交出
+bool StreamAnonymizer::flushRedacted() {
+    if (redacted.isEmpty()) return true;
+    text.resize(fromUtf8.requiredSpace(redacted.size()));
+    text.resize(fromUtf8.appendToBuffer(text.data(), redacted) - text.constData());
+    encoded.resize(encoder.requiredSpace(text.size()));
+    encoded.resize(encoder.appendToBuffer(encoded.data(), text) - encoded.constData());
+    redacted.resize(0);
+    return encoded.isEmpty() || sink(encoded);
+}
+
+} // namespace mcla
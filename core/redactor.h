@@ -0,0 +1,218 @@
+#pragma once
+
+// ---------------------------- 字节层面脱敏 ----------------------------
+// 各规则匹配的内容都以 ASCII 字符开头并按 ASCII 判定边界：UTF-8 与单字节编码直接扫描原始字节，
+// 输出保持原编码，不经过 QString。GB18030 等双字节编码的尾字节可能是 ASCII 数字或字母，
+// 先复制一份把多字节字符的尾字节改写为 0x80 的影子数据，在影子上扫描、从原数据复制，判定结果与按字符扫描相同
+
+#include "ipscanner.h"
+#include "progress.h"
+#include "pseudonyms.h"
+#include "rules.h"
+#include "textencoding.h"
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QStringDecoder>
+#include <QStringEncoder>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mcla {
+
+// 按 GB18030 的结构（首字节 0x81-0xFE，第二字节 0x30-0x39 时为四字节字符）改写尾字节，可跨块调用
+class DbcsTrailMask {
+public:
+    explicit DbcsTrailMask(int state = 0) : trailLeft(state) {}
+
+    // 处理到当前位置时的状态，可用来从中间接着处理
+    int state() const { return trailLeft; }
+
+    void apply(const char *src, char *dst, qsizetype n);
+
+private:
+    int trailLeft;   // >0：还需改写的尾字节数；-1：刚读到首字节
+};
+
+// 命中区间的替换：规则的替换文本（默认为空，即删除），一致化替换模式下 IPv4 地址与端口换成编号
+class Redactor {
+public:
+    // pseudonymize 为 false 时不做一致化替换（由调用方之后按顺序补上编号，见 redactBytes）
+    Redactor(RuleSetPtr rules, const TextEncoding &enc, bool pseudonymize = true);
+
+    const RuleSet &ruleSet() const { return *rules; }
+    const std::array<qint64, kMaxRules> &hitCounts() const { return hits; }
+
+    // s 为判定用的数据（影子或原始字节），命中区间内都是 ASCII，两者相同
+    void append(QByteArray &out, const char *s, qsizetype start, qsizetype end, int rule) {
+        ++hits[size_t(rule)];
+        if (!appendPseudonym(out, s, start, end, rule)) out.append(replacements[rule]);
+    }
+
+    // 与 append 相同，但不复制：返回的视图指向预先编码好的替换文本或内部的编号缓冲区，下次调用前有效
+    QByteArrayView replacement(const char *s, qsizetype start, qsizetype end, int rule) {
+        ++hits[size_t(rule)];
+        token.resize(0);   // 保留容量，不再重新分配
+        if (appendPseudonym(token, s, start, end, rule)) return token;
+        return replacements[rule];
+    }
+
+    // 一致化替换模式下追加命中的编号，不适用时返回 false
+    bool appendPseudonym(QByteArray &out, const char *s, qsizetype start, qsizetype end, int rule) {
+        return pseudonyms && ruleMayContainIpv4(rules->rule(rule).kind) && pseudonyms->appendToken(out, s, start, end, &cache);
+    }
+
+private:
+    RuleSetPtr rules;
+    PseudonymTablePtr pseudonyms;
+    PseudonymTable::LocalCache cache;
+    QList<QByteArray> replacements;
+    QByteArray token;
+    std::array<qint64, kMaxRules> hits{};
+};
+
+// 脱敏结果：不生成脱敏后的副本，只记录命中区间与各自的替换内容；
+// 导出时依次写出原文中未命中的区段与替换内容（见 writeRedacted）
+struct RedactedLog {
+    QList<TextSpan> spans;              // 按起点排序、互不重叠的命中字节区间
+    QByteArray replacements;            // 各区间的替换内容首尾相接，编码与原文相同
+    QList<qsizetype> replacementEnds;   // 第 i 个区间的替换内容结束于 replacements 中的这个位置
+
+    QByteArrayView replacement(qsizetype i) const {
+        const qsizetype from = i > 0 ? replacementEnds[i - 1] : 0;
+        return QByteArrayView(replacements.constData() + from, replacementEnds[i] - from);
+    }
+
+    // 原文为 inputSize 字节时脱敏结果的字节数
+    qsizetype outputSize(qsizetype inputSize) const {
+        qsizetype removed = 0;
+        for (const TextSpan &span : spans) removed += span.end - span.start;
+        return inputSize - removed + replacements.size();
+    }
+
+    // 各规则的命中次数
+    std::array<qint64, kMaxRules> hitCounts() const {
+        std::array<qint64, kMaxRules> counts{};
+        for (const TextSpan &span : spans)
+            if (span.rule >= 0) ++counts[size_t(span.rule)];
+        return counts;
+    }
+};
+
+// 把数据按行切成约 sliceSize 字节的若干段，返回各段的边界（首项为 0，末项为数据长度）。
+// 各规则的命中都不跨行，每段可以独立扫描，结果与整体扫描相同
+std::vector<qsizetype> lineAlignedChunks(const QByteArray &data, qsizetype sliceSize);
+
+// 按当前规则集找出字节数据中的所有命中及其替换内容；enc 必须是 ASCII 兼容编码。
+// 数据按行切段后用 jobs 个线程并行扫描，再按顺序拼接，结果与单线程完全相同。
+// 各规则的命中次数累加到 progress->hits，被取消时返回 false
+bool redactBytes(const QByteArray &data, const TextEncoding &enc, RedactedLog &result,
+                 TaskProgress *progress = nullptr, int jobs = 1);
+
+// 按顺序把 data 中未命中的区段与各区间的替换内容交给 put(const char*, qsizetype)，put 返回 false 时中止
+template <typename Put>
+bool forEachRedactedPiece(const QByteArray &data, const RedactedLog &r, Put &&put) {
+    qsizetype last = 0;
+    for (qsizetype i = 0; i < r.spans.size(); ++i) {
+        const TextSpan &span = r.spans[i];
+        const QByteArrayView rep = r.replacement(i);
+        if (!put(data.constData() + last, span.start - last) || !put(rep.data(), rep.size())) return false;
+        last = span.end;
+    }
+    return put(data.constData() + last, data.size() - last);
+}
+
+// 对一段完整的文本（如编辑框中的一行，编码为 ASCII 兼容的单字节或 UTF-8）找出所有命中及其替换内容，追加到 result。
+// 各规则的命中都不跨行，可编辑的文本改动后只需重新处理改动所在的行
+void redactSegment(Redactor &redactor, QByteArrayView text, RedactedLog &result);
+
+// 生成完整的脱敏副本，只用于对比基准
+QByteArray anonymizeBytes(const QByteArray &data, const TextEncoding &enc, int jobs = 1);
+
+// 流式接口的输出：按顺序收到脱敏后的各段数据（视图只在回调期间有效），返回 false 时中止处理
+using OutputSink = std::function<bool(QByteArrayView)>;
+
+// 分块流式脱敏（ASCII 兼容编码）：每块末尾尚未判定的少量字节（连同一个 \b 上下文字节）留到下一块；
+// 双字节编码时同样在影子数据上扫描。未命中的区段直接以指向内部缓冲区的视图交给 sink，
+// 缓冲区在块之间原地复用，块大小稳定后不再分配堆内存
+class ByteStreamAnonymizer {
+public:
+    ByteStreamAnonymizer(RuleSetPtr rules, const TextEncoding &enc, OutputSink sink);
+
+    // 追加一块数据，把已经可以确定的输出交给 sink；sink 中止时返回 false
+    bool feed(QByteArrayView chunk);
+    // 输入结束，输出剩余的全部数据
+    bool finish();
+
+    // 按行输出（跟踪模式）：每次 feed 只输出到最后一个换行为止的完整行，未完的行留到下一次。
+    // 命中不跨行，换行前的内容无需等待后续数据即可判定；超过 kMaxPartialLine 的未完行按普通方式处理
+    void setLineBuffered(bool on) { lineBuffered = on; }
+
+    const std::array<qint64, kMaxRules> &hitCounts() const { return redactor.hitCounts(); }
+
+private:
+    static constexpr qsizetype kMaxPartialLine = 1 << 20;
+
+    Redactor redactor;
+    OutputSink sink;
+    QByteArray pending;
+    QByteArray shadow;
+    DbcsTrailMask mask;
+    bool doubleByte;
+    bool atStart = true;
+    bool lineBuffered = false;
+
+    // 输出 pending[0, limit) 中可以确定的部分；atEnd 时 limit 之前全部输出，之后的数据从头开始处理
+    bool drain(qsizetype limit, bool atEnd);
+};
+
+// 推送式的流式脱敏接口，可嵌入其他程序（如日志转运）使用：feed() 依次送入任意切分的原始字节，
+// 脱敏结果按原编码通过 sink 交出。开头的 kEncodingSampleSize 字节用于识别编码；
+// UTF-16 在内部转成 UTF-8 处理后再编码回原编码。各级缓冲区在块之间复用，块大小稳定后每块不再分配堆内存
+class StreamAnonymizer {
+public:
+    explicit StreamAnonymizer(OutputSink sink, RuleSetPtr rules = activeRuleSet());
+
+    bool feed(QByteArrayView chunk);
+    bool finish();
+
+    // 按行输出，见 ByteStreamAnonymizer::setLineBuffered；同时不再攒够样本才识别编码，收到数据即开始处理
+    void setLineBuffered(bool on) {
+        lineBuffered = on;
+        if (bytes) bytes->setLineBuffered(on);
+    }
+
+    // 用 sample（如文件开头）识别编码，sample 本身不作为输入；从文件中间开始处理时使用。须在 feed 之前调用
+    void detectEncoding(QByteArrayView sample);
+
+    // 识别出的编码，识别前为默认的 UTF-8
+    const TextEncoding &encoding() const { return enc; }
+    std::array<qint64, kMaxRules> hitCounts() const;
+
+private:
+    OutputSink sink;
+    RuleSetPtr rules;
+    std::unique_ptr<ByteStreamAnonymizer> bytes;
+    TextEncoding enc;
+    QByteArray head;        // 识别编码前攒下的开头数据
+    // UTF-16 的转换缓冲区
+    QStringDecoder decoder;
+    QStringEncoder toUtf8{ QStringConverter::Utf8 };
+    QStringDecoder fromUtf8{ QStringConverter::Utf8 };
+    QStringEncoder encoder;
+    QString text;
+    QByteArray working;
+    QByteArray redacted;
+    QByteArray encoded;
+    bool lineBuffered = false;
+
+    void start(QByteArrayView sample);
+    bool process(QByteArrayView chunk);
+    bool flushRedacted();
+};
+
+} // namespace mcla
@@ -0,0 +1,248 @@
+#include "resultcache.h"
+
+#include "exportcache.h"
+#include "pseudonyms.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <vector>
+
+namespace mcla {
+
+// 脱敏算法或结果格式改变时加一，旧的缓存自然失效（2：索引记下各规则的命中次数）
+constexpr int kCacheFormatVersion = 2;
+constexpr quint32 kRedactedMagic = 0x4D434C52;   // "MCLR"
+
+ResultCache::ResultCache(const QString &directory, qint64 capacity) : dir(directory), cap(capacity) {
+    QDir().mkpath(dir);
+    index = readIndex();
+}
+
+ResultCache::~ResultCache() {
+    QMutexLocker locker(&lock);
+    if (dirty) saveIndex();
+}
+
+QString ResultCache::defaultDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/results";
+}
+
+QString ResultCache::key(quint64 contentHash, const RuleSet &rules, CachedResult kind) {
+    static const char *const suffixes[] = { "spans", "log", "log.gz", "archive" };
+    return QString("%1-%2-v%3.%4")
+        .arg(contentHash, 16, 16, QChar('0'))
+        .arg(rules.version(), 16, 16, QChar('0'))
+        .arg(kCacheFormatVersion)
+        .arg(suffixes[int(kind)]);
+}
+
+// 索引由 QSaveFile 整体替换，不持有目录锁也不会读到写了一半的内容
+ResultCache::Index ResultCache::readIndex() const {
+    Index entries;
+    QFile f(dir + "/index.json");
+    if (!f.open(QIODevice::ReadOnly)) return entries;
+    const QJsonObject object = QJsonDocument::fromJson(f.readAll()).object();
+    for (auto it = object.begin(); it != object.end(); ++it) {
+        const QJsonObject e = it.value().toObject();
+        Entry entry{ qint64(e["size"].toDouble()), qint64(e["modified"].toDouble()), {} };
+        const QJsonArray hits = e["hits"].toArray();
+        for (qsizetype i = 0; i < hits.size() && i < kMaxRules; ++i) entry.hits[size_t(i)] = qint64(hits[i].toDouble());
+        entries.insert(it.key(), entry);
+    }
+    return entries;
+}
+
+// 命中次数只写到最后一条有命中的规则为止
+static QJsonArray hitsToJson(const std::array<qint64, kMaxRules> &hits) {
+    int used = kMaxRules;
+    while (used > 0 && hits[size_t(used - 1)] == 0) --used;
+    QJsonArray array;
+    for (int i = 0; i < used; ++i) array.append(hits[size_t(i)]);
+    return array;
+}
+
+bool ResultCache::saveIndex(const QString &placed) {
+    QLockFile dirLock(dir + "/index.lock");
+    if (!dirLock.tryLock(5000)) return false;
+
+    // 其他进程放入的条目一并保留，同一个键以目录中较新的记录为准（刚放入的 placed 除外）；
+    // 文件已不存在的条目（被淘汰或删除）去掉
+    Index merged = readIndex();
+    for (auto it = index.cbegin(); it != index.cend(); ++it)
+        if (it.key() == placed || !merged.contains(it.key())) merged.insert(it.key(), it.value());
+    for (auto it = merged.begin(); it != merged.end();) {
+        if (QFileInfo::exists(dir + "/" + it.key())) ++it;
+        else it = merged.erase(it);
+    }
+    evict(merged);
+    index = std::move(merged);
+
+    QJsonObject entries;
+    for (auto it = index.cbegin(); it != index.cend(); ++it)
+        entries.insert(it.key(), QJsonObject{ { "size", it->size }, { "modified", it->modified },
+                                              { "hits", hitsToJson(it->hits) } });
+    QSaveFile out(dir + "/index.json");
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    out.write(QJsonDocument(entries).toJson(QJsonDocument::Compact));
+    if (!out.commit()) return false;
+    dirty = false;
+    return true;
+}
+
+// 总大小超过上限时按最近使用（缓存文件的访问时间）从旧到新删除
+void ResultCache::evict(Index &entries) {
+    qint64 total = 0;
+    for (const Entry &e : entries) total += e.size;
+    if (total <= cap) return;
+    std::vector<std::pair<qint64, QString>> byAge;
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        const QDateTime used = QFileInfo(dir + "/" + it.key()).lastRead();
+        byAge.emplace_back(used.isValid() ? used.toMSecsSinceEpoch() : 0, it.key());
+    }
+    std::sort(byAge.begin(), byAge.end());
+    for (const auto &[used, key] : byAge) {
+        if (total <= cap) break;
+        Q_UNUSED(used);
+        total -= entries.value(key).size;
+        QFile::remove(dir + "/" + key);
+        entries.remove(key);
+    }
+}
+
+// 记为最近使用：只改缓存文件的访问时间，不写索引。文件系统以 noatime 挂载时显式设置的时间仍然有效
+static void touchAccessTime(const QString &path) {
+    QFile f(path);
+    if (f.open(QIODevice::ReadWrite | QIODevice::ExistingOnly))
+        f.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileAccessTime);
+}
+
+QString ResultCache::lookup(const QString &key, std::array<qint64, kMaxRules> *hitsOut) {
+    QMutexLocker locker(&lock);
+    const QString path = dir + "/" + key;
+    auto it = index.find(key);
+    if (it == index.end()) {
+        // 可能是其他进程在本实例读取索引之后放入的：文件存在时才重新读一次索引
+        if (!QFileInfo::exists(path)) return QString();
+        const Index latest = readIndex();
+        for (auto e = latest.cbegin(); e != latest.cend(); ++e)
+            if (!index.contains(e.key())) index.insert(e.key(), e.value());
+        it = index.find(key);
+        if (it == index.end()) return QString();
+    }
+    const QFileInfo fi(path);
+    auto matches = [&](const Entry &e) {
+        return fi.isFile() && fi.size() == e.size && fi.lastModified().toMSecsSinceEpoch() == e.modified;
+    };
+    // 其他进程可能重新放入过同一个键，先与目录中的索引核对
+    if (!matches(*it) && fi.isFile()) {
+        const Entry latest = readIndex().value(key);
+        if (matches(latest)) *it = latest;
+    }
+    if (!matches(*it)) {
+        // 被删除或改动过
+        QFile::remove(path);
+        index.erase(it);
+        dirty = true;
+        return QString();
+    }
+    touchAccessTime(path);
+    if (hitsOut) *hitsOut = it->hits;
+    return path;
+}
+
+bool ResultCache::insert(const QString &key, const QString &file, const std::array<qint64, kMaxRules> &hits) {
+    return place(key, file, false, hits);
+}
+
+bool ResultCache::place(const QString &key, const QString &file, bool privateFile,
+                        const std::array<qint64, kMaxRules> &hits) {
+    // 复制时不持有锁；缓存文件整体替换，同时查找的线程读到的是旧文件或新文件
+    const QString path = dir + "/" + key;
+    const bool placed = privateFile ? placeFileCopy(file, path, nullptr) : copyToUserFile(file, path, nullptr);
+    if (!placed) return false;
+    const QFileInfo fi(path);
+    QMutexLocker locker(&lock);
+    index.insert(key, { fi.size(), fi.lastModified().toMSecsSinceEpoch(), hits });
+    dirty = true;   // 目录锁一时拿不到时留到析构时写回
+    saveIndex(key);
+    return index.contains(key);
+}
+
+bool ResultCache::lookupRedacted(const QString &key, qsizetype inputSize, RedactedLog &out) {
+    const QString path = lookup(key);
+    if (path.isEmpty()) return false;
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&f);
+    quint32 magic = 0;
+    qint64 spanCount = 0;
+    in >> magic >> spanCount;
+    if (magic != kRedactedMagic || spanCount < 0 || spanCount > inputSize) return false;
+
+    RedactedLog r;
+    r.spans.reserve(spanCount);
+    r.replacementEnds.reserve(spanCount);
+    qint64 last = 0, lastEnd = 0;
+    for (qint64 i = 0; i < spanCount; ++i) {
+        qint64 start, end, replacementEnd;
+        qint32 rule;
+        in >> start >> end >> rule >> replacementEnd;
+        // 区间须按顺序、互不重叠且落在原文之内
+        if (in.status() != QDataStream::Ok || start < last || end < start || end > inputSize || replacementEnd < lastEnd
+            || rule < -1 || rule >= kMaxRules)
+            return false;
+        r.spans.append({ qsizetype(start), qsizetype(end), rule });
+        r.replacementEnds.append(qsizetype(replacementEnd));
+        last = end;
+        lastEnd = replacementEnd;
+    }
+    in >> r.replacements;
+    if (in.status() != QDataStream::Ok || lastEnd != r.replacements.size()) return false;
+    out = std::move(r);
+    return true;
+}
+
+bool ResultCache::insertRedacted(const QString &key, const RedactedLog &r) {
+    // 先写到临时文件，再链接到缓存中（临时文件随即删除，不会被改动）
+    const QString temp = dir + "/" + key + ".tmp";
+    QSaveFile f(temp);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    QDataStream out(&f);
+    out << kRedactedMagic << qint64(r.spans.size());
+    for (qsizetype i = 0; i < r.spans.size(); ++i) {
+        const TextSpan &span = r.spans[i];
+        out << qint64(span.start) << qint64(span.end) << qint32(span.rule) << qint64(r.replacementEnds[i]);
+    }
+    out << r.replacements;
+    if (out.status() != QDataStream::Ok || !f.commit()) return false;
+    const bool ok = place(key, temp, true, r.hitCounts());
+    QFile::remove(temp);
+    return ok;
+}
+
+static QMutex activeCacheMutex;
+static ResultCachePtr activeCache;
+
+ResultCachePtr activeResultCache() {
+    if (activePseudonymTable()) return nullptr;
+    QMutexLocker lock(&activeCacheMutex);
+    return activeCache;
+}
+
+void setActiveResultCache(ResultCachePtr cache) {
+    QMutexLocker lock(&activeCacheMutex);
+    activeCache = std::move(cache);
+}
+
+} // namespace mcla
@@ -0,0 +1,84 @@
+#pragma once
+
+// ---------------------------- 结果缓存 ----------------------------
+// 同一个日志（如反复打开的 latest.log、轮转后的 .log.gz）再次处理时直接取出上次的结果。
+// 键由源文件原样的内容哈希（压缩文件按压缩后的字节计算，不必解压）、规则集版本与结果类型组成；
+// 缓存目录有总大小上限，超出时淘汰最久未用的条目。索引每个实例只读取一次，放入新条目时在目录锁下
+// 与目录中的索引合并（保留其他进程放入的条目）、淘汰后写回；最近使用的时间记在缓存文件的访问时间上，
+// 查找时不写索引。多个进程可以共用同一个目录
+
+#include "redactor.h"
+#include "rules.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <array>
+#include <memory>
+
+namespace mcla {
+
+enum class CachedResult {
+    Spans,        // 脱敏结果的命中区间与替换内容（RedactedLog），界面预览用
+    Output,       // 按原编码写出的脱敏文件
+    GzipOutput,   // 同上，gzip 压缩
+    Archive,      // 重新打包的压缩包
+};
+
+class ResultCache {
+public:
+    static constexpr qint64 kDefaultCapacity = 2ll << 30;
+
+    explicit ResultCache(const QString &directory, qint64 capacity = kDefaultCapacity);
+    // 有尚未写回的改动（查找时丢弃的失效条目，或放入时没能拿到目录锁）时写回索引
+    ~ResultCache();
+
+    // 系统的缓存目录下的 results
+    static QString defaultDirectory();
+
+    const QString &directory() const { return dir; }
+    qint64 capacity() const { return cap; }
+
+    static QString key(quint64 contentHash, const RuleSet &rules, CachedResult kind);
+
+    // 命中时返回缓存文件的路径并记为最近使用，未命中返回空。缓存文件可能随时被其他进程淘汰，
+    // 调用方复制失败时按未命中处理。hitsOut 为放入时记下的各规则命中次数
+    QString lookup(const QString &key, std::array<qint64, kMaxRules> *hitsOut = nullptr);
+    // 把 file 复制到缓存（能共享数据块时不复制数据，从不硬链接，之后改动 file 不影响缓存），
+    // 之后按上限淘汰最久未用的条目。hits 为产生这个结果时各规则的命中次数，命中缓存时照样计入统计
+    bool insert(const QString &key, const QString &file, const std::array<qint64, kMaxRules> &hits = {});
+
+    // 原文为 inputSize 字节的脱敏结果；缓存的内容与之不符时按未命中处理
+    bool lookupRedacted(const QString &key, qsizetype inputSize, RedactedLog &out);
+    bool insertRedacted(const QString &key, const RedactedLog &r);
+
+private:
+    struct Entry {
+        qint64 size = 0;
+        qint64 modified = 0;   // 放入时的修改时间（毫秒），文件被改动后不再使用
+        std::array<qint64, kMaxRules> hits{};
+    };
+    using Index = QHash<QString, Entry>;
+
+    QString dir;
+    qint64 cap;
+    QMutex lock;          // 保护 index 与 dirty；目录锁不区分同一进程中的线程
+    Index index;
+    bool dirty = false;   // index 中有尚未写回的改动
+
+    Index readIndex() const;
+    // 持有目录锁时与目录中的索引合并、按上限淘汰后写回，调用方须持有 lock；placed 为刚放入的键
+    bool saveIndex(const QString &placed = QString());
+    void evict(Index &entries);
+    // privateFile 为 true 时 file 是只有缓存自己使用的临时文件，可以直接硬链接
+    bool place(const QString &key, const QString &file, bool privateFile, const std::array<qint64, kMaxRules> &hits);
+};
+
+using ResultCachePtr = std::shared_ptr<ResultCache>;
+
+// 当前使用的缓存；未启用或处于一致化替换模式（编号与处理顺序有关，结果不能复用）时为空
+ResultCachePtr activeResultCache();
+void setActiveResultCache(ResultCachePtr cache);
+
+} // namespace mcla
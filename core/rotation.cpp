@@ -0,0 +1,389 @@
+#include "rotation.h"
+
+#include "logfile.h"
+#include "logsource.h"
+#include "redactor.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace mcla {
+
+// 每次从一个文件读入的字节数（解压后）
+constexpr qint64 kMergeBlockSize = 256 << 10;
+// 每个文件最多预读的块数
+constexpr size_t kMergePrefetchBlocks = 2;
+// 没有时间戳的连续行（如很长的堆栈）攒到这么多就先作为一条记录交出，不无限增长
+constexpr qsizetype kMaxRecordSize = 4 << 20;
+// 只有时间的行比上一行早这么多以上时视为跨过了午夜
+constexpr int kRolloverSlackMs = 60 * 60 * 1000;
+constexpr qint64 kMsPerDay = 24 * 60 * 60 * 1000;
+
+QList<RotationMember> findRotationSet(const QString &dirPath) {
+    static const QRegularExpression rotated(R"(^(\d{4})-(\d{2})-(\d{2})-(\d+)\.log(\.gz)?$)");
+    QList<RotationMember> members;
+    const QDir dir(dirPath);
+    for (const QFileInfo &fi : dir.entryInfoList(QDir::Files)) {
+        const QRegularExpressionMatch m = rotated.match(fi.fileName());
+        if (!m.hasMatch()) continue;
+        const QDate date(m.captured(1).toInt(), m.captured(2).toInt(), m.captured(3).toInt());
+        if (date.isValid()) members.append({ fi.filePath(), date, m.captured(4).toInt(), fi.size() });
+    }
+    std::sort(members.begin(), members.end(), [](const RotationMember &a, const RotationMember &b) {
+        return a.date != b.date ? a.date < b.date : a.sequence < b.sequence;
+    });
+    const QFileInfo latest(dir.filePath("latest.log"));
+    if (latest.isFile()) {
+        // 当前日志从创建时开始写入，修改日期可能已经过了午夜
+        const QDateTime created = latest.birthTime();
+        members.append({ latest.filePath(), (created.isValid() ? created : latest.lastModified()).date(),
+                         std::numeric_limits<int>::max(), latest.size() });
+    }
+    return members;
+}
+
+static bool readDigits(const char *s, qsizetype n, qsizetype at, int count, int *value) {
+    if (at + count > n) return false;
+    int v = 0;
+    for (int k = 0; k < count; ++k) {
+        const char c = s[at + k];
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + (c - '0');
+    }
+    *value = v;
+    return true;
+}
+
+// 行首的时间戳：[HH:MM:SS]、[HH:MM:SS INFO]（原版与各服务端）、YYYY-MM-DD HH:MM:SS（BungeeCord、Velocity）、
+// [14Jun2023 15:31:45.123]（Forge）。有日期时 julianDay 为其儒略日，否则为 -1
+static bool parseLineTimestamp(const char *s, qsizetype n, qint64 *julianDay, int *msOfDay) {
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    qsizetype i = (n > 0 && s[0] == '[') ? 1 : 0;
+    int year = 0, month = 0, day = 0;
+    *julianDay = -1;
+    if (i + 11 <= n && s[i + 4] == '-' && s[i + 7] == '-' && (s[i + 10] == ' ' || s[i + 10] == 'T')
+        && readDigits(s, n, i, 4, &year) && readDigits(s, n, i + 5, 2, &month) && readDigits(s, n, i + 8, 2, &day)) {
+        i += 11;
+    } else if (i + 10 <= n && s[i + 9] == ' ' && readDigits(s, n, i, 2, &day) && readDigits(s, n, i + 5, 4, &year)) {
+        for (int k = 0; k < 12 && month == 0; ++k)
+            if (std::memcmp(s + i + 2, months + 3 * k, 3) == 0) month = k + 1;
+        if (month == 0) return false;
+        i += 10;
+    }
+    if (month != 0) {
+        const QDate date(year, month, day);
+        if (!date.isValid()) return false;
+        *julianDay = date.toJulianDay();
+    }
+
+    int h = 0, m = 0, sec = 0, ms = 0;
+    if (!(i + 8 <= n && s[i + 2] == ':' && s[i + 5] == ':' && readDigits(s, n, i, 2, &h)
+          && readDigits(s, n, i + 3, 2, &m) && readDigits(s, n, i + 6, 2, &sec)))
+        return false;
+    if (h > 23 || m > 59 || sec > 60) return false;
+    i += 8;
+    if (i < n && (s[i] == '.' || s[i] == ',')) readDigits(s, n, i + 1, 3, &ms);
+    *msOfDay = ((h * 60 + m) * 60 + sec) * 1000 + ms;
+    return true;
+}
+
+namespace {
+
+// 一个文件中各行的时间：只有时间的行沿用当前日期，时间明显倒退时进入下一天
+class LogClock {
+public:
+    explicit LogClock(QDate date) : day(date.isValid() ? date.toJulianDay() : 0) {}
+
+    qint64 baseKey() const { return day * kMsPerDay; }
+
+    // 行首有时间戳时返回 true 并给出排序键（毫秒）
+    bool stamp(const char *s, qsizetype n, qint64 *key) {
+        qint64 julianDay;
+        int ms;
+        if (!parseLineTimestamp(s, n, &julianDay, &ms)) return false;
+        if (julianDay >= 0) {
+            day = julianDay;
+        } else if (lastMs >= 0 && ms + kRolloverSlackMs < lastMs) {
+            ++day;
+        }
+        lastMs = ms;
+        *key = day * kMsPerDay + ms;
+        return true;
+    }
+
+private:
+    qint64 day;
+    int lastMs = -1;
+};
+
+struct MergeRecord {
+    qsizetype end;   // 在所在块中的结束位置，起点为前一条记录的结束位置
+    qint64 key;
+};
+
+struct MergeBlock {
+    QByteArray data;
+    std::vector<MergeRecord> records;
+};
+
+// 一个轮转文件：在线程池中逐块解压、脱敏并切成记录，预读至多 kMergePrefetchBlocks 块，合并线程按顺序取走。
+// 同一文件同一时刻至多一个任务，任务不会等待，线程数少于文件数时也不会互相卡住
+class MemberReader {
+public:
+    MemberReader(const RotationMember &member, QThreadPool &pool, TaskProgress *progress)
+        : member(member), pool(pool), progress(progress), clock(member.date), recordKey(clock.baseKey()) {}
+
+    bool open(QString *errorOut) {
+        auto f = std::make_unique<QFile>(member.path);
+        if (!f->open(QIODevice::ReadOnly)) {
+            if (errorOut) *errorOut = QFileInfo(member.path).fileName() + "：" + f->errorString();
+            return false;
+        }
+        file = f.get();
+        if (member.path.endsWith(".gz", Qt::CaseInsensitive)) {
+            in = std::make_unique<InflateDevice>(std::move(f), InflateDevice::Format::Gzip);
+        } else {
+            in = std::move(f);
+        }
+        anonymizer = std::make_unique<StreamAnonymizer>([this](QByteArrayView piece) {
+            pending.append(piece);
+            return true;
+        });
+        readBuffer.resize(kMergeBlockSize);
+        return true;
+    }
+
+    void start() {
+        QMutexLocker locker(&lock);
+        schedule();
+    }
+
+    // 不再预读；返回前已在执行的任务仍会结束，调用方须等线程池结束后再销毁
+    void stop() {
+        QMutexLocker locker(&lock);
+        finished = true;
+    }
+
+    // 取出下一块，必要时等待；没有更多时返回 false，出错时 errorString() 非空
+    bool take(MergeBlock &block) {
+        QMutexLocker locker(&lock);
+        while (blocks.empty() && !finished) {
+            schedule();
+            ready.wait(&lock);
+        }
+        if (blocks.empty()) return false;
+        block = std::move(blocks.front());
+        blocks.pop_front();
+        schedule();
+        return true;
+    }
+
+    QString errorString() const {
+        QMutexLocker locker(&lock);
+        return error;
+    }
+
+private:
+    RotationMember member;
+    QThreadPool &pool;
+    TaskProgress *progress;
+
+    mutable QMutex lock;
+    QWaitCondition ready;
+    std::deque<MergeBlock> blocks;
+    bool running = false;
+    bool finished = false;
+    QString error;
+
+    // 以下只由工作线程中的任务访问（同一时刻至多一个）
+    std::unique_ptr<QIODevice> in;
+    QFile *file = nullptr;   // 压缩文件时为 in 的源，用来统计读入的压缩字节数
+    qint64 consumed = 0;
+    std::unique_ptr<StreamAnonymizer> anonymizer;
+    QByteArray readBuffer;
+    QByteArray pending;      // 脱敏后尚未交出的数据：最后一条记录可能还有后续的行
+    qsizetype scanPos = 0;   // pending 中尚未判定的第一行的起点
+    LogClock clock;
+    qint64 recordKey;        // pending 开头那条记录的排序键
+
+    // 须持有 lock
+    void schedule() {
+        if (running || finished || blocks.size() >= kMergePrefetchBlocks) return;
+        running = true;
+        pool.start([this] { produce(); });
+    }
+
+    void produce() {
+        MergeBlock block;
+        QString failure;
+        bool last = false;
+        const qint64 got = readChunk(*in, readBuffer.data(), readBuffer.size());
+        if (got < 0) {
+            failure = in->errorString();
+        } else if (progress && progress->isCancelled()) {
+            failure = "已取消";
+        } else {
+            last = got == 0;
+            const bool ok = last ? anonymizer->finish() : anonymizer->feed(QByteArrayView(readBuffer.constData(), got));
+            if (!ok) {
+                failure = "脱敏失败";
+            } else if (!pending.isEmpty() && !anonymizer->encoding().isAsciiCompatible()) {
+                // 按字节 \n 切分记录，UTF-16 等编码无法合并
+                failure = "不支持的编码 " + anonymizer->encoding().name();
+            } else {
+                cutRecords(block, last);
+            }
+        }
+        if (progress) {
+            progress->advance(file->pos() - consumed);
+            if (last) progress->addHits(anonymizer->hitCounts());
+        }
+        consumed = file->pos();
+
+        QMutexLocker locker(&lock);
+        running = false;
+        if (!failure.isEmpty()) {
+            error = QFileInfo(member.path).fileName() + "：" + failure;
+            finished = true;
+        } else {
+            if (!block.records.empty()) blocks.push_back(std::move(block));
+            if (last) finished = true;
+            schedule();
+        }
+        ready.wakeAll();
+    }
+
+    // 把 pending 中已经完整的记录移到 block；last 时剩下的内容也作为最后一条记录
+    void cutRecords(MergeBlock &block, bool last) {
+        const char *s = pending.constData();
+        const qsizetype n = pending.size();
+        qsizetype cut = 0;   // 已交出的记录在 pending 中的终点
+        qsizetype pos = scanPos;
+        while (pos < n) {
+            const char *nl = static_cast<const char*>(std::memchr(s + pos, '\n', size_t(n - pos)));
+            if (!nl && !last) break;   // 不完整的行留到下一块
+            const qsizetype lineEnd = nl ? nl - s + 1 : n;
+            qint64 key;
+            if (clock.stamp(s + pos, lineEnd - pos, &key)) {
+                // 带时间戳的行开始新的记录，之前的记录到此完整
+                if (pos > cut) {
+                    block.records.push_back({ pos, recordKey });
+                    cut = pos;
+                }
+                recordKey = key;
+            } else if (lineEnd - cut >= kMaxRecordSize) {
+                block.records.push_back({ lineEnd, recordKey });
+                cut = lineEnd;
+            }
+            pos = lineEnd;
+        }
+        if (last && pos > cut) {
+            block.records.push_back({ pos, recordKey });
+            cut = pos;
+        }
+        block.data = pending.left(cut);
+        // 文件末尾没有换行时补上，避免与下一个文件的记录接在同一行
+        if (last && !block.data.isEmpty() && !block.data.endsWith('\n')) {
+            block.data.append('\n');
+            block.records.back().end = block.data.size();
+        }
+        pending.remove(0, cut);
+        scanPos = pos - cut;
+    }
+};
+
+} // namespace
+
+bool mergeRotationSet(const QList<RotationMember> &members, const QString &targetPath, int jobs, QString *errorOut,
+                      TaskProgress *progress) {
+    if (members.isEmpty()) {
+        if (errorOut) *errorOut = "没有找到轮转日志";
+        return false;
+    }
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, jobs));
+    std::vector<std::unique_ptr<MemberReader>> readers;
+    for (const RotationMember &m : members) {
+        readers.push_back(std::make_unique<MemberReader>(m, pool, progress));
+        if (!readers.back()->open(errorOut)) return false;
+    }
+    for (auto &reader : readers) reader->start();
+
+    // 各文件当前的块与下一条记录；队列中为各文件下一条记录的 (排序键, 文件序号)，相同时间先取排在前面的文件
+    struct Cursor {
+        MergeBlock block;
+        size_t next = 0;
+        qsizetype from = 0;
+    };
+    using Head = std::pair<qint64, size_t>;
+    std::vector<Cursor> cursors(readers.size());
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    bool failed = false;
+
+    // 让 cursors[i] 指向下一条记录并放入队列，该文件结束或出错时不放入
+    const auto pushNext = [&](size_t i) {
+        Cursor &c = cursors[i];
+        while (c.next >= c.block.records.size()) {
+            if (!readers[i]->take(c.block)) {
+                failed = failed || !readers[i]->errorString().isEmpty();
+                return;
+            }
+            c.next = 0;
+            c.from = 0;
+        }
+        heads.push({ c.block.records[c.next].key, i });
+    };
+
+    const bool written = writeFileAtomically(targetPath, targetPath.endsWith(".gz", Qt::CaseInsensitive), [&](QIODevice &out) {
+        for (size_t i = 0; i < readers.size() && !failed; ++i) pushNext(i);
+        while (!heads.empty() && !failed) {
+            if (progress && progress->isCancelled()) return false;
+            const size_t i = heads.top().second;
+            heads.pop();
+            Cursor &c = cursors[i];
+            // 同一文件中不晚于其他文件队首的后续记录一起写出（轮转的文件时间上基本不重叠，通常整块写出）
+            qsizetype end = c.block.records[c.next++].end;
+            while (c.next < c.block.records.size()
+                   && (heads.empty() || Head(c.block.records[c.next].key, i) < heads.top()))
+                end = c.block.records[c.next++].end;
+            if (out.write(c.block.data.constData() + c.from, end - c.from) != end - c.from) return false;
+            c.from = end;
+            pushNext(i);
+        }
+        return !failed;
+    });
+
+    for (auto &reader : readers) reader->stop();
+    pool.waitForDone();
+    if (written) return true;
+    if (errorOut) {
+        *errorOut = "写入失败：" + targetPath;
+        for (const auto &reader : readers) {
+            const QString error = reader->errorString();
+            if (!error.isEmpty()) {
+                *errorOut = error;
+                break;
+            }
+        }
+        if (progress && progress->isCancelled()) *errorOut = "已取消";
+    }
+    return false;
+}
+
+} // namespace mcla
@@ -0,0 +1,33 @@
+#pragma once
+
+// ---------------------------- 轮转日志合并 ----------------------------
+// Minecraft 及其代理把日志轮转为 latest.log 与若干 YYYY-MM-DD-N.log.gz。合并时各文件在线程池中并行解压、脱敏，
+// 按行首时间戳切成记录（没有时间戳的行，如异常堆栈，归入前一条记录），再多路归并成一个按时间排序的文件。
+// 每个文件只预读有限的几块，内存占用与文件数成正比，与日志总量无关
+
+#include "progress.h"
+
+#include <QDate>
+#include <QList>
+#include <QString>
+
+namespace mcla {
+
+struct RotationMember {
+    QString path;
+    QDate date;         // 文件名中的日期；latest.log 为文件的创建日期（取不到时为修改日期）
+    int sequence = 0;   // 同一天内的序号 N；latest.log 排在最后
+    qint64 size = 0;    // 文件大小（压缩文件为压缩后的大小），用作进度的总量
+};
+
+// 目录中的轮转日志：YYYY-MM-DD-N.log(.gz) 按日期与序号排序，latest.log 排在最后
+QList<RotationMember> findRotationSet(const QString &dir);
+
+// 把轮转日志合并脱敏为 targetPath（原子写出，以 .gz 结尾时写成 gzip）。
+// 只有时间没有日期的行以所在文件的日期为准，时间倒退时视为跨过了午夜；时间相同的记录按文件顺序排列。
+// jobs 为并行解压、脱敏的线程数；progress 按读入的文件字节数累加（总量见 RotationMember::size），
+// 各规则的命中次数累加到 progress->hits
+bool mergeRotationSet(const QList<RotationMember> &members, const QString &targetPath, int jobs, QString *errorOut,
+                      TaskProgress *progress = nullptr);
+
+} // namespace mcla
@@ -0,0 +1,363 @@
+#include "rules.h"
+
+#include "contenthash.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace mcla {
+
+// 端口：s[p] 为 ':'，后随 1-5 位数字且之后不是单词字符；返回结束位置或 -1
+static qsizetype matchPortAt(const char *s, qsizetype p, qsizetype n) {
+    if (p >= n || s[p] != ':') return -1;
+    qsizetype i = p + 1;
+    while (i < n && i - p <= 6 && isAsciiDigit(s[i])) ++i;
+    const qsizetype len = i - p - 1;
+    if (len < 1 || len > 5 || (i < n && isAsciiWordChar(s[i]))) return -1;
+    return i;
+}
+
+// 不带方括号的 IPv6 地址，可用 :: 压缩、可以 IPv4 结尾；至少含一个十进制数字，
+// 以排除 dead::beef 这类纯字母的组合。返回结束位置或 -1
+static qsizetype parseIpv6(const char *s, qsizetype p, qsizetype n) {
+    int groups = 0;
+    bool compressed = false, digit = false;
+    qsizetype i = p;
+    if (i + 1 < n && s[i] == ':' && s[i + 1] == ':') { compressed = true; i += 2; }
+    for (;;) {
+        qsizetype j = i;
+        while (j < n && j - i < 5 && isAsciiHexDigit(s[j])) ++j;
+        if (j == i) break;
+        if (j < n && s[j] == '.') {
+            DottedQuad q;
+            if (groups > 6 || !parseDottedQuad(s, i, n, q)) return -1;
+            groups += 2;
+            digit = true;
+            i = q.end;
+            break;
+        }
+        if (j - i > 4) return -1;
+        for (qsizetype k = i; k < j && !digit; ++k) digit = isAsciiDigit(s[k]);
+        ++groups;
+        i = j;
+        if (i + 1 < n && s[i] == ':' && s[i + 1] == ':') {
+            if (compressed) return -1;
+            compressed = true;
+            i += 2;
+        } else if (i + 1 < n && s[i] == ':' && isAsciiHexDigit(s[i + 1])) {
+            ++i;
+        } else {
+            break;
+        }
+    }
+    if (groups == 0 || !digit || (compressed ? groups > 7 : groups != 8)) return -1;
+    if (i < n && isAsciiWordChar(s[i])) return -1;
+    return i;
+}
+
+// [IPv6] 或 [IPv6]:端口，s[p] 为 '['
+static qsizetype matchBracketedIpv6(const char *s, qsizetype p, qsizetype n) {
+    const qsizetype e = parseIpv6(s, p + 1, n);
+    if (e < 0 || e >= n || s[e] != ']') return -1;
+    const qsizetype port = matchPortAt(s, e + 1, n);
+    return port >= 0 ? port : e + 1;
+}
+
+static qsizetype matchUuidAt(const char *s, qsizetype p, qsizetype n) {
+    static constexpr int groupLen[] = { 8, 4, 4, 4, 12 };
+    qsizetype i = p;
+    for (int g = 0; g < 5; ++g) {
+        if (g > 0) {
+            if (i >= n || s[i] != '-') return -1;
+            ++i;
+        }
+        for (int k = 0; k < groupLen[g]; ++k, ++i)
+            if (i >= n || !isAsciiHexDigit(s[i])) return -1;
+    }
+    if (i < n && isAsciiWordChar(s[i])) return -1;
+    return i;
+}
+
+RuleSetPtr RuleSet::defaults() {
+    QString error;
+    return parse("ipv4-port\nipv4\n", QString(), &error);
+}
+
+RuleSetPtr RuleSet::load(const QString &path, QString *errorOut) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = f.errorString();
+        return nullptr;
+    }
+    return parse(QString::fromUtf8(f.readAll()), QFileInfo(path).absolutePath(), errorOut);
+}
+
+static const QSet<QByteArray> &defaultTlds() {
+    static const QSet<QByteArray> tlds{ "com", "net", "org", "cn", "io", "me", "gg", "cc", "co", "top", "xyz", "fun",
+                                        "club", "online", "site", "info", "dev", "uk", "de", "ru", "jp", "kr", "tw", "hk" };
+    return tlds;
+}
+
+RuleSetPtr RuleSet::parse(const QString &text, const QString &baseDir, QString *errorOut) {
+    auto set = std::make_shared<RuleSet>();
+    // 版本：规则文本与引用的名单文件的内容哈希
+    ContentHasher version;
+    version.add(text.toUtf8());
+    const QStringList lines = text.split('\n');
+    for (int ln = 0; ln < lines.size(); ++ln) {
+        const QString line = lines[ln].trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        auto fail = [&](const QString &why) {
+            if (errorOut) *errorOut = QString("第 %1 行：%2").arg(ln + 1).arg(why);
+            return nullptr;
+        };
+        const QStringList words = line.split(QRegularExpression("\\s+"));
+        static const QHash<QString, RuleKind> kinds = {
+            { "ipv4-port", RuleKind::Ipv4Port }, { "ipv4", RuleKind::Ipv4 }, { "ipv6", RuleKind::Ipv6 },
+            { "uuid", RuleKind::Uuid }, { "connection", RuleKind::Connection },
+            { "hostname", RuleKind::Hostname }, { "names", RuleKind::Names },
+        };
+        const auto kind = kinds.constFind(words[0].toLower());
+        if (kind == kinds.cend()) return fail("未知的规则类型 " + words[0]);
+        if (set->rules.size() >= kMaxRules) return fail(QString("规则不能超过 %1 条").arg(kMaxRules));
+
+        RedactionRule rule{ words[0].toLower(), *kind, QString() };
+        const int index = int(set->rules.size());
+        QStringList names;
+        QSet<QByteArray> tlds = defaultTlds();
+        for (int w = 1; w < words.size(); ++w) {
+            const qsizetype eq = words[w].indexOf('=');
+            const QString key = words[w].left(eq);
+            const QString value = eq < 0 ? QString() : words[w].mid(eq + 1);
+            if (key == "replace") {
+                rule.replacement = value;
+            } else if (key == "name") {
+                rule.name = value;
+            } else if (key == "tlds" && rule.kind == RuleKind::Hostname) {
+                tlds.clear();
+                for (const QString &t : value.split(',', Qt::SkipEmptyParts)) tlds.insert(t.toLower().toUtf8());
+            } else if (key == "list" && rule.kind == RuleKind::Names) {
+                names += value.split(',', Qt::SkipEmptyParts);
+            } else if (key == "file" && rule.kind == RuleKind::Names) {
+                QFile f(QDir(baseDir).filePath(value));
+                if (!f.open(QIODevice::ReadOnly)) return fail("无法读取名单 " + value + "：" + f.errorString());
+                const QByteArray list = f.readAll();
+                version.add(list);
+                for (const QString &entry : QString::fromUtf8(list).split('\n')) {
+                    const QString name = entry.trimmed();
+                    if (!name.isEmpty() && !name.startsWith('#')) names << name;
+                }
+            } else {
+                return fail("无法识别的选项 " + words[w]);
+            }
+        }
+        for (const QString &name : names) {
+            const QByteArray bytes = name.toUtf8();
+            if (asciiPrefixLength(bytes.constData(), bytes.size()) != bytes.size() || !isAsciiWordChar(bytes[0]))
+                return fail("名单中的名字只能包含 ASCII 字符且以字母、数字或下划线开头：" + name);
+            set->addName(bytes, index);
+        }
+        if (rule.kind == RuleKind::Hostname) set->hostnameTlds.push_back({ index, std::move(tlds) });
+        set->rules.push_back(rule);
+    }
+    if (set->rules.empty()) {
+        if (errorOut) *errorOut = "规则文件中没有任何规则";
+        return nullptr;
+    }
+    set->fingerprint = version.result();
+    set->finalize();
+    return set;
+}
+
+void RuleSet::addName(const QByteArray &name, int rule) {
+    if (name.isEmpty()) return;
+    qint32 node = 0;
+    for (char c : name) {
+        const quint64 key = (quint64(node) << 8) | static_cast<unsigned char>(foldAscii(c));
+        auto it = trieEdges.constFind(key);
+        if (it == trieEdges.cend()) {
+            trieEdges.insert(key, qint32(trieRule.size()));
+            node = qint32(trieRule.size());
+            trieRule.push_back(-1);
+        } else {
+            node = *it;
+        }
+    }
+    if (trieRule[size_t(node)] < 0) trieRule[size_t(node)] = qint16(rule);
+    longestName = qMax(longestName, name.size());
+}
+
+void RuleSet::finalize() {
+    std::fill(std::begin(firstRule), std::end(firstRule), -1);
+    for (int i = ruleCount() - 1; i >= 0; --i) firstRule[int(rules[size_t(i)].kind)] = i;
+    ipv4PortRule = firstRule[int(RuleKind::Ipv4Port)];
+    ipv4Rule = firstRule[int(RuleKind::Ipv4)];
+    legacyOnly = ipv4PortRule >= 0 && ipv4Rule >= 0
+                 && std::all_of(rules.cbegin(), rules.cend(), [](const RedactionRule &r) {
+                        return r.kind == RuleKind::Ipv4Port || r.kind == RuleKind::Ipv4;
+                    });
+
+    // 可能作为命中起点的字节：单词字符（词首），以及 / [ : 三个符号
+    for (int c = 0; c < 256; ++c) startByte[c] = isAsciiWordChar(char(c));
+    startByte[int('/')] = enabled(RuleKind::Connection);
+    startByte[int('[')] = enabled(RuleKind::Ipv6);
+    startByte[int(':')] = enabled(RuleKind::Ipv6);
+    // 主机名最长 253 字节，判定失败前最多再读一个标签（64 字节），另加端口与后随的边界字符
+    lookaheadBytes = qMax<qsizetype>(longestName, 253 + 64) + 16;
+}
+
+// 主机名：若干由 . 分隔的标签，最后一段须为某条 hostname 规则的顶级域名，ruleOut 为其中文件中最靠前的一条
+// （requireTld 为 false 时只要求至少两段）
+qsizetype RuleSet::parseHostname(const char *s, qsizetype p, qsizetype n, bool requireTld, int *ruleOut) const {
+    if (p > 0 && (s[p - 1] == '.' || s[p - 1] == '-')) return -1;
+    qsizetype i = p, lastLabel = p;
+    int labels = 0;
+    for (;;) {
+        const qsizetype labelStart = i;
+        while (i < n && i - labelStart <= 63 && (isAsciiWordChar(s[i]) || s[i] == '-') && s[i] != '_') ++i;
+        const qsizetype len = i - labelStart;
+        if (len == 0 || len > 63 || s[labelStart] == '-' || s[i - 1] == '-') return -1;
+        ++labels;
+        lastLabel = labelStart;
+        if (i - p > 253) return -1;
+        if (i + 1 < n && s[i] == '.' && isAsciiWordChar(s[i + 1]) && s[i + 1] != '_') { ++i; continue; }
+        break;
+    }
+    if (labels < 2 || (i < n && (isAsciiWordChar(s[i]) || s[i] == '-'))) return -1;
+    if (requireTld) {
+        if (i - lastLabel > 16) return -1;
+        char tld[16];
+        for (qsizetype k = lastLabel; k < i; ++k) {
+            if (!((s[k] | 0x20) >= 'a' && (s[k] | 0x20) <= 'z')) return -1;
+            tld[k - lastLabel] = foldAscii(s[k]);
+        }
+        const QByteArray key = QByteArray::fromRawData(tld, i - lastLabel);
+        const auto it = std::find_if(hostnameTlds.cbegin(), hostnameTlds.cend(),
+                                     [&](const HostnameTlds &h) { return h.tlds.contains(key); });
+        if (it == hostnameTlds.cend()) return -1;
+        if (ruleOut) *ruleOut = it->rule;
+    }
+    return i;
+}
+
+// /IP:端口、/[IPv6]:端口、/主机名:端口
+qsizetype RuleSet::matchConnectionAt(const char *s, qsizetype p, qsizetype n) const {
+    const qsizetype q = p + 1;
+    if (q >= n) return -1;
+    if (isAsciiDigit(s[q])) {
+        const qsizetype e = matchIpPortAt(s, q, n);
+        if (e >= 0) return e;
+    }
+    if (s[q] == '[') {
+        const qsizetype e = parseIpv6(s, q + 1, n);
+        return e >= 0 && e < n && s[e] == ']' ? matchPortAt(s, e + 1, n) : -1;
+    }
+    if (!isAsciiWordChar(s[q])) return -1;
+    const qsizetype host = parseHostname(s, q, n, false);
+    return host >= 0 ? matchPortAt(s, host, n) : -1;
+}
+
+qsizetype RuleSet::matchNameAt(const char *raw, const char *s, qsizetype p, qsizetype n, int &rule) const {
+    qint32 node = 0;
+    qsizetype best = -1;
+    for (qsizetype i = p; i < n; ++i) {
+        auto it = trieEdges.constFind((quint64(node) << 8) | static_cast<unsigned char>(foldAscii(raw[i])));
+        if (it == trieEdges.cend()) break;
+        node = *it;
+        if (trieRule[size_t(node)] >= 0 && (i + 1 == n || !isAsciiWordChar(s[i + 1]))) {
+            best = i + 1;
+            rule = trieRule[size_t(node)];
+        }
+    }
+    return best;
+}
+
+// ipv4-port / ipv4 两条规则同时启用时与 scanIpv4 的判定完全相同；只启用其中一条时分别对应单独的一条正则
+template <typename Offer>
+void RuleSet::matchIpv4(const char *s, qsizetype p, qsizetype n, Offer &offer) const {
+    if (ipv4PortRule >= 0 && ipv4Rule >= 0) {
+        qsizetype start, end;
+        IpMatchKind kind;
+        if (matchIpv4Candidate(s, p, n, start, end, kind))
+            offer(start, end, kind == IpMatchKind::IpPort ? ipv4PortRule : ipv4Rule);
+    } else if (ipv4PortRule >= 0) {
+        offer(p, matchIpPortAt(s, p, n), ipv4PortRule);
+    } else {
+        DottedQuad q;
+        if (parseDottedQuad(s, p, n, q) && (q.end == n || !isAsciiWordChar(s[q.end])))
+            offer(p, q.end, ipv4Rule);
+    }
+}
+
+// 在词首 p 处尝试所有规则：取起点最靠前、其次最长、再其次规则靠前的命中
+RuleMatch RuleSet::matchAt(const char *s, const char *raw, qsizetype p, qsizetype n) const {
+    RuleMatch best;
+    auto offer = [&](qsizetype start, qsizetype end, int rule) {
+        if (end < 0 || rule < 0) return;
+        if (best.rule < 0 || start < best.start || (start == best.start && end > best.end)
+            || (start == best.start && end == best.end && rule < best.rule))
+            best = { start, end, rule };
+    };
+    const char c = s[p];
+    if (c == '/') {
+        offer(p, matchConnectionAt(s, p, n), firstRule[int(RuleKind::Connection)]);
+        return best;
+    }
+    if (c == '[' || c == ':') {
+        if (c == '[') offer(p, matchBracketedIpv6(s, p, n), firstRule[int(RuleKind::Ipv6)]);
+        else if (p == 0 || !isAsciiHexDigit(s[p - 1])) offer(p, parseIpv6(s, p, n), firstRule[int(RuleKind::Ipv6)]);
+        return best;
+    }
+    if (isAsciiDigit(c) && (ipv4PortRule >= 0 || ipv4Rule >= 0)) matchIpv4(s, p, n, offer);
+    if (isAsciiHexDigit(c)) {
+        if (enabled(RuleKind::Ipv6)) offer(p, parseIpv6(s, p, n), firstRule[int(RuleKind::Ipv6)]);
+        if (enabled(RuleKind::Uuid)) offer(p, matchUuidAt(s, p, n), firstRule[int(RuleKind::Uuid)]);
+    }
+    if (enabled(RuleKind::Hostname)) {
+        int rule = -1;
+        const qsizetype e = parseHostname(s, p, n, true, &rule);
+        offer(p, e, rule);
+    }
+    if (enabled(RuleKind::Names)) {
+        int rule = -1;
+        const qsizetype e = matchNameAt(raw, s, p, n, rule);
+        offer(p, e, rule);
+    }
+    return best;
+}
+
+static QMutex activeRulesMutex;
+static RuleSetPtr activeRules;
+
+RuleSetPtr activeRuleSet() {
+    QMutexLocker lock(&activeRulesMutex);
+    if (!activeRules) activeRules = RuleSet::defaults();
+    return activeRules;
+}
+
+void setActiveRuleSet(RuleSetPtr rules) {
+    QMutexLocker lock(&activeRulesMutex);
+    activeRules = std::move(rules);
+}
+
+QString defaultRulesPath() {
+    return QCoreApplication::applicationDirPath() + "/anonymizer-rules.txt";
+}
+
+QString ruleHitSummary(const RuleSet &rules, const TaskProgress &stats) {
+    QStringList parts;
+    for (int i = 0; i < rules.ruleCount(); ++i) {
+        const qint64 hits = stats.hits[size_t(i)].load(std::memory_order_relaxed);
+        if (hits > 0) parts << QString("%1 ×%2").arg(rules.rule(i).name).arg(hits);
+    }
+    return parts.isEmpty() ? "没有命中任何规则" : parts.join("，");
+}
+
+} // namespace mcla
@@ -0,0 +1,148 @@
+#pragma once
+
+// ---------------------------- 脱敏规则 ----------------------------
+// 规则文件每行一条规则：<类型> [键=值 ...]，# 开头为注释。所有规则编译成一个 RuleSet，
+// 扫描时对每个词首只做一次分派，一遍扫描找出所有规则的命中。类型：
+//   ipv4-port   IP:端口（与原来的第一条正则相同）
+//   ipv4        IP（与原来的第二条正则相同）
+//   ipv6        IPv6 地址，可带方括号与端口
+//   uuid        8-4-4-4-12 格式的 UUID（玩家 UUID）
+//   connection  /IP:端口、/[IPv6]:端口、/主机名:端口 形式的连接串（连同开头的 /）
+//   hostname    以常见顶级域名结尾的主机名，tlds=com,net,... 可自定义（只作用于所在的这条规则）
+//   names       名单中的整词（玩家名等，ASCII 不区分大小写），file=名单文件（每行一个）或 list=a,b,c
+// 通用选项：replace=替换文本（默认删除）、name=统计时显示的名称。
+// 同一位置有多条规则命中时取最长的，一样长时取文件中靠前的
+
+#include "ipscanner.h"
+#include "progress.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+namespace mcla {
+
+enum class RuleKind { Ipv4Port, Ipv4, Ipv6, Uuid, Connection, Hostname, Names };
+
+struct RedactionRule {
+    QString name;
+    RuleKind kind;
+    QString replacement;
+};
+
+template <typename CharT>
+inline bool isAsciiHexDigit(CharT c) {
+    const unsigned u = charCode(c);
+    return u - '0' < 10u || (u | 0x20u) - 'a' < 6u;
+}
+
+inline char foldAscii(char c) {
+    return c >= 'A' && c <= 'Z' ? char(c | 0x20) : c;
+}
+
+// 一个候选位置上各规则的命中结果
+struct RuleMatch {
+    qsizetype start = -1;
+    qsizetype end = -1;
+    int rule = -1;
+};
+
+class RuleSet;
+using RuleSetPtr = std::shared_ptr<const RuleSet>;
+
+class RuleSet {
+public:
+    // 默认规则：只删除 IP 与 IP:端口，结果与原来的两条正则相同
+    static RuleSetPtr defaults();
+    static RuleSetPtr load(const QString &path, QString *errorOut);
+    // baseDir 用于解析 file= 的相对路径
+    static RuleSetPtr parse(const QString &text, const QString &baseDir, QString *errorOut);
+
+    int ruleCount() const { return int(rules.size()); }
+    const RedactionRule &rule(int i) const { return rules[size_t(i)]; }
+
+    // 规则文本与名单内容的哈希，内容相同的规则集版本相同（用作结果缓存的键）
+    quint64 version() const { return fingerprint; }
+
+    // 判定一个候选位置最多需要向后看的字节数（流式处理时据此保留块尾）
+    qsizetype lookahead() const { return lookaheadBytes; }
+
+    // 与 scanIpv4 相同的接口：按从左到右的顺序回调 onMatch(start, end, rule)，返回继续扫描的位置。
+    // s 用于判定（双字节编码时为屏蔽了尾字节的影子数据），raw 为原始字节，名单按原始字节匹配
+    template <typename OnMatch>
+    qsizetype scan(const char *s, const char *raw, qsizetype begin, qsizetype n, bool atEnd, OnMatch &&onMatch) const {
+        if (legacyOnly) {
+            return scanIpv4(s, begin, n, atEnd, [&](qsizetype start, qsizetype end, IpMatchKind kind) {
+                onMatch(start, end, kind == IpMatchKind::IpPort ? ipv4PortRule : ipv4Rule);
+            });
+        }
+        qsizetype p = begin;
+        while (p < n) {
+            while (p < n && !startByte[static_cast<unsigned char>(s[p])]) ++p;
+            if (p >= n) break;
+            if (!atEnd && n - p < lookaheadBytes) return p;
+            const bool word = isAsciiWordChar(s[p]);
+            if (word && p > 0 && isAsciiWordChar(s[p - 1])) {
+                while (p < n && isAsciiWordChar(s[p])) ++p;
+                continue;
+            }
+            const RuleMatch m = matchAt(s, raw, p, n);
+            if (m.rule >= 0) {
+                onMatch(m.start, m.end, m.rule);
+                p = m.end;
+            } else if (word) {
+                while (p < n && isAsciiWordChar(s[p])) ++p;
+            } else {
+                ++p;
+            }
+        }
+        return n;
+    }
+
+private:
+    std::vector<RedactionRule> rules;
+    // 各条 hostname 规则的顶级域名表，按文件中的顺序
+    struct HostnameTlds {
+        int rule;
+        QSet<QByteArray> tlds;
+    };
+    std::vector<HostnameTlds> hostnameTlds;
+    // 名单：所有 names 规则共用一棵按字节（ASCII 折叠为小写）的前缀树，边表为 (节点 << 8 | 字节) → 子节点
+    QHash<quint64, qint32> trieEdges;
+    std::vector<qint16> trieRule{ -1 };
+    qsizetype longestName = 0;
+
+    quint64 fingerprint = 0;
+    bool legacyOnly = false;
+    int ipv4PortRule = -1, ipv4Rule = -1;
+    int firstRule[7];   // 每种类型在文件中的第一条规则，-1 表示未启用
+    bool startByte[256] = {};
+    qsizetype lookaheadBytes = 0;
+
+    void addName(const QByteArray &name, int rule);
+    void finalize();
+    bool enabled(RuleKind kind) const { return firstRule[int(kind)] >= 0; }
+
+    qsizetype parseHostname(const char *s, qsizetype p, qsizetype n, bool requireTld, int *ruleOut = nullptr) const;
+    qsizetype matchConnectionAt(const char *s, qsizetype p, qsizetype n) const;
+    qsizetype matchNameAt(const char *raw, const char *s, qsizetype p, qsizetype n, int &rule) const;
+    RuleMatch matchAt(const char *s, const char *raw, qsizetype p, qsizetype n) const;
+    template <typename Offer>
+    void matchIpv4(const char *s, qsizetype p, qsizetype n, Offer &offer) const;
+};
+
+// 当前使用的规则集：启动时或在界面中加载规则文件后替换；每次处理开始时取一份快照
+RuleSetPtr activeRuleSet();
+void setActiveRuleSet(RuleSetPtr rules);
+
+// 程序目录下的规则文件，存在时启动即加载
+QString defaultRulesPath();
+
+// 按规则顺序列出本次的命中次数，如 “ipv4-port ×12，uuid ×3”
+QString ruleHitSummary(const RuleSet &rules, const TaskProgress &stats);
+
+} // namespace mcla
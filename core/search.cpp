@@ -0,0 +1,211 @@
+#include "search.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mcla {
+
+// 每段连续扫描的字节数，段之间检查是否已取消
+constexpr qsizetype kScanSliceSize = 16 << 20;
+// 向前查找时每次回退的字节数
+constexpr qsizetype kBackwardBlockSize = 4 << 20;
+
+static inline char toLowerAscii(char c) {
+    return c >= 'A' && c <= 'Z' ? char(c + ('a' - 'A')) : c;
+}
+
+static inline char toUpperAscii(char c) {
+    return c >= 'a' && c <= 'z' ? char(c - ('a' - 'A')) : c;
+}
+
+// 日志中各类字节大致的少见程度：空格、标点（时间戳、[线程/级别]）与数字最常见，大写字母较少见
+static int rarity(uchar c) {
+    if (c == ' ') return 0;
+    if ((c >= 'a' && c <= 'z') || c >= 0x80) return 3;
+    if (c >= 'A' && c <= 'Z') return 4;
+    if (c >= '0' && c <= '9') return 2;
+    return 1;
+}
+
+LineIndex::LineIndex(const QByteArray &data) : size(data.size()) {
+    if (data.isEmpty()) return;
+    const char *s = data.constData();
+    qsizetype pos = 0;
+    for (;;) {
+        starts.push_back(pos);
+        const char *nl = static_cast<const char*>(std::memchr(s + pos, '\n', size_t(size - pos)));
+        const qsizetype end = nl ? nl - s : size;
+        longestLine = qMax(longestLine, end - pos);
+        if (!nl) break;
+        pos = end + 1;
+    }
+}
+
+qsizetype LineIndex::contentEnd(const QByteArray &data, qsizetype line) const {
+    qsizetype end = line + 1 < count() ? starts[size_t(line + 1)] - 1 : size;
+    if (end > starts[size_t(line)] && data.at(end - 1) == '\r') --end;
+    return end;
+}
+
+qsizetype LineIndex::lineOf(qsizetype offset) const {
+    return qsizetype(std::upper_bound(starts.cbegin(), starts.cend(), offset) - starts.cbegin()) - 1;
+}
+
+// 从 it 开始把落在 [ls, le) 中的命中区间换成替换内容，拼出该行显示的内容；it 停在该行之后的第一个区间
+static QByteArray buildDisplayedLine(const QByteArray &data, const RedactedLog &r, qsizetype ls, qsizetype le,
+                                     QList<TextSpan>::const_iterator &it) {
+    QByteArray out;
+    qsizetype pos = ls;
+    for (; it != r.spans.cend() && it->start < le; ++it) {
+        out.append(data.constData() + pos, it->start - pos);
+        out.append(r.replacement(it - r.spans.cbegin()));
+        pos = it->end;
+    }
+    if (pos < le) out.append(data.constData() + pos, le - pos);
+    return out;
+}
+
+QByteArray displayedLine(const QByteArray &data, const LineIndex &lines, const RedactedLog *r, qsizetype line) {
+    const qsizetype ls = lines.start(line);
+    const qsizetype le = lines.contentEnd(data, line);
+    if (!r) return data.mid(ls, le - ls);
+    auto it = std::lower_bound(r->spans.cbegin(), r->spans.cend(), ls,
+                               [](const TextSpan &s, qsizetype p) { return s.end <= p; });
+    return buildDisplayedLine(data, *r, ls, le, it);
+}
+
+TextFinder::TextFinder(const QByteArray &needle, bool ignoreCase)
+    : pattern(ignoreCase ? needle.toLower() : needle), ignoreCase(ignoreCase) {
+    for (qsizetype i = 1; i < pattern.size(); ++i)
+        if (rarity(uchar(pattern[i])) > rarity(uchar(pattern[anchor]))) anchor = i;
+}
+
+bool TextFinder::matchesAt(const char *p) const {
+    if (!ignoreCase) return std::memcmp(p, pattern.constData(), size_t(pattern.size())) == 0;
+    for (qsizetype i = 0; i < pattern.size(); ++i)
+        if (toLowerAscii(p[i]) != pattern[i]) return false;
+    return true;
+}
+
+qsizetype TextFinder::find(const char *s, qsizetype from, qsizetype to) const {
+    const qsizetype n = pattern.size();
+    if (n == 0 || to - from < n) return -1;
+    const char a = pattern[anchor];
+    const char alt = ignoreCase ? toUpperAscii(a) : a;
+    // 锚点字节可能出现的范围
+    const char *p = s + from + anchor;
+    const char *end = s + to - n + anchor + 1;
+    while (p < end) {
+        const char *hit = static_cast<const char*>(std::memchr(p, a, size_t(end - p)));
+        if (alt != a) {
+            // 只在到下一个小写锚点为止的范围内找大写锚点，总的扫描量不超过两遍
+            const char *upper = static_cast<const char*>(std::memchr(p, alt, size_t((hit ? hit : end) - p)));
+            if (upper) hit = upper;
+        }
+        if (!hit) return -1;
+        if (matchesAt(hit - anchor)) return hit - anchor - s;
+        p = hit + 1;
+    }
+    return -1;
+}
+
+LogSearch::LogSearch(const QByteArray &data, std::shared_ptr<const LineIndex> lines,
+                     std::shared_ptr<const RedactedLog> r, const TextFinder &finder)
+    : data(data), lines(std::move(lines)), redacted(std::move(r)), finder(finder) {}
+
+bool LogSearch::scan(qsizetype fromLine, qsizetype toLine, const std::function<bool(const SearchHit &)> &onHit,
+                     TaskProgress *progress) const {
+    fromLine = qMax<qsizetype>(0, fromLine);
+    toLine = qMin(toLine, lines->count());
+    if (fromLine >= toLine || finder.size() == 0) return true;
+    const char *s = data.constData();
+    const qsizetype end = lines->next(toLine - 1);
+    qsizetype pos = lines->start(fromLine);
+
+    static const QList<TextSpan> noSpans;
+    const QList<TextSpan> &spans = redacted ? redacted->spans : noSpans;
+    auto it = std::lower_bound(spans.cbegin(), spans.cend(), pos,
+                               [](const TextSpan &span, qsizetype p) { return span.end <= p; });
+
+    while (pos < end) {
+        // 下一个含命中区间的行之前的部分直接在原始字节上查找；查找的内容不含换行，匹配不会跨行
+        const qsizetype spanLine = it != spans.cend() && it->start < end ? lines->lineOf(it->start) : toLine;
+        const qsizetype bulkEnd = spanLine < toLine ? lines->start(spanLine) : end;
+        while (pos < bulkEnd) {
+            const qsizetype sliceEnd = qMin(bulkEnd, pos + kScanSliceSize);
+            // 匹配的起点在本段内即可，末尾可以越过段边界
+            const qsizetype limit = qMin(bulkEnd, sliceEnd + finder.size() - 1);
+            for (qsizetype p = pos; (p = finder.find(s, p, limit)) >= 0 && p < sliceEnd; ++p) {
+                const qsizetype line = lines->lineOf(p);
+                if (!onHit({ line, p - lines->start(line) })) return true;
+            }
+            if (progress && !progress->advance(sliceEnd - pos)) return false;
+            pos = sliceEnd;
+        }
+        if (pos >= end) break;
+
+        // 含命中区间的行：拼出显示的内容再查找
+        const QByteArray shown = buildDisplayedLine(data, *redacted, pos, lines->contentEnd(data, spanLine), it);
+        for (qsizetype p = 0; (p = finder.find(shown.constData(), p, shown.size())) >= 0; ++p)
+            if (!onHit({ spanLine, p })) return true;
+        const qsizetype nextPos = lines->next(spanLine);
+        if (progress && !progress->advance(nextPos - pos)) return false;
+        pos = nextPos;
+    }
+    return true;
+}
+
+SearchHit LogSearch::next(const SearchHit &from, TaskProgress *progress) const {
+    const qsizetype n = lines->count();
+    SearchHit found;
+    const auto after = [&](const SearchHit &h) {
+        if (from.isValid() && !(from < h)) return true;
+        found = h;
+        return false;
+    };
+    if (!scan(from.isValid() ? from.line : 0, n, after, progress)) return {};
+    if (found.isValid() || !from.isValid()) return found;
+    // 到末尾后从头继续
+    if (!scan(0, from.line + 1, [&](const SearchHit &h) { found = h; return false; }, progress)) return {};
+    return found;
+}
+
+SearchHit LogSearch::lastBefore(qsizetype fromLine, qsizetype toLine, const SearchHit &limit, TaskProgress *progress,
+                                bool *cancelled) const {
+    for (qsizetype e = toLine; e > fromLine;) {
+        // 每段约 kBackwardBlockSize 字节，至少一行
+        const qsizetype blockStart = qMax<qsizetype>(0, lines->next(e - 1) - kBackwardBlockSize);
+        const qsizetype b = qBound(fromLine, lines->lineOf(blockStart), e - 1);
+        SearchHit last;
+        const bool ok = scan(b, e, [&](const SearchHit &h) {
+            if (limit.isValid() && !(h < limit)) return false;
+            last = h;
+            return true;
+        }, progress);
+        if (!ok) {
+            *cancelled = true;
+            return {};
+        }
+        if (last.isValid()) return last;
+        e = b;
+    }
+    return {};
+}
+
+SearchHit LogSearch::previous(const SearchHit &from, TaskProgress *progress) const {
+    const qsizetype n = lines->count();
+    bool cancelled = false;
+    if (!from.isValid()) return lastBefore(0, n, SearchHit(), progress, &cancelled);
+    const SearchHit hit = lastBefore(0, qMin(n, from.line + 1), from, progress, &cancelled);
+    if (hit.isValid() || cancelled) return hit;
+    // 到开头后从末尾继续
+    return lastBefore(qMax<qsizetype>(0, from.line), n, SearchHit(), progress, &cancelled);
+}
+
+qint64 LogSearch::count(TaskProgress *progress) const {
+    qint64 hits = 0;
+    const bool ok = scan(0, lines->count(), [&](const SearchHit &) { ++hits; return true; }, progress);
+    return ok ? hits : -1;
+}
+
+} // namespace mcla
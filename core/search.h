@@ -0,0 +1,107 @@
+#pragma once
+
+// ---------------------------- 日志搜索 ----------------------------
+// 在预览显示的文本（脱敏后的内容，或对照原文时的原文）中查找字面文本，不生成脱敏后的副本：
+// 不含命中区间的行直接在原始字节上用 memchr 定位候选位置，含命中区间的行才拼出显示的内容再查找。
+// 行起始偏移索引同时供预览按行绘制与跳转使用
+
+#include "progress.h"
+#include "redactor.h"
+
+#include <QByteArray>
+#include <QList>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mcla {
+
+// 行起始偏移索引：第 i 行从 start(i) 开始，到下一个 \n 为止
+class LineIndex {
+public:
+    LineIndex() = default;
+    explicit LineIndex(const QByteArray &data);
+
+    qsizetype count() const { return qsizetype(starts.size()); }
+    qsizetype start(qsizetype line) const { return starts[size_t(line)]; }
+    // 下一行的起点，最后一行为数据长度
+    qsizetype next(qsizetype line) const { return line + 1 < count() ? starts[size_t(line + 1)] : size; }
+    // 行内容的结束位置，不含行尾的 \n 与 \r
+    qsizetype contentEnd(const QByteArray &data, qsizetype line) const;
+    // offset 所在的行
+    qsizetype lineOf(qsizetype offset) const;
+    // 最长一行的字节数，用作水平滚动范围的估计
+    qsizetype longest() const { return longestLine; }
+
+private:
+    std::vector<qsizetype> starts;
+    qsizetype size = 0;
+    qsizetype longestLine = 0;
+};
+
+// 第 line 行显示的内容（不含行尾）：r 非空时其中的命中区间换成各自的替换内容
+QByteArray displayedLine(const QByteArray &data, const LineIndex &lines, const RedactedLog *r, qsizetype line);
+
+// 字面文本查找：用 needle 中较少见的一个字节以 memchr 定位候选位置，再逐字节比较。
+// ignoreCase 时只忽略 ASCII 字母的大小写
+class TextFinder {
+public:
+    TextFinder(const QByteArray &needle, bool ignoreCase);
+
+    qsizetype size() const { return pattern.size(); }
+
+    // s[from, to) 中第一个完整落在其中的匹配的起点，没有时返回 -1
+    qsizetype find(const char *s, qsizetype from, qsizetype to) const;
+
+private:
+    QByteArray pattern;   // ignoreCase 时已转成小写
+    bool ignoreCase;
+    qsizetype anchor = 0;   // 用来定位候选位置的字节在 pattern 中的下标
+
+    bool matchesAt(const char *p) const;
+};
+
+// 命中位置：行号与在该行显示内容中的字节偏移，按先行后列排序
+struct SearchHit {
+    qsizetype line = -1;
+    qsizetype offset = 0;
+
+    bool isValid() const { return line >= 0; }
+    bool operator<(const SearchHit &o) const { return line != o.line ? line < o.line : offset < o.offset; }
+};
+
+// 一次查找的条件与数据，创建后只读，可在多个工作线程中同时使用。
+// data 必须是 ASCII 兼容编码（见 TextEncoding::working）且在使用期间有效；r 为空时在原文中查找
+class LogSearch {
+public:
+    LogSearch(const QByteArray &data, std::shared_ptr<const LineIndex> lines, std::shared_ptr<const RedactedLog> r,
+              const TextFinder &finder);
+
+    qsizetype matchSize() const { return finder.size(); }
+
+    // 按顺序把行 [fromLine, toLine) 中的命中交给 onHit，onHit 返回 false 时停止。
+    // progress 按扫描的字节数累加，被取消时返回 false
+    bool scan(qsizetype fromLine, qsizetype toLine, const std::function<bool(const SearchHit &)> &onHit,
+              TaskProgress *progress = nullptr) const;
+
+    // 位置 from 之后（不含）的第一个命中，到末尾后从头继续；没有命中或被取消时返回无效的位置
+    SearchHit next(const SearchHit &from, TaskProgress *progress = nullptr) const;
+    // 位置 from 之前（不含）的最后一个命中，到开头后从末尾继续
+    SearchHit previous(const SearchHit &from, TaskProgress *progress = nullptr) const;
+
+    // 全部命中的个数，被取消时返回 -1
+    qint64 count(TaskProgress *progress = nullptr) const;
+
+private:
+    QByteArray data;
+    std::shared_ptr<const LineIndex> lines;
+    std::shared_ptr<const RedactedLog> redacted;
+    TextFinder finder;
+
+    // 行 [fromLine, toLine) 中在 limit 之前的最后一个命中（从后往前分段查找）
+    SearchHit lastBefore(qsizetype fromLine, qsizetype toLine, const SearchHit &limit, TaskProgress *progress,
+                         bool *cancelled) const;
+};
+
+} // namespace mcla
@@ -0,0 +1,166 @@
+#include "textencoding.h"
+
+#include <QList>
+
+#include <algorithm>
+
+namespace mcla {
+
+bool looksLikeText(const QByteArray &data) {
+    if (data.isEmpty()) return false;
+    if (data.contains('\0')) return false;
+    int nonPrintable = 0;
+    for (unsigned char c : data) {
+        if (c == '\n' || c == '\r' || c == '\t') continue;
+        if (c < 0x20 || c == 0x7F) nonPrintable++;
+    }
+    double ratio = static_cast<double>(nonPrintable) / static_cast<double>(data.size());
+    return ratio < 0.02;
+}
+
+// 纯 ASCII 的区段整块跳过，只逐字节检查多字节序列
+bool isValidUtf8(const char *data, qsizetype len) {
+    const unsigned char *s = reinterpret_cast<const unsigned char*>(data);
+    qsizetype i = 0;
+    while (i < len) {
+        i += asciiPrefixLength(data + i, len - i);
+        if (i >= len) break;
+        unsigned char c = s[i];
+        int n = 0;
+        if ((c & 0xE0) == 0xC0) { n = 1; if (c < 0xC2) return false; }
+        else if ((c & 0xF0) == 0xE0) { n = 2; }
+        else if ((c & 0xF8) == 0xF0) { n = 3; if (c > 0xF4) return false; }
+        else return false;
+        if (i + n >= len) return false;
+        for (int k = 1; k <= n; ++k) {
+            if ((s[i+k] & 0xC0) != 0x80) return false;
+        }
+        i += (n + 1);
+    }
+    return true;
+}
+
+bool isValidUtf8(const QByteArray &data) {
+    return isValidUtf8(data.constData(), data.size());
+}
+
+// 去掉末尾被截断的 UTF-8 多字节序列，避免样本本身被误判为非法
+static qsizetype completeUtf8Prefix(const char *data, qsizetype n) {
+    for (qsizetype back = 1; back <= 3 && back <= n; ++back) {
+        const unsigned char c = static_cast<unsigned char>(data[n - back]);
+        if ((c & 0xC0) == 0x80) continue;
+        int len = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+        return len > back ? n - back : n;
+    }
+    return n;
+}
+
+// 样本是否符合 GB18030 的字节结构，且多数双字节字符落在 GB2312 常用汉字区（首尾字节都 >= 0xA1）。
+// 后一条用来和 Latin-1 等单字节编码区分：那些编码里的非 ASCII 字节后面通常紧跟 ASCII 字母
+static bool looksLikeGb18030(const char *data, qsizetype len) {
+    const unsigned char *s = reinterpret_cast<const unsigned char*>(data);
+    qsizetype pairs = 0, common = 0;
+    qsizetype i = 0;
+    while (i < len) {
+        i += asciiPrefixLength(data + i, len - i);
+        if (i + 1 >= len) break;   // 末尾被截断的字符不计
+        const unsigned c = s[i], t = s[i + 1];
+        if (c == 0x80 || c == 0xFF) return false;
+        if (t >= 0x30 && t <= 0x39) {
+            if (i + 3 >= len) break;
+            if (s[i + 2] < 0x81 || s[i + 2] == 0xFF || s[i + 3] < 0x30 || s[i + 3] > 0x39) return false;
+            i += 4;
+            continue;
+        }
+        if (t < 0x40 || t == 0x7F || t == 0xFF) return false;
+        ++pairs;
+        if (c >= 0xA1 && t >= 0xA1) ++common;
+        i += 2;
+    }
+    return pairs > 0 && common * 10 >= pairs * 8;
+}
+
+// 没有 BOM 的 UTF-16：日志以 ASCII 为主，每个字符的高位字节几乎都是 0
+static QStringConverter::Encoding guessUtf16ByteOrder(const char *data, qsizetype len) {
+    len &= ~qsizetype(1);
+    if (len < 16) return QStringConverter::System;
+    qsizetype zeroEven = 0, zeroOdd = 0;
+    for (qsizetype i = 0; i < len; i += 2) {
+        zeroEven += data[i] == 0;
+        zeroOdd += data[i + 1] == 0;
+    }
+    const qsizetype units = len / 2;
+    if (zeroOdd * 10 > units * 4 && zeroEven * 20 < units) return QStringConverter::Utf16LE;
+    if (zeroEven * 10 > units * 4 && zeroOdd * 20 < units) return QStringConverter::Utf16BE;
+    return QStringConverter::System;
+}
+
+bool systemCodecIsMultiByte() {
+    static const bool multiByte = [] {
+        QByteArray high;
+        for (int c = 0x80; c <= 0xFF; ++c) high.append(char(c));
+        return QString(QStringDecoder(QStringConverter::System).decode(high)).size() != high.size();
+    }();
+    return multiByte;
+}
+
+TextEncoding detectTextEncoding(const char *data, qsizetype len) {
+    TextEncoding enc;
+    const unsigned char *s = reinterpret_cast<const unsigned char*>(data);
+    enc.bom = true;
+    if (len >= 3 && s[0] == 0xEF && s[1] == 0xBB && s[2] == 0xBF) return enc;
+    if (len >= 2 && s[0] == 0xFF && s[1] == 0xFE) { enc.encoding = QStringConverter::Utf16LE; return enc; }
+    if (len >= 2 && s[0] == 0xFE && s[1] == 0xFF) { enc.encoding = QStringConverter::Utf16BE; return enc; }
+    enc.bom = false;
+
+    const qsizetype headLen = qMin(len, kEncodingSampleSize);
+    const QStringConverter::Encoding utf16 = guessUtf16ByteOrder(data, headLen);
+    if (utf16 != QStringConverter::System) { enc.encoding = utf16; return enc; }
+
+    // 样本：开头、中间、结尾各一段；后两段从段内第一个换行之后开始，保证多字节字符对齐
+    QList<QByteArrayView> samples{ QByteArrayView(data, headLen) };
+    if (len > 3 * kEncodingSampleSize) {
+        for (qsizetype from : { len / 2, len - kEncodingSampleSize }) {
+            QByteArrayView window(data + from, kEncodingSampleSize);
+            const qsizetype nl = window.indexOf('\n');
+            if (nl >= 0) samples.append(window.sliced(nl + 1));
+        }
+    }
+
+    bool ascii = true, utf8 = true;
+    for (QByteArrayView &w : samples) {
+        w.truncate(completeUtf8Prefix(w.data(), w.size()));
+        if (asciiPrefixLength(w.data(), w.size()) == w.size()) continue;
+        ascii = false;
+        if (!isValidUtf8(w.data(), w.size())) { utf8 = false; break; }
+    }
+    // 纯 ASCII 的样本无论按哪种编码解码结果都相同
+    if (ascii) return enc;
+
+    if (utf8) {
+        qsizetype total = 0, validCount = 0;
+        for (QByteArrayView w : samples) {
+            const QString text = QString::fromUtf8(w);
+            total += text.size();
+            for (QChar ch : text) {
+                if (ch.isLetterOrNumber() || ch.isPunct() || ch.isSpace())
+                    ++validCount;
+            }
+        }
+        if ((double)validCount / total > 0.97) return enc;
+    }
+
+    enc.encoding = QStringConverter::System;
+    if (!utf8 && std::all_of(samples.cbegin(), samples.cend(),
+                             [](QByteArrayView w) { return looksLikeGb18030(w.data(), w.size()); })) {
+        enc.gb18030 = QStringDecoder("GB18030").isValid();
+    }
+    return enc;
+}
+
+QByteArray toWorkingBytes(const QByteArray &bytes, const TextEncoding &enc) {
+    if (enc.isAsciiCompatible()) return bytes;
+    return QString(enc.decoder().decode(bytes)).toUtf8();
+}
+
+} // namespace mcla
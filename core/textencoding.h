@@ -0,0 +1,91 @@
+#pragma once
+
+// ---------------------------- 编码识别 ----------------------------
+// 只在有限的样本（开头、中间、结尾各一段）上做统计判断，随后对完整数据只解码一次
+
+#include <QByteArray>
+#include <QString>
+#include <QStringDecoder>
+#include <QStringEncoder>
+#include <QtAlgorithms>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MCLA_HAVE_SSE2 1
+#else
+#define MCLA_HAVE_SSE2 0
+#endif
+
+namespace mcla {
+
+constexpr qsizetype kEncodingSampleSize = 64 << 10;
+
+// 开头连续 ASCII 字节的长度；用 SSE2 每次检查 16 字节
+inline qsizetype asciiPrefixLength(const char *s, qsizetype n) {
+    qsizetype i = 0;
+#if MCLA_HAVE_SSE2
+    for (; i + 16 <= n; i += 16) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+        if (mask) return i + qCountTrailingZeroBits(static_cast<quint32>(mask));
+    }
+#endif
+    while (i < n && static_cast<unsigned char>(s[i]) < 0x80) ++i;
+    return i;
+}
+
+// 可见字符比例足够高、且不含 NUL 的数据视为文本
+bool looksLikeText(const QByteArray &data);
+
+bool isValidUtf8(const char *data, qsizetype len);
+bool isValidUtf8(const QByteArray &data);
+
+// 系统本地编码是否为多字节编码：单字节编码中 0x80-0xFF 每个字节各解码为一个字符
+bool systemCodecIsMultiByte();
+
+// 识别出的文本编码
+struct TextEncoding {
+    QStringConverter::Encoding encoding = QStringConverter::Utf8;
+    bool gb18030 = false;   // GB18030 不在 QStringConverter::Encoding 中，按名称创建解码器
+    bool bom = false;       // 原文件带 BOM，UTF-16 导出时写回
+
+    QStringDecoder decoder() const {
+        return gb18030 ? QStringDecoder("GB18030") : QStringDecoder(encoding);
+    }
+
+    QStringEncoder encoder(QStringConverter::Flags flags = QStringConverter::Flag::Default) const {
+        return gb18030 ? QStringEncoder("GB18030", flags) : QStringEncoder(encoding, flags);
+    }
+
+    // ASCII 字符在该编码中仍是单个 ASCII 字节，可以直接在原始字节上查找 IP
+    bool isAsciiCompatible() const {
+        return encoding != QStringConverter::Utf16LE && encoding != QStringConverter::Utf16BE;
+    }
+
+    // 多字节字符的尾字节可能落在 ASCII 区间（GB18030、GBK、Big5 等）
+    bool isDoubleByte() const {
+        return gb18030 || (encoding == QStringConverter::System && systemCodecIsMultiByte());
+    }
+
+    // 内部处理时的编码：UTF-16 转成 UTF-8 处理，其余保持原样
+    TextEncoding working() const {
+        return isAsciiCompatible() ? *this : TextEncoding{};
+    }
+
+    QString name() const {
+        if (gb18030) return "GB18030";
+        switch (encoding) {
+        case QStringConverter::Utf8: return "UTF-8";
+        case QStringConverter::Utf16LE: return "UTF-16LE";
+        case QStringConverter::Utf16BE: return "UTF-16BE";
+        default: return "系统编码";
+        }
+    }
+};
+
+// 文件编码识别：BOM → UTF-16 特征 → 样本的 UTF-8 合法性与可见字符比例 → GB18030 特征 → 系统编码
+TextEncoding detectTextEncoding(const char *data, qsizetype len);
+
+// UTF-16 文本在内部转成 UTF-8 处理，其余编码原样使用
+QByteArray toWorkingBytes(const QByteArray &bytes, const TextEncoding &enc);
+
+} // namespace mcla
@@ -4,7 +4,16 @@
 #include <QLabel>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QTextEdit>
+#include <QAbstractScrollArea>
+#include <QScrollBar>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QFontDatabase>
+#include <QCheckBox>
+#include <QProgressBar>
+#include <QStatusBar>
+#include <QTimer>
 #include <QFileDialog>
 #include <QFile>
 #include <QFileInfo>
@@ -12,261 +21,418 @@
 #include <QDragEnterEvent>
 #include <QMimeData>
 #include <QDropEvent>
-#include <QRegularExpression>
-#include <QTemporaryFile>
 #include <QMouseEvent>
 #include <QDrag>
 #include <QUrl>
 #include <QSpacerItem>
-#include <QProcess>
 #include <QDir>
 #include <QStringDecoder>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QTemporaryDir>
+#include <QLocale>
+#include <QSet>
+#include <QLineEdit>
+#include <QIntValidator>
+#include <QShortcut>
+#include <QKeySequence>
+#include <QPlainTextEdit>
+#include <QSyntaxHighlighter>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextCharFormat>
+#include <QClipboard>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
 
-static bool isValidUtf8(const QByteArray &data) {
-    const unsigned char *s = reinterpret_cast<const unsigned char*>(data.constData());
-    size_t i = 0, len = static_cast<size_t>(data.size());
-    while (i < len) {
-        unsigned char c = s[i];
-        if (c <= 0x7F) { i++; continue; }
-        int n = 0;
-        if ((c & 0xE0) == 0xC0) { n = 1; if (c < 0xC2) return false; }
-        else if ((c & 0xF0) == 0xE0) { n = 2; }
-        else if ((c & 0xF8) == 0xF0) { n = 3; if (c > 0xF4) return false; }
-        else return false;
-        if (i + n >= len) return false;
-        for (int k = 1; k <= n; ++k) {
-            if ((s[i+k] & 0xC0) != 0x80) return false;
-        }
-        i += (n + 1);
-    }
-    return true;
-}
+#include "cli/commands.h"
+#include "core/archive.h"
+#include "core/batch.h"
+#include "core/contenthash.h"
+#include "core/exportcache.h"
+#include "core/logfile.h"
+#include "core/logsource.h"
+#include "core/metrics.h"
+#include "core/progress.h"
+#include "core/pseudonyms.h"
+#include "core/redactor.h"
+#include "core/resultcache.h"
+#include "core/rotation.h"
+#include "core/rules.h"
+#include "core/search.h"
+#include "core/textencoding.h"
 
-static bool looksLikeText(const QByteArray &data) {
-    if (data.isEmpty()) return false;
-    if (data.contains('\0')) return false;
-    int nonPrintable = 0;
-    for (unsigned char c : data) {
-        if (c == '\n' || c == '\r' || c == '\t') continue;
-        if (c < 0x20 || c == 0x7F) nonPrintable++;
-    }
-    double ratio = static_cast<double>(nonPrintable) / static_cast<double>(data.size());
-    return ratio < 0.02;
-}
+// 脱敏逻辑都在核心库 mclacore（core/）中，这里只有图形界面
+using namespace mcla;
 
-// 文件编码识别，这是我能想到的实现，应该还有更好的方法
-static QString decodeBestEffort(const QByteArray &data) {
-    if (data.isEmpty()) return {};
+// ---------------------------- 日志预览 ----------------------------
+// 只读日志视图：直接持有日志的原始字节并建立行起始偏移索引，只解码、绘制可见的行，
+// 千万行的日志也能流畅滚动。脱敏结果不再生成新文档，而是按匹配区间在原文上跳过被删除的部分并做标记
 
-    QString utf8Text = QString::fromUtf8(data.constData(), data.size());
-    if (isValidUtf8(data)) {
-        int validCount = 0;
-        for (QChar ch : utf8Text) {
-            if (ch.isLetterOrNumber() || ch.isPunct() || ch.isSpace())
-                ++validCount;
-        }
-        double ratio = (double)validCount / utf8Text.size();
-        if (ratio > 0.97) {
-            return utf8Text;
-        }
+class LogView : public QAbstractScrollArea {
+public:
+    enum class RedactionMode { Removed, Highlighted };
+
+    explicit LogView(QWidget *parent = nullptr) : QAbstractScrollArea(parent) {
+        setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+        setFocusPolicy(Qt::StrongFocus);
+        viewport()->setCursor(Qt::IBeamCursor);
     }
 
-    return QString::fromLocal8Bit(data.constData(), data.size());
-}
+    // data 必须是 ASCII 兼容编码（见 TextEncoding::working）；data 指向文件映射时 mapping 持有该映射
+    void setLogBytes(const QByteArray &data, const TextEncoding &enc, std::shared_ptr<QFile> mapping = {}) {
+        redacted.reset();
+        bytes = data;
+        bytesMapping = std::move(mapping);
+        encoding = enc;
+        lines = std::make_shared<const LineIndex>(bytes);
+        match = {};
+        verticalScrollBar()->setValue(0);
+        horizontalScrollBar()->setValue(0);
+        updateScrollBars();
+        viewport()->update();
+    }
 
-static QByteArray runProcessCapture(const QString &program, const QStringList &args, int msecTimeout = 10000, int *exitCodeOut = nullptr) {
-    QProcess p;
-    p.start(program, args);
-    if (!p.waitForStarted(2000)) return {};
-    if (!p.waitForFinished(msecTimeout)) {
-        p.kill(); p.waitForFinished();
-        return {};
-    }
-    if (exitCodeOut) *exitCodeOut = p.exitCode();
-    if (p.exitCode() != 0) return {};
-    return p.readAllStandardOutput();
-}
+    void setPlainText(const QString &content) {
+        setLogBytes(content.toUtf8(), TextEncoding{});
+    }
 
-// 寻找系统可用的解压工具（优先 7z）
-static bool hasProgram(const QString &name) {
-    int code = -1;
-    runProcessCapture(name, { "--help" }, 2000, &code);
-    if (code == 0 || code == 1) return true;
-#if defined(Q_OS_WIN)
-    QStringList candidates = {
-        "C:/Program Files/7-Zip/7z.exe",
-        "C:/Program Files (x86)/7-Zip/7z.exe"
-    };
-    for (const auto &c : candidates) {
-        int cexit = -1;
-        runProcessCapture(c, { "--help" }, 2000, &cexit);
-        if (cexit == 0 || cexit == 1) return true;
+    // 显示脱敏效果，空表示显示原文
+    void setRedactions(std::shared_ptr<const RedactedLog> result) {
+        redacted = std::move(result);
+        match = {};
+        viewport()->update();
     }
-#endif
-    return false;
-}
 
-static QString programPathIfExists(const QString &name) {
-    int code = -1;
-    runProcessCapture(name, { "--help" }, 2000, &code);
-    if (code == 0 || code == 1) return name;
-#if defined(Q_OS_WIN)
-    QStringList candidates = {
-        "C:/Program Files/7-Zip/7z.exe",
-        "C:/Program Files (x86)/7-Zip/7z.exe"
-    };
-    for (const auto &c : candidates) {
-        int cexit = -1;
-        runProcessCapture(c, { "--help" }, 2000, &cexit);
-        if (cexit == 0 || cexit == 1) return c;
+    void setRedactionMode(RedactionMode m) {
+        mode = m;
+        match = {};
+        viewport()->update();
     }
-#endif
-    return QString();
-}
 
-// 读取普通文本文件
-static QString readTextFileAuto(const QString &path) {
-    QFile f(path);
-    if (!f.open(QIODevice::ReadOnly)) return QString();
-    QByteArray data = f.readAll();
-    f.close();
-    return decodeBestEffort(data);
-}
+    const QByteArray &logBytes() const { return bytes; }
+    const std::shared_ptr<QFile> &logMapping() const { return bytesMapping; }
+    const TextEncoding &textEncoding() const { return encoding; }
+    const std::shared_ptr<const LineIndex> &lineIndex() const { return lines; }
+    // 当前显示所依据的脱敏结果：对照原文或尚未脱敏时为空
+    std::shared_ptr<const RedactedLog> shownRedactions() const {
+        return mode == RedactionMode::Removed ? redacted : nullptr;
+    }
 
-// 从 .gz 读取
-static QByteArray readGzViaTools(const QString &path) {
-    QString seven = programPathIfExists("7z");
-    if (!seven.isEmpty()) {
-        QByteArray out = runProcessCapture(seven, {"x", "-so", path});
-        if (!out.isEmpty()) return out;
-    }
-    QByteArray out = runProcessCapture("gzip", {"-cd", path});
-    if (!out.isEmpty()) return out;
-#if defined(Q_OS_WIN)
-    out = runProcessCapture("tar", {"-xOzf", path});
-    if (!out.isEmpty()) return out;
-#endif
-    return {};
-}
+    qsizetype topLine() const { return verticalScrollBar()->value(); }
 
-// 从 .zip 读取
-static QByteArray readZipEntryText(const QString &zipPath, QString *pickedNameOut = nullptr) {
-    QString seven = programPathIfExists("7z");
-    if (!seven.isEmpty()) {
-        QByteArray list = runProcessCapture(seven, {"l", "-ba", zipPath});
-        if (!list.isEmpty()) {
-            QList<QByteArray> lines = list.split('\n');
-            QString picked;
-            for (auto &ln : lines) {
-                QString s = QString::fromLocal8Bit(ln).trimmed();
-                if (s.isEmpty()) continue;
-                QString name = s.section(' ', -1);
-                if (name.endsWith('/') || name.endsWith('\\')) continue; // 目录
-                QString low = name.toLower();
-                if (low.endsWith(".log") || low.endsWith(".txt")) { picked = name; break; }
-            }
-            if (!picked.isEmpty()) {
-                if (pickedNameOut) *pickedNameOut = picked;
-                QByteArray out = runProcessCapture(seven, {"x", "-so", zipPath, picked});
-                return out;
-            }
-            for (auto &ln : lines) {
-                QString s = QString::fromLocal8Bit(ln).trimmed();
-                if (s.isEmpty()) continue;
-                QString name = s.section(' ', -1);
-                if (name.endsWith('/') || name.endsWith('\\')) continue;
-                if (pickedNameOut) *pickedNameOut = name;
-                QByteArray out = runProcessCapture(seven, {"x", "-so", zipPath, name});
-                return out;
-            }
+    // 把第 line 行滚动到可见区域的约 1/3 处
+    void scrollToLine(qsizetype line) {
+        const QFontMetrics fm(font());
+        const int visibleLines = qMax(1, (viewport()->height() - 2 * kMargin) / fm.lineSpacing());
+        verticalScrollBar()->setValue(int(qMax<qsizetype>(0, line - visibleLines / 3)));
+    }
+
+    // 高亮显示查找的命中（在该行显示内容中的字节区间）并滚动到它所在的位置；无效的位置清除高亮
+    void showMatch(const SearchHit &hit, qsizetype size) {
+        match = {};
+        if (hit.isValid() && hit.line < lineCount()) {
+            // 字节偏移换成显示的列：解码该行命中之前与命中的内容
+            const QByteArray shown = displayedLine(bytes, *lines, shownRedactions().get(), hit.line);
+            QStringDecoder decoder = encoding.decoder();
+            const qsizetype at = qMin(hit.offset, shown.size());
+            match.line = hit.line;
+            match.column = decoder.decode(QByteArrayView(shown).first(at)).size();
+            match.length = decoder.decode(QByteArrayView(shown).sliced(at, qMin(size, shown.size() - at))).size();
+            scrollToLine(hit.line);
+            const int charWidth = qMax(1, QFontMetrics(font()).horizontalAdvance(QLatin1Char('0')));
+            const int x = int(match.column) * charWidth;
+            QScrollBar *h = horizontalScrollBar();
+            if (x < h->value() || x + int(match.length) * charWidth > h->value() + viewport()->width() - 2 * kMargin)
+                h->setValue(qMax(0, x - viewport()->width() / 3));
         }
+        viewport()->update();
+    }
+
+    void setPlaceholderText(const QString &placeholder) {
+        placeholderText = placeholder;
+        viewport()->update();
     }
 
-    QByteArray list = runProcessCapture("unzip", {"-Z1", zipPath});
-    if (!list.isEmpty()) {
-        QList<QByteArray> files = list.split('\n');
-        QString picked;
-        for (auto &fnBA : files) {
-            QString name = QString::fromLocal8Bit(fnBA).trimmed();
-            if (name.isEmpty()) continue;
-            QString low = name.toLower();
-            if (low.endsWith(".log") || low.endsWith(".txt")) { picked = name; break; }
+    qsizetype lineCount() const { return lines ? lines->count() : 0; }
+
+protected:
+    void paintEvent(QPaintEvent *) override {
+        QPainter p(viewport());
+        p.fillRect(viewport()->rect(), palette().base());
+        const QFontMetrics fm(font());
+
+        if (bytes.isEmpty()) {
+            p.setPen(palette().placeholderText().color());
+            p.drawText(viewport()->rect().adjusted(kMargin, kMargin, -kMargin, -kMargin),
+                       Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, placeholderText);
+            return;
         }
-        if (picked.isEmpty() && !files.isEmpty()) picked = QString::fromLocal8Bit(files.first()).trimmed();
-        if (!picked.isEmpty()) {
-            QByteArray out = runProcessCapture("unzip", {"-p", zipPath, picked});
-            if (!out.isEmpty()) {
-                if (pickedNameOut) *pickedNameOut = picked;
-                return out;
+
+        const int lineHeight = fm.lineSpacing();
+        const int charWidth = qMax(1, fm.horizontalAdvance(QLatin1Char('0')));
+        const int hOffset = horizontalScrollBar()->value();
+        const qsizetype firstCol = qMax(0, hOffset / charWidth - 8);
+        const qsizetype cols = viewport()->width() / charWidth + 16;
+        const int x0 = kMargin + int(firstCol) * charWidth - hOffset;
+        const QColor markColor(220, 50, 50);
+        QStringDecoder decoder = encoding.decoder();
+
+        const qsizetype first = verticalScrollBar()->value();
+        const qsizetype last = qMin(lineCount(), first + viewport()->height() / lineHeight + 2);
+        for (qsizetype line = first; line < last; ++line) {
+            const int y = kMargin + int(line - first) * lineHeight;
+            QList<QPair<int, int>> marks;
+            const QString visible = visibleText(decoder, line, firstCol, cols, marks);
+
+            if (line == match.line) {
+                const qsizetype from = qMax(match.column, firstCol) - firstCol;
+                const qsizetype to = qMin(match.column + match.length, firstCol + visible.size()) - firstCol;
+                if (from < to) {
+                    const int a = x0 + fm.horizontalAdvance(visible.left(from));
+                    const int b = x0 + fm.horizontalAdvance(visible.left(to));
+                    p.fillRect(a, y, b - a, lineHeight, QColor(255, 225, 120));
+                }
             }
+
+            for (const auto &m : marks) {
+                const int a = x0 + fm.horizontalAdvance(visible.left(m.first));
+                if (m.first == m.second) {
+                    p.fillRect(a - 1, y, 2, lineHeight, markColor);
+                } else {
+                    const int b = x0 + fm.horizontalAdvance(visible.left(m.second));
+                    p.fillRect(a, y, b - a, lineHeight, QColor(255, 200, 200));
+                }
+            }
+            p.setPen(palette().text().color());
+            p.drawText(x0, y + fm.ascent(), visible);
         }
     }
-    return {};
-}
 
-// 从 .tar.gz 读取
-static QByteArray readTarGzEntryText(const QString &tgzPath, QString *pickedNameOut = nullptr) {
-    QString seven = programPathIfExists("7z");
-    if (!seven.isEmpty()) {
-        QByteArray list = runProcessCapture(seven, {"l", "-ba", tgzPath});
-        if (!list.isEmpty()) {
-            QList<QByteArray> lines = list.split('\n');
-            QString picked;
-            for (auto &ln : lines) {
-                QString s = QString::fromLocal8Bit(ln).trimmed();
-                if (s.isEmpty()) continue;
-                QString name = s.section(' ', -1);
-                if (name.endsWith('/') || name.endsWith('\\')) continue;
-                QString low = name.toLower();
-                if (low.endsWith(".log") || low.endsWith(".txt")) { picked = name; break; }
-            }
-            if (picked.isEmpty()) {
-                for (auto &ln : lines) {
-                    QString s = QString::fromLocal8Bit(ln).trimmed();
-                    if (s.isEmpty()) continue;
-                    QString name = s.section(' ', -1);
-                    if (name.endsWith('/') || name.endsWith('\\')) continue;
-                    picked = name; break;
+    void resizeEvent(QResizeEvent *event) override {
+        QAbstractScrollArea::resizeEvent(event);
+        updateScrollBars();
+    }
+
+    void changeEvent(QEvent *event) override {
+        QAbstractScrollArea::changeEvent(event);
+        if (event->type() == QEvent::FontChange) updateScrollBars();
+    }
+
+private:
+    static constexpr int kMargin = 4;
+    // 一个字符在 UTF-8 / GB18030 中最多占 4 字节，解码一行时只取可能可见的前缀
+    static constexpr qsizetype kMaxCharBytes = 4;
+
+    QByteArray bytes;
+    std::shared_ptr<QFile> bytesMapping;
+    TextEncoding encoding;
+    // 行起始偏移索引，查找时与工作线程共用
+    std::shared_ptr<const LineIndex> lines;
+    std::shared_ptr<const RedactedLog> redacted;
+    RedactionMode mode = RedactionMode::Removed;
+    QString placeholderText;
+    // 当前查找命中的位置（显示的列），line 为 -1 表示没有
+    struct {
+        qsizetype line = -1;
+        qsizetype column = 0;
+        qsizetype length = 0;
+    } match;
+
+    // 取出某行落在显示列 [firstCol, firstCol + cols) 内的文字；marks 为需要标记的列区间
+    // （Removed 模式下被删除处是零宽标记、被替换处是高亮的替换文本，Highlighted 模式下是原文中的高亮区间）。
+    // 命中的区间都落在字符边界上，各段可以分别解码
+    QString visibleText(QStringDecoder &decoder, qsizetype line, qsizetype firstCol, qsizetype cols,
+                        QList<QPair<int, int>> &marks) const {
+        const qsizetype ls = lines->start(line);
+        const qsizetype winEnd = firstCol + cols;
+        const qsizetype le = qMin(lines->contentEnd(bytes, line), ls + winEnd * kMaxCharBytes);
+        QString out;
+        qsizetype col = 0;
+        decoder.resetState();
+
+        // span 为命中区间的下标，-1 表示未命中的原文
+        auto emitPiece = [&](qsizetype b, qsizetype e, qsizetype span) {
+            const bool hit = span >= 0;
+            QString piece;
+            if (hit && mode == RedactionMode::Removed) {
+                piece = decoder.decode(redacted->replacement(span));
+                if (piece.isEmpty()) {
+                    if (col >= firstCol && col <= winEnd) marks.append({ int(col - firstCol), int(col - firstCol) });
+                    return;
                 }
+            } else {
+                piece = decoder.decode(QByteArrayView(bytes.constData() + b, e - b));
             }
-            if (!picked.isEmpty()) {
-                if (pickedNameOut) *pickedNameOut = picked;
-                QByteArray out = runProcessCapture(seven, {"x", "-so", tgzPath, picked});
-                if (!out.isEmpty()) return out;
+            const qsizetype from = qMax(col, firstCol);
+            const qsizetype to = qMin(col + piece.size(), winEnd);
+            if (from < to) {
+                if (hit) marks.append({ int(from - firstCol), int(to - firstCol) });
+                out.append(piece.constData() + (from - col), to - from);
+            }
+            col += piece.size();
+        };
+
+        qsizetype pos = ls;
+        if (redacted) {
+            const QList<TextSpan> &spans = redacted->spans;
+            auto it = std::lower_bound(spans.cbegin(), spans.cend(), ls,
+                                       [](const TextSpan &s, qsizetype p) { return s.end <= p; });
+            for (; it != spans.cend() && it->start < le && col < winEnd; ++it) {
+                const qsizetype s = qMax(it->start, ls);
+                const qsizetype e = qMin(it->end, le);
+                if (s > pos) emitPiece(pos, s, -1);
+                emitPiece(s, e, it - spans.cbegin());
+                pos = e;
             }
         }
+        if (pos < le && col < winEnd) emitPiece(pos, le, -1);
+        out.replace(u'\t', u' ');
+        return out;
+    }
+
+    void updateScrollBars() {
+        const QFontMetrics fm(font());
+        const int visibleLines = qMax(1, (viewport()->height() - 2 * kMargin) / fm.lineSpacing());
+        verticalScrollBar()->setRange(0, int(qMax<qsizetype>(0, lineCount() - visibleLines)));
+        verticalScrollBar()->setPageStep(visibleLines);
+        verticalScrollBar()->setSingleStep(1);
+
+        const qint64 width = qint64(lines ? lines->longest() : 0) * qMax(1, fm.horizontalAdvance(QLatin1Char('0'))) + 2 * kMargin;
+        horizontalScrollBar()->setRange(0, int(qBound<qint64>(0, width - viewport()->width(), INT_MAX)));
+        horizontalScrollBar()->setPageStep(viewport()->width());
+        horizontalScrollBar()->setSingleStep(fm.horizontalAdvance(QLatin1Char('0')) * 4);
+    }
+};
+
+// ---------------------------- 粘贴模式 ----------------------------
+// 可直接粘贴或编辑日志片段的文本框。每行（文本块）的命中保存在该块的用户数据中；文本改动时
+// QSyntaxHighlighter 只重新处理 contentsChange 涉及的块，而各规则的命中不跨行，整行就是足够的上下文，
+// 被编辑拆开或拼起来的 IP 也能正确判定。文本再大，打字时也只扫描当前这一行，命中总数按行增减
+
+class RedactionHighlighter : public QSyntaxHighlighter {
+public:
+    explicit RedactionHighlighter(QTextDocument *doc)
+        : QSyntaxHighlighter(doc), rules(activeRuleSet()), scanner(std::make_unique<Redactor>(rules, TextEncoding{}, false)) {
+        hitFormat.setBackground(QColor(255, 200, 200));
+        hitFormat.setFontStrikeOut(true);
+    }
+
+    // 命中总数变化时调用（可能很频繁，由调用方合并刷新）
+    std::function<void()> onHitsChanged;
+
+    // 规则变了，重新处理全部文本
+    void reset() {
+        rules = activeRuleSet();
+        scanner = std::make_unique<Redactor>(rules, TextEncoding{}, false);
+        rehighlight();
     }
 
-    QByteArray list = runProcessCapture("tar", {"-tzf", tgzPath});
-    if (!list.isEmpty()) {
-        QList<QByteArray> lines = list.split('\n');
-        QString picked;
-        for (auto &ln : lines) {
-            QString name = QString::fromLocal8Bit(ln).trimmed();
-            if (name.isEmpty()) continue;
-            if (name.endsWith('/')) continue;
-            QString low = name.toLower();
-            if (low.endsWith(".log") || low.endsWith(".txt")) { picked = name; break; }
-        }
-        if (picked.isEmpty()) {
-            for (auto &ln : lines) {
-                QString name = QString::fromLocal8Bit(ln).trimmed();
-                if (name.isEmpty()) continue;
-                if (name.endsWith('/')) continue;
-                picked = name; break;
+    const RuleSet &ruleSet() const { return *rules; }
+    const std::array<qint64, kMaxRules> &hitCounts() const { return totals->counts; }
+
+    // 脱敏后的全文（UTF-8）。一致化替换的编号在此时按文本中的顺序分配，打字过程中不完整的 IP 不会占用编号
+    QByteArray anonymizedText() const {
+        Redactor redactor(rules, TextEncoding{});
+        QByteArray out;
+        for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+            const QByteArray line = block.text().toUtf8();
+            auto *hits = static_cast<const LineHits*>(block.userData());
+            RedactedLog rescanned;
+            if (!hits || hits->size != line.size()) {
+                // 尚未处理的块（设置文档后的首次处理是延后进行的）：用高亮的扫描器补扫，不为每块新建
+                redactSegment(*scanner, line, rescanned);
             }
+            const RedactedLog &r = hits && hits->size == line.size() ? hits->result : rescanned;
+            qsizetype last = 0;
+            for (qsizetype i = 0; i < r.spans.size(); ++i) {
+                const TextSpan &span = r.spans[i];
+                out.append(line.constData() + last, span.start - last);
+                if (!redactor.appendPseudonym(out, line.constData(), span.start, span.end, span.rule))
+                    out.append(r.replacement(i));
+                last = span.end;
+            }
+            out.append(line.constData() + last, line.size() - last);
+            if (block.next().isValid()) out.append('\n');
         }
-        if (!picked.isEmpty()) {
-            if (pickedNameOut) *pickedNameOut = picked;
-            QByteArray out = runProcessCapture("tar", {"-xOzf", tgzPath, picked});
-            if (!out.isEmpty()) return out;
+        return out;
+    }
+
+protected:
+    void highlightBlock(const QString &text) override {
+        const QByteArray line = text.toUtf8();
+        auto hits = std::make_unique<LineHits>(totals);
+        hits->size = line.size();
+        redactSegment(*scanner, line, hits->result);
+
+        // 字节偏移换成 UTF-16 位置：非后续字节各占一个单位，四字节字符占两个
+        qsizetype byte = 0, unit = 0;
+        const auto advanceTo = [&](qsizetype target) {
+            for (; byte < target; ++byte) {
+                const uchar c = uchar(line[byte]);
+                if ((c & 0xC0) != 0x80) unit += c >= 0xF0 ? 2 : 1;
+            }
+            return unit;
+        };
+        for (const TextSpan &span : hits->result.spans) {
+            const qsizetype from = advanceTo(span.start);
+            setFormat(int(from), int(advanceTo(span.end) - from), hitFormat);
+            ++totals->counts[size_t(span.rule)];
         }
+        const bool changed = !hits->result.spans.isEmpty() || currentBlockUserData();
+        setCurrentBlockUserData(hits.release());   // 替换（并销毁）该块之前的结果
+        if (changed && onHitsChanged) onHitsChanged();
     }
-    return {};
-}
+
+private:
+    struct Totals {
+        std::array<qint64, kMaxRules> counts{};
+    };
+
+    // 一行的命中，随文本块一起销毁，销毁时从总数中扣除
+    struct LineHits : QTextBlockUserData {
+        explicit LineHits(std::shared_ptr<Totals> totals) : totals(std::move(totals)) {}
+        ~LineHits() override {
+            for (const TextSpan &span : result.spans) --totals->counts[size_t(span.rule)];
+        }
+        std::shared_ptr<Totals> totals;
+        RedactedLog result;
+        qsizetype size = 0;   // 处理时该行的 UTF-8 字节数
+    };
+
+    RuleSetPtr rules;
+    std::unique_ptr<Redactor> scanner;   // 只找命中，不分配编号
+    std::shared_ptr<Totals> totals = std::make_shared<Totals>();
+    QTextCharFormat hitFormat;
+};
 
 // ---------------------------- 主窗口 ----------------------------
+
+// 队列中每个文件整体载入内存的上限（压缩文件按解压后估计），超过的改为流式处理，少数大文件不会占满内存
+constexpr qint64 kQueueMemoryLimit = kStreamingThreshold / 2;
+
+// 文件队列中的一项；只在界面线程中读写，工作线程只使用提交时的 progress 与 metrics
+struct QueueEntry {
+    enum class State { Waiting, Running, Done, Failed };
+
+    QString input;
+    QString relativeDir;   // 批量导出时在目标目录中的相对位置（拖入文件夹时保留其目录结构）
+    State state = State::Waiting;
+    // 当前这次处理的进度与统计，重新排队时换成新的；工作线程完成时据此判断结果是否已过期
+    std::shared_ptr<TaskProgress> progress;
+    std::shared_ptr<RunMetrics> metrics;
+    QString target;   // 临时目录中的脱敏结果
+    QString error;
+    QTreeWidgetItem *row = nullptr;
+};
+
 class MainWindow : public QMainWindow {
     Q_OBJECT
 public:
@@ -283,22 +449,30 @@ public:
         QLabel *lbl = new QLabel(
             "点击【打开文件】选择待处理的日志文件，或将日志文件拖入窗口任意位置\n"
             "点击【脱敏并预览】后将自动删除文件中的所有 IP 地址及端口\n"
-            "支持直接打开包含单个文件的 .gz / .zip / .tar.gz 压缩包"
+            "支持直接打开包含单个文件的 .gz / .zip / .tar.gz 压缩包\n"
+            "点击【规则…】可加载规则文件，额外处理 IPv6、UUID、主机名、玩家名单等\n"
+            "同时拖入多个文件或文件夹时加入下方队列并行脱敏，完成后可批量导出到指定目录\n"
+            "预览下方可查找文本（Ctrl+F）或跳到指定行（Ctrl+L）；【粘贴模式】可直接粘贴日志片段，实时标出将被删除的内容"
         );
         lbl->setWordWrap(true);
         vlay->addWidget(lbl);
 
         auto *h1 = new QHBoxLayout;
         fileLabel = new QLabel("未选中文件");
-        QPushButton *openBtn = new QPushButton("打开文件");
+        openBtn = new QPushButton("打开文件");
         anonymizeBtn = new QPushButton("脱敏并预览");
         anonymizeBtn->setEnabled(false);
+        rulesBtn = new QPushButton("规则…");
+        updateRulesTip();
+        pasteBtn = new QPushButton("粘贴模式");
+        pasteBtn->setCheckable(true);
+        pasteBtn->setToolTip("直接粘贴或编辑日志片段，输入时实时标出将被删除的内容");
 
         qreal scale = this->devicePixelRatioF();
         int minH = int(30 * scale);
         int minW = int(100 * scale);
 
-        QList<QPushButton*> btns = { openBtn, anonymizeBtn };
+        QList<QPushButton*> btns = { pasteBtn, rulesBtn, openBtn, anonymizeBtn };
         for (auto *btn : btns) {
             btn->setMinimumSize(minW, minH);
             QFont f = btn->font();
@@ -308,16 +482,90 @@ public:
 
         h1->addWidget(fileLabel);
         h1->addItem(new QSpacerItem(10,10,QSizePolicy::Expanding,QSizePolicy::Minimum));
+        highlightBox = new QCheckBox("对照原文");
+        highlightBox->setToolTip("显示原文并高亮将被删除的内容");
+        highlightBox->setEnabled(false);
+        pseudonymBox = new QCheckBox("一致化替换");
+        pseudonymBox->setToolTip("把每个不同的 IP 与端口替换为固定编号（如 IP-0001:PORT-07），而不是直接删除；\n"
+                                 "编号在本次运行中对所有文件保持一致，便于分辨同一玩家的多次连接");
+
+        h1->addWidget(pseudonymBox);
+        h1->addWidget(highlightBox);
+        h1->addWidget(rulesBtn);
+        h1->addWidget(pasteBtn);
         h1->addWidget(openBtn);
         h1->addWidget(anonymizeBtn);
         vlay->addLayout(h1);
 
-        preview = new QTextEdit;
-        preview->setReadOnly(true);
+        preview = new LogView;
         preview->setAcceptDrops(false);
         preview->setPlaceholderText("导入文件后会在此显示原始内容；点击“脱敏并预览”生成脱敏内容。");
         vlay->addWidget(preview);
 
+        // 粘贴模式的文本框，与预览区互相替换显示
+        pasteEdit = new QPlainTextEdit;
+        pasteEdit->setAcceptDrops(false);
+        pasteEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+        pasteEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+        pasteEdit->setPlaceholderText("在此粘贴或输入日志内容，将被删除的内容会实时标出");
+        pasteEdit->setVisible(false);
+        pasteHighlighter = new RedactionHighlighter(pasteEdit->document());
+        vlay->addWidget(pasteEdit);
+
+        pasteBar = new QWidget;
+        auto *hp = new QHBoxLayout(pasteBar);
+        hp->setContentsMargins(0, 0, 0, 0);
+        pasteHitsLabel = new QLabel;
+        copyPasteBtn = new QPushButton("复制脱敏结果");
+        savePasteBtn = new QPushButton("保存为文件…");
+        hp->addWidget(pasteHitsLabel, 1);
+        hp->addWidget(copyPasteBtn);
+        hp->addWidget(savePasteBtn);
+        pasteBar->setVisible(false);
+        vlay->addWidget(pasteBar);
+        // 命中总数在输入时频繁变化，合并后刷新
+        pasteHitsTimer = new QTimer(this);
+        pasteHitsTimer->setSingleShot(true);
+        pasteHitsTimer->setInterval(100);
+        connect(pasteHitsTimer, &QTimer::timeout, this, &MainWindow::updatePasteHits);
+        pasteHighlighter->onHitsChanged = [this] {
+            if (!pasteHitsTimer->isActive()) pasteHitsTimer->start();
+        };
+
+        // 查找与跳转：在预览显示的内容（脱敏后，或对照原文时的原文）中查找
+        searchBar = new QWidget;
+        auto *hs = new QHBoxLayout(searchBar);
+        hs->setContentsMargins(0, 0, 0, 0);
+        searchEdit = new QLineEdit;
+        searchEdit->setPlaceholderText("查找（回车 / F3 下一个，Shift+F3 上一个）");
+        searchEdit->setClearButtonEnabled(true);
+        caseBox = new QCheckBox("区分大小写");
+        prevBtn = new QPushButton("上一个");
+        nextBtn = new QPushButton("下一个");
+        searchLabel = new QLabel;
+        gotoEdit = new QLineEdit;
+        gotoEdit->setPlaceholderText("跳到行 Ctrl+L");
+        gotoEdit->setValidator(new QIntValidator(1, INT_MAX, gotoEdit));
+        gotoEdit->setMaximumWidth(int(100 * scale));
+        hs->addWidget(searchEdit, 1);
+        hs->addWidget(caseBox);
+        hs->addWidget(prevBtn);
+        hs->addWidget(nextBtn);
+        hs->addWidget(searchLabel);
+        hs->addItem(new QSpacerItem(10,10,QSizePolicy::Expanding,QSizePolicy::Minimum));
+        hs->addWidget(gotoEdit);
+        vlay->addWidget(searchBar);
+
+        // 文件队列：每个文件一行，显示各自的进度与结果，双击在上方预览
+        queueList = new QTreeWidget;
+        queueList->setHeaderLabels({ "文件", "大小", "状态" });
+        queueList->setRootIsDecorated(false);
+        queueList->setUniformRowHeights(true);
+        queueList->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+        queueList->setMaximumHeight(int(180 * scale));
+        queueList->setVisible(false);
+        vlay->addWidget(queueList);
+
         auto *h2 = new QHBoxLayout;
         dragExportBtn = new QPushButton("拖拽导出");
         dragExportBtn->setToolTip("可拖拽至文件夹快速导出");
@@ -328,7 +576,20 @@ public:
         saveBtn = new QPushButton("导出文件");
         saveBtn->setEnabled(false);
 
-        QList<QPushButton*> btns2 = { dragExportBtn, saveBtn };
+        archiveBtn = new QPushButton("导出压缩包");
+        archiveBtn->setToolTip("脱敏压缩包中的所有文本文件（含嵌套的 .gz），并重新打包为同类型压缩包");
+        archiveBtn->setEnabled(false);
+
+        mergeBtn = new QPushButton("合并轮转日志");
+        mergeBtn->setToolTip("把 logs 目录中的 latest.log 与 YYYY-MM-DD-N.log.gz 脱敏后按时间合并为一个文件");
+
+        clearQueueBtn = new QPushButton("清空队列");
+        clearQueueBtn->setVisible(false);
+        exportQueueBtn = new QPushButton("批量导出");
+        exportQueueBtn->setToolTip("把队列中已完成的文件导出到指定目录，文件夹中的文件保留原有的目录结构");
+        exportQueueBtn->setVisible(false);
+
+        QList<QPushButton*> btns2 = { dragExportBtn, mergeBtn, archiveBtn, saveBtn, clearQueueBtn, exportQueueBtn };
         for (auto *btn : btns2) {
             btn->setMinimumSize(minW, minH);
             QFont f = btn->font();
@@ -339,24 +600,108 @@ public:
         h2->addWidget(dragExportBtn);
         h2->addWidget(exportNoteLabel);
         h2->addItem(new QSpacerItem(10,10,QSizePolicy::Expanding,QSizePolicy::Minimum));
+        h2->addWidget(clearQueueBtn);
+        h2->addWidget(exportQueueBtn);
+        h2->addWidget(mergeBtn);
+        h2->addWidget(archiveBtn);
         h2->addWidget(saveBtn);
         vlay->addLayout(h2);
 
         connect(openBtn, &QPushButton::clicked, this, &MainWindow::onOpenFile);
         connect(anonymizeBtn, &QPushButton::clicked, this, &MainWindow::onAnonymize);
+        connect(rulesBtn, &QPushButton::clicked, this, &MainWindow::onLoadRules);
         connect(saveBtn, &QPushButton::clicked, this, &MainWindow::onSaveAs);
+        connect(archiveBtn, &QPushButton::clicked, this, &MainWindow::onExportArchive);
+        connect(mergeBtn, &QPushButton::clicked, this, &MainWindow::onMergeRotation);
+        connect(exportQueueBtn, &QPushButton::clicked, this, &MainWindow::onExportQueue);
+        connect(clearQueueBtn, &QPushButton::clicked, this, &MainWindow::clearQueue);
+        connect(queueList, &QTreeWidget::itemDoubleClicked, this, [this](QTreeWidgetItem *row) {
+            for (const auto &entry : queue)
+                if (entry->row == row) loadFile(entry->input);
+        });
+        connect(pseudonymBox, &QCheckBox::toggled, this, [this](bool on) {
+            if (on && !sessionPseudonyms) sessionPseudonyms = std::make_shared<PseudonymTable>();
+            setActivePseudonymTable(on ? sessionPseudonyms : nullptr);
+            discardAnonymized();
+        });
+        connect(highlightBox, &QCheckBox::toggled, this, [this](bool on) {
+            preview->setRedactionMode(on ? LogView::RedactionMode::Highlighted : LogView::RedactionMode::Removed);
+            resetSearch();
+        });
+        connect(pasteBtn, &QPushButton::toggled, this, &MainWindow::setPasteMode);
+        connect(copyPasteBtn, &QPushButton::clicked, this, [this] {
+            QApplication::clipboard()->setText(QString::fromUtf8(pasteHighlighter->anonymizedText()));
+            statusBar()->showMessage("已复制脱敏后的内容", 3000);
+        });
+        connect(savePasteBtn, &QPushButton::clicked, this, &MainWindow::onSavePasted);
+        connect(searchEdit, &QLineEdit::textChanged, this, &MainWindow::resetSearch);
+        connect(caseBox, &QCheckBox::toggled, this, &MainWindow::resetSearch);
+        connect(searchEdit, &QLineEdit::returnPressed, this, [this] { findInPreview(true); });
+        connect(nextBtn, &QPushButton::clicked, this, [this] { findInPreview(true); });
+        connect(prevBtn, &QPushButton::clicked, this, [this] { findInPreview(false); });
+        connect(gotoEdit, &QLineEdit::returnPressed, this, &MainWindow::onGotoLine);
+        connect(new QShortcut(QKeySequence::Find, this), &QShortcut::activated, this, [this] {
+            searchEdit->setFocus();
+            searchEdit->selectAll();
+        });
+        connect(new QShortcut(QKeySequence::FindNext, this), &QShortcut::activated, this, [this] { findInPreview(true); });
+        connect(new QShortcut(QKeySequence::FindPrevious, this), &QShortcut::activated, this, [this] { findInPreview(false); });
+        connect(new QShortcut(QKeySequence("Ctrl+L"), this), &QShortcut::activated, this, [this] {
+            gotoEdit->setFocus();
+            gotoEdit->selectAll();
+        });
+
+        // 后台任务的进度显示在状态栏，空闲时隐藏
+        taskLabel = new QLabel;
+        progressBar = new QProgressBar;
+        progressBar->setMaximumWidth(int(240 * scale));
+        progressBar->setTextVisible(false);
+        cancelBtn = new QPushButton("取消");
+        // 当前文件各阶段的耗时、吞吐量与峰值内存
+        metricsLabel = new QLabel;
+        statusBar()->addPermanentWidget(metricsLabel);
+        statusBar()->addPermanentWidget(taskLabel);
+        statusBar()->addPermanentWidget(progressBar);
+        statusBar()->addPermanentWidget(cancelBtn);
+        setTaskWidgetsVisible(false);
+
+        progressTimer = new QTimer(this);
+        progressTimer->setInterval(100);
+        connect(progressTimer, &QTimer::timeout, this, &MainWindow::updateProgress);
+        queueTimer = new QTimer(this);
+        queueTimer->setInterval(250);
+        connect(queueTimer, &QTimer::timeout, this, &MainWindow::refreshQueue);
+        queuePool.setMaxThreadCount(QThread::idealThreadCount());
+        connect(cancelBtn, &QPushButton::clicked, this, [this] {
+            if (!task) return;
+            task->cancelled = true;
+            cancelBtn->setEnabled(false);
+            taskLabel->setText("正在取消…");
+        });
 
         dragExportBtn->installEventFilter(this);
-        preview->installEventFilter(this);
+        preview->viewport()->installEventFilter(this);
+    }
+
+    ~MainWindow() override {
+        // 取消仍在运行的任务，等工作线程退出后再析构
+        if (task) task->cancelled = true;
+        if (searchTask) searchTask->cancelled = true;
+        if (countTask) countTask->cancelled = true;
+        for (const auto &entry : queue) entry->progress->cancelled = true;
+        queuePool.clear();
+        queuePool.waitForDone();
+        QThreadPool::globalInstance()->waitForDone();
     }
 
 
 protected:
     // 接收拖拽
     void dragEnterEvent(QDragEnterEvent *event) override {
+        if (task) return;
         if (event->mimeData()->hasUrls()) {
             const auto urls = event->mimeData()->urls();
-            if (!urls.isEmpty() && urls.first().isLocalFile()) {
+            if (std::any_of(urls.cbegin(), urls.cend(), [](const QUrl &u) { return u.isLocalFile(); })) {
                 event->acceptProposedAction();
             }
         }
@@ -364,18 +709,19 @@ protected:
 
     void dropEvent(QDropEvent *event) override {
         if (event->mimeData()->hasUrls()) {
-            const auto urls = event->mimeData()->urls();
-            if (!urls.isEmpty()) {
-                QString local = urls.first().toLocalFile();
-                if (!local.isEmpty()) loadFile(local);
+            QStringList paths;
+            for (const QUrl &url : event->mimeData()->urls()) {
+                const QString local = url.toLocalFile();
+                if (!local.isEmpty()) paths << local;
             }
+            openPaths(paths);
             event->acceptProposedAction();
         }
     }
 
     // 预览区与拖拽控件的拖出导出
     bool eventFilter(QObject *watched, QEvent *event) override {
-        if (watched == preview || watched == dragExportBtn) {
+        if (watched == preview->viewport() || watched == dragExportBtn) {
             if (event->type() == QEvent::MouseButtonPress) {
                 QMouseEvent *me = static_cast<QMouseEvent*>(event);
                 lastMousePos = me->pos();
@@ -383,7 +729,7 @@ protected:
                 QMouseEvent *me = static_cast<QMouseEvent*>(event);
                 if ((me->buttons() & Qt::LeftButton) &&
                     (me->pos() - lastMousePos).manhattanLength() > QApplication::startDragDistance()) {
-                    if (anonymizedText.isEmpty()) return false;
+                    if (task || !redacted) return false;
                     startDragExport();
                     return true;
                 }
@@ -394,199 +740,789 @@ protected:
 
 private slots:
     void onOpenFile() {
-        QString path = QFileDialog::getOpenFileName(this, "选择日志/压缩包文件", QString(),
-                                                    "All files (*)");
-        if (!path.isEmpty()) loadFile(path);
+        const QStringList paths = QFileDialog::getOpenFileNames(this, "选择日志/压缩包文件", QString(),
+                                                                "All files (*)");
+        openPaths(paths);
     }
 
     void onAnonymize() {
-        if (currentDisplayName.isEmpty() || fileContent.isEmpty()) {
+        if (currentDisplayName.isEmpty() || fileBytes.isEmpty()) {
             QMessageBox::warning(this, "无可处理内容", "请先导入可识别的文本文件或压缩包。");
             return;
         }
-        performAnonymize();
-        preview->setPlainText(anonymizedText);
-        saveBtn->setEnabled(true);
-        dragExportBtn->setEnabled(true);
+        struct Anonymized {
+            std::shared_ptr<RedactedLog> result;
+            QString hits;
+            qint64 ns = 0;
+            bool cached = false;
+        };
+        const QByteArray content = fileBytes;
+        const std::shared_ptr<QFile> mapping = fileMapping;
+        const TextEncoding enc = fileEncoding.working();
+        // 同一文件在相同规则下的脱敏结果从缓存取出（大文件模式下 content 只是预览，不使用缓存）
+        const ResultCachePtr cache = streamingMode ? nullptr : activeResultCache();
+        const quint64 hash = fileHash;
+        runInBackground("正在脱敏", content.size(), [content, mapping, enc, cache, hash](TaskProgress &progress) {
+            Q_UNUSED(mapping);   // 持有映射，保证 content 在处理期间有效
+            Anonymized r;
+            QElapsedTimer timer;
+            timer.start();
+            const RuleSetPtr rules = activeRuleSet();
+            const QString key = cache && hash ? ResultCache::key(hash, *rules, CachedResult::Spans) : QString();
+            r.result = std::make_shared<RedactedLog>();
+            if (!key.isEmpty() && cache->lookupRedacted(key, content.size(), *r.result)) {
+                progress.addHits(r.result->hitCounts());
+                r.cached = true;
+            } else if (redactBytes(content, enc, *r.result, &progress, QThread::idealThreadCount())) {
+                if (!key.isEmpty()) cache->insertRedacted(key, *r.result);
+            } else {
+                r.result.reset();
+            }
+            r.ns = timer.nsecsElapsed();
+            r.hits = ruleHitSummary(*rules, progress);
+            return r;
+        }, [this, content](const Anonymized &r, bool cancelled) {
+            if (cancelled || !r.result) return;
+            metrics.set(r.cached ? "cache" : "redact", r.ns, content.size(), r.result->outputSize(content.size()));
+            updateMetricsLabel();
+            redacted = r.result;
+            preview->setRedactions(redacted);
+            resetSearch();
+            statusBar()->showMessage((r.cached ? "命中（缓存的结果）：" : "命中：") + r.hits);
+        });
+    }
+
+    // 加载规则文件，替换当前规则集；已有的脱敏结果按旧规则生成，需要重新脱敏
+    void onLoadRules() {
+        const QString path = QFileDialog::getOpenFileName(this, "选择规则文件", QString(), "Rule files (*.txt);;All files (*)");
+        if (path.isEmpty()) return;
+        QString error;
+        RuleSetPtr rules = RuleSet::load(path, &error);
+        if (!rules) {
+            QMessageBox::critical(this, "规则文件有误", path + "\n" + error);
+            return;
+        }
+        setActiveRuleSet(rules);
+        pasteHighlighter->reset();
+        updateRulesTip();
+        discardAnonymized();
+        statusBar()->showMessage(QString("已加载 %1 条规则：%2").arg(rules->ruleCount()).arg(QFileInfo(path).fileName()), 5000);
     }
 
     void onSaveAs() {
-        if (anonymizedText.isEmpty()) {
+        if (!redacted) {
             QMessageBox::warning(this, "没有脱敏内容", "请先点击“脱敏并预览”生成脱敏内容。");
             return;
         }
         QString suggested = generateAnonymizedFilePath(originalFilePath, currentDisplayName);
         QString path = QFileDialog::getSaveFileName(this, "导出脱敏文件", suggested,
-                                                    "Text files (*.txt);;All files (*)");
+                                                    "Text files (*.txt);;Gzip (*.gz);;All files (*)");
         if (path.isEmpty()) return;
-        if (!exportAnonymizedFile(path)) {
-            QMessageBox::critical(this, "保存失败", "无法写入文件：" + path);
+        auto finished = [this, path](bool ok, bool cancelled) {
+            if (cancelled) return;
+            if (!ok) {
+                QMessageBox::critical(this, "保存失败", "无法写入文件：" + path);
+                return;
+            }
+            QMessageBox::information(this, "保存成功", "已导出到：" + path);
+        };
+        // .gz 边脱敏边压缩；其余情况已有写好的导出文件时直接复制过去（能共享数据块时不复制数据）
+        const bool gzip = path.endsWith(".gz", Qt::CaseInsensitive);
+        if (gzip || !exportArtifact.isValid()) {
+            exportInBackground(path, finished, gzip);
             return;
         }
-        QMessageBox::information(this, "保存成功", "已导出到：" + path);
+        const QString source = exportArtifact.path;
+        QElapsedTimer timer;
+        timer.start();
+        runInBackground("正在导出", 0, [source, path](TaskProgress &) {
+            return copyToUserFile(source, path, nullptr);
+        }, [this, timer, path, finished](bool ok, bool cancelled) {
+            if (ok) {
+                const qint64 size = QFileInfo(path).size();
+                metrics.set("copy", timer.nsecsElapsed(), size, size);
+                updateMetricsLabel();
+            }
+            finished(ok, cancelled);
+        });
+    }
+
+    void onExportArchive() {
+        QFileInfo fi(originalFilePath);
+        QString suggested = fi.absoluteDir().absolutePath() + QDir::separator() + anonymizedArchiveName(fi.fileName());
+        QString path = QFileDialog::getSaveFileName(this, "导出脱敏压缩包", suggested, "All files (*)");
+        if (path.isEmpty()) return;
+        const QString source = originalFilePath;
+        runInBackground("正在导出压缩包", 0, [source, path](TaskProgress &progress) {
+            QString error;
+            if (!anonymizeArchive(source, path, QThread::idealThreadCount(), &error, &progress)) return error;
+            return QString();
+        }, [this, path](const QString &error, bool cancelled) {
+            if (cancelled) return;
+            if (!error.isEmpty()) {
+                QMessageBox::critical(this, "导出失败", error);
+                return;
+            }
+            QMessageBox::information(this, "导出成功", "已导出到：" + path);
+        });
+    }
+
+    // 把所选 logs 目录中的轮转日志脱敏后按时间合并为一个文件，边合并边写出
+    void onMergeRotation() {
+        const QString dir = QFileDialog::getExistingDirectory(this, "选择日志目录（logs）");
+        if (dir.isEmpty()) return;
+        const QList<RotationMember> members = findRotationSet(dir);
+        if (members.isEmpty()) {
+            QMessageBox::warning(this, "提示", "该目录中没有 latest.log 或 YYYY-MM-DD-N.log.gz 形式的日志");
+            return;
+        }
+        const QString suggested = QDir(dir).filePath(QString("merged-%1_%2-anonymized.log")
+            .arg(members.first().date.toString(Qt::ISODate), members.last().date.toString(Qt::ISODate)));
+        const QString path = QFileDialog::getSaveFileName(this, "保存合并后的日志", suggested, "All files (*)");
+        if (path.isEmpty()) return;
+        qint64 total = 0;
+        for (const RotationMember &m : members) total += m.size;
+        runInBackground(QString("正在合并 %1 个日志").arg(members.size()), total, [members, path](TaskProgress &progress) {
+            QString error;
+            if (!mergeRotationSet(members, path, QThread::idealThreadCount(), &error, &progress)) return error;
+            return QString();
+        }, [this, path](const QString &error, bool cancelled) {
+            if (cancelled) return;
+            if (!error.isEmpty()) {
+                QMessageBox::critical(this, "合并失败", error);
+                return;
+            }
+            QMessageBox::information(this, "合并成功", "已导出到：" + path);
+        });
+    }
+
+    // 定时把工作线程的进度同步到状态栏
+    void updateProgress() {
+        if (!task || task->isCancelled()) return;
+        const qint64 done = task->done.load(std::memory_order_relaxed);
+        const qint64 total = task->total.load(std::memory_order_relaxed);
+        if (total > 0) {
+            progressBar->setRange(0, 1000);
+            progressBar->setValue(int(qMin<qint64>(1000, done * 1000 / total)));
+            taskLabel->setText(QString("%1… %2%").arg(taskTitle).arg(done * 100 / total));
+        } else {
+            // 总量未知（压缩包）：显示忙碌动画和已处理的数据量
+            progressBar->setRange(0, 0);
+            taskLabel->setText(QString("%1… %2 MB").arg(taskTitle).arg(double(done) / (1 << 20), 0, 'f', 1));
+        }
+    }
+
+    // 把队列中已完成的文件放到所选目录；结果已在临时目录中写好，只需链接或复制过去
+    void onExportQueue() {
+        const QString dir = QFileDialog::getExistingDirectory(this, "选择批量导出的目录");
+        if (dir.isEmpty()) return;
+        QList<QPair<QString, QString>> copies;   // 临时结果 → 导出位置
+        QSet<QString> used;
+        for (const auto &entry : queue) {
+            if (entry->state != QueueEntry::State::Done) continue;
+            const QString name = QFileInfo(entry->target).fileName();
+            QString target = QDir::cleanPath(dir + "/" + entry->relativeDir + "/" + name);
+            // 不同目录中的同名文件（如多个 latest.log）依次编号，不互相覆盖
+            for (int n = 2; used.contains(target); ++n)
+                target = QDir::cleanPath(dir + "/" + entry->relativeDir + "/" + numberedTargetName(name, n));
+            used.insert(target);
+            copies.append({ entry->target, target });
+        }
+        if (copies.isEmpty()) return;
+        runInBackground("正在批量导出", copies.size(), [copies](TaskProgress &progress) {
+            QStringList errors;
+            for (const auto &copy : copies) {
+                if (progress.isCancelled()) break;
+                QString error;
+                if (!QDir().mkpath(QFileInfo(copy.second).absolutePath()))
+                    errors << copy.second + "：无法创建目录";
+                else if (!copyToUserFile(copy.first, copy.second, &error))
+                    errors << copy.second + "：" + error;
+                progress.advance(1);
+            }
+            return errors;
+        }, [this, dir, count = copies.size()](const QStringList &errors, bool cancelled) {
+            if (cancelled) return;
+            if (!errors.isEmpty()) {
+                QMessageBox::critical(this, "导出失败", QString("%1 个文件导出失败：\n").arg(errors.size()) + errors.join("\n"));
+                return;
+            }
+            QMessageBox::information(this, "导出成功", QString("已导出 %1 个文件到：").arg(count) + dir);
+        });
+    }
+
+    void clearQueue() {
+        for (const auto &entry : queue) {
+            entry->progress->cancelled = true;
+            entry->progress.reset();
+            if (!entry->target.isEmpty()) QFile::remove(entry->target);
+        }
+        queuePool.clear();
+        queue.clear();
+        queueList->clear();
+        queueTimer->stop();
+        updateActions();
+    }
+
+    // 定时刷新正在处理的文件的进度
+    void refreshQueue() {
+        bool running = false;
+        for (const auto &entry : queue) {
+            if (entry->state != QueueEntry::State::Running) continue;
+            updateQueueRow(*entry);
+            running = true;
+        }
+        if (!running) queueTimer->stop();
     }
 
 private:
     QLabel *fileLabel{nullptr};
-    QTextEdit *preview{nullptr};
+    LogView *preview{nullptr};
+    QCheckBox *highlightBox{nullptr};
+    QCheckBox *pseudonymBox{nullptr};
     QPushButton *dragExportBtn{nullptr};
     QLabel *exportNoteLabel{nullptr};
     QPushButton *saveBtn{nullptr};
+    QPushButton *archiveBtn{nullptr};
+    QPushButton *mergeBtn{nullptr};
     QPushButton *anonymizeBtn{nullptr};
+    QPushButton *openBtn{nullptr};
+    QPushButton *rulesBtn{nullptr};
+    QLabel *metricsLabel{nullptr};
+    QLabel *taskLabel{nullptr};
+    QProgressBar *progressBar{nullptr};
+    QPushButton *cancelBtn{nullptr};
+    QTimer *progressTimer{nullptr};
+    QTreeWidget *queueList{nullptr};
+    QPushButton *exportQueueBtn{nullptr};
+    QPushButton *clearQueueBtn{nullptr};
+    QTimer *queueTimer{nullptr};
+    QLineEdit *searchEdit{nullptr};
+    QCheckBox *caseBox{nullptr};
+    QPushButton *prevBtn{nullptr};
+    QPushButton *nextBtn{nullptr};
+    QLabel *searchLabel{nullptr};
+    QLineEdit *gotoEdit{nullptr};
+    QWidget *searchBar{nullptr};
+    QPushButton *pasteBtn{nullptr};
+    QPlainTextEdit *pasteEdit{nullptr};
+    RedactionHighlighter *pasteHighlighter{nullptr};
+    QWidget *pasteBar{nullptr};
+    QLabel *pasteHitsLabel{nullptr};
+    QPushButton *copyPasteBtn{nullptr};
+    QPushButton *savePasteBtn{nullptr};
+    QTimer *pasteHitsTimer{nullptr};
 
     QString originalFilePath;
     QString currentDisplayName;
-    QString fileContent;
-    QString anonymizedText;
+    // 日志字节与原文件编码；UTF-16 的日志在内部按 UTF-8 保存（见 TextEncoding::working）
+    QByteArray fileBytes;
+    std::shared_ptr<QFile> fileMapping;   // fileBytes 直接指向文件映射时持有映射
+    TextEncoding fileEncoding;
+    quint64 fileHash = 0;   // 源文件原样的内容哈希，用作结果缓存的键；未启用缓存或大文件模式时为 0
+    // 脱敏结果只记录命中区间与替换内容，导出时与 fileBytes 合成写出
+    std::shared_ptr<const RedactedLog> redacted;
+    // 大文件模式：fileBytes 只是开头的预览，导出时从源文件流式处理
+    bool streamingMode{false};
     QPoint lastMousePos;
+    // 当前后台任务，空表示空闲；任务运行期间不接受新的操作
+    std::shared_ptr<TaskProgress> task;
+    QString taskTitle;
+    // 已写好的脱敏文件（拖拽导出的临时文件或“导出文件”的目标），之后的导出都复用它
+    ExportArtifact exportArtifact;
+    // 一致化替换的编号表，在本次运行中打开的所有文件间共用
+    PseudonymTablePtr sessionPseudonyms;
+    // 当前文件各阶段的统计，打开新文件时清空
+    RunMetrics metrics;
+    // 文件队列：各文件在 queuePool 中并行处理（空闲线程依次取下一个文件），结果写到 queueDir，批量导出时再放到目标目录
+    std::vector<std::shared_ptr<QueueEntry>> queue;
+    QThreadPool queuePool;
+    QTemporaryDir queueDir;
+    int queueSerial = 0;   // 每次处理在 queueDir 中使用单独的子目录，同名文件互不覆盖
+    // 预览中的查找：条件或预览内容变化时作废；查找下一个与统计总数各自在后台进行，新的操作取消同类的旧操作
+    std::shared_ptr<const LogSearch> logSearch;
+    SearchHit searchHit;
+    qint64 searchCount = -1;   // -1 表示尚未统计完
+    std::shared_ptr<TaskProgress> searchTask;
+    std::shared_ptr<TaskProgress> countTask;
 
-    void loadFile(const QString &path) {
-        originalFilePath = path;
-        QFileInfo fi(path);
-        anonymizedText.clear();
-        saveBtn->setEnabled(false);
-        dragExportBtn->setEnabled(false);
-        anonymizeBtn->setEnabled(false);
-        fileContent.clear();
-        currentDisplayName.clear();
+    // 在全局线程池中执行 work(TaskProgress&)，完成后回到界面线程调用 done(结果, 是否已取消)
+    template <typename Work, typename Done>
+    void runInBackground(const QString &title, qint64 total, Work work, Done done) {
+        auto progress = std::make_shared<TaskProgress>();
+        progress->total = total;
+        task = progress;
+        taskTitle = title;
+        progressBar->setRange(0, 0);
+        taskLabel->setText(title + "…");
+        cancelBtn->setEnabled(true);
+        setTaskWidgetsVisible(true);
+        updateActions();
+        progressTimer->start();
+
+        QThreadPool::globalInstance()->start([this, progress, work, done] {
+            auto result = work(*progress);
+            QMetaObject::invokeMethod(this, [this, progress, result, done] {
+                task.reset();
+                progressTimer->stop();
+                setTaskWidgetsVisible(false);
+                done(result, progress->isCancelled());
+                updateActions();
+            }, Qt::QueuedConnection);
+        });
+    }
 
-        // 后缀判断（低优先级，真实处理看内容）
-        const QString lower = fi.fileName().toLower();
+    // 在全局线程池中执行查找，不占用 task（查找时仍可进行其他操作）；slot 中之前的查找被取消。
+    // 完成后回到界面线程调用 done(结果)，被取消或已被新查找替换的结果直接丢弃
+    template <typename Work, typename Done>
+    void runSearchTask(std::shared_ptr<TaskProgress> &slot, Work work, Done done) {
+        if (slot) slot->cancelled = true;
+        auto progress = std::make_shared<TaskProgress>();
+        slot = progress;
+        std::shared_ptr<TaskProgress> *slotPtr = &slot;
+        QThreadPool::globalInstance()->start([this, progress, slotPtr, work, done] {
+            auto result = work(*progress);
+            QMetaObject::invokeMethod(this, [this, progress, slotPtr, result, done] {
+                if (*slotPtr != progress) return;
+                slotPtr->reset();
+                done(result);
+                updateSearchLabel();
+            }, Qt::QueuedConnection);
+        });
+    }
 
-        // 压缩包读取
-        if (lower.endsWith(".tar.gz")) {
-            QString pickedName;
-            QByteArray bytes = readTarGzEntryText(path, &pickedName);
-            if (bytes.isEmpty()) {
-                preview->setPlainText("无法解压或未找到可读取的日志文件（.log/.txt）。请确认已安装 7z / tar。");
-                updateFileLabel(fi, "(tar.gz 读取失败)");
-                return;
-            }
-            QString decoded = decodeBestEffort(bytes);
-            if (decoded.isEmpty()) {
-                preview->setPlainText("从压缩包中读取到的文件不是可识别的文本或编码识别失败。");
-                updateFileLabel(fi, "(tar.gz 非文本)");
-                return;
-            }
-            fileContent = decoded;
-            currentDisplayName = pickedName.isEmpty() ? fi.completeBaseName() + ".txt" : pickedName;
-            preview->setPlainText(fileContent);
-            anonymizeBtn->setEnabled(true);
-            updateFileLabel(fi, "(已从 tar.gz 读取)");
+    // 查找条件或预览的内容变了，之前的查找结果作废
+    void resetSearch() {
+        if (searchTask) searchTask->cancelled = true;
+        if (countTask) countTask->cancelled = true;
+        searchTask.reset();
+        countTask.reset();
+        logSearch.reset();
+        searchHit = {};
+        searchCount = -1;
+        preview->showMatch({}, 0);
+        updateSearchLabel();
+    }
+
+    // 按当前条件建立查找，同时在后台统计命中总数；没有可查找的内容时返回 false
+    bool prepareSearch() {
+        if (logSearch) return true;
+        const QString text = searchEdit->text();
+        const QByteArray &bytes = preview->logBytes();
+        if (text.isEmpty() || bytes.isEmpty()) return false;
+        QStringEncoder encoder = preview->textEncoding().encoder();
+        const QByteArray needle = encoder.encode(text);
+        logSearch = std::make_shared<const LogSearch>(bytes, preview->lineIndex(), preview->shownRedactions(),
+                                                      TextFinder(needle, !caseBox->isChecked()));
+        const auto search = logSearch;
+        const std::shared_ptr<QFile> mapping = preview->logMapping();
+        runSearchTask(countTask, [search, mapping](TaskProgress &progress) {
+            Q_UNUSED(mapping);   // 持有映射，保证查找期间数据有效
+            return search->count(&progress);
+        }, [this](qint64 count) { searchCount = count; });
+        return true;
+    }
+
+    // 从当前命中（没有时从预览的第一可见行）开始查找下一个或上一个命中
+    void findInPreview(bool forward) {
+        if (!prepareSearch()) return;
+        const SearchHit from = searchHit.isValid() ? searchHit : SearchHit{ preview->topLine(), -1 };
+        const auto search = logSearch;
+        const std::shared_ptr<QFile> mapping = preview->logMapping();
+        runSearchTask(searchTask, [search, mapping, from, forward](TaskProgress &progress) {
+            Q_UNUSED(mapping);
+            return forward ? search->next(from, &progress) : search->previous(from, &progress);
+        }, [this, search](const SearchHit &hit) {
+            searchHit = hit;
+            preview->showMatch(hit, search->matchSize());
+        });
+        updateSearchLabel();
+    }
+
+    void updateSearchLabel() {
+        QStringList parts;
+        if (searchTask) parts << "正在查找…";
+        else if (searchHit.isValid()) parts << QString("第 %1 行").arg(searchHit.line + 1);
+        else if (logSearch && searchCount == 0) parts << "没有找到";
+        if (countTask) parts << "正在统计…";
+        else if (searchCount > 0) parts << QString("共 %1 处").arg(searchCount);
+        searchLabel->setText(parts.join("，"));
+    }
+
+    // 切换粘贴模式：文本框替换预览区，文件相关的操作暂不可用
+    void setPasteMode(bool on) {
+        pasteEdit->setVisible(on);
+        pasteBar->setVisible(on);
+        preview->setVisible(!on);
+        searchBar->setVisible(!on);
+        if (on) {
+            pasteEdit->setFocus();
+            updatePasteHits();
+        }
+        updateActions();
+    }
+
+    void updatePasteHits() {
+        TaskProgress stats;
+        stats.addHits(pasteHighlighter->hitCounts());
+        pasteHitsLabel->setText("命中：" + ruleHitSummary(pasteHighlighter->ruleSet(), stats));
+    }
+
+    void onSavePasted() {
+        const QString path = QFileDialog::getSaveFileName(this, "保存脱敏内容", "pasted_Anonymized.txt",
+                                                          "Text files (*.txt);;Gzip (*.gz);;All files (*)");
+        if (path.isEmpty()) return;
+        const QByteArray text = pasteHighlighter->anonymizedText();
+        const bool gzip = path.endsWith(".gz", Qt::CaseInsensitive);
+        if (!writeFileAtomically(path, gzip, [&](QIODevice &out) { return out.write(text) == text.size(); })) {
+            QMessageBox::critical(this, "保存失败", "无法写入文件：" + path);
             return;
         }
-        else if (lower.endsWith(".gz")) {
-            QByteArray bytes = readGzViaTools(path);
-            if (bytes.isEmpty()) {
-                preview->setPlainText("无法解压 .gz，请确认已安装 7z / gzip。");
-                updateFileLabel(fi, "(gz 读取失败)");
-                return;
-            }
-            QString decoded = decodeBestEffort(bytes);
-            if (decoded.isEmpty()) {
-                preview->setPlainText(".gz 内容不是可识别的文本或编码识别失败。");
-                updateFileLabel(fi, "(gz 非文本)");
-                return;
-            }
-            fileContent = decoded;
-            QString base = fi.fileName();
-            if (base.endsWith(".gz", Qt::CaseInsensitive)) base.chop(3);
-            currentDisplayName = base.isEmpty() ? fi.completeBaseName() + ".txt" : base;
-            preview->setPlainText(fileContent);
-            anonymizeBtn->setEnabled(true);
-            updateFileLabel(fi, "(已从 gz 读取)");
+        statusBar()->showMessage("已保存到：" + path, 5000);
+    }
+
+    void onGotoLine() {
+        const qsizetype line = gotoEdit->text().toLongLong() - 1;
+        if (line < 0 || line >= preview->lineCount()) {
+            statusBar()->showMessage(QString("行号超出范围：共 %1 行").arg(preview->lineCount()), 5000);
             return;
         }
-        else if (lower.endsWith(".zip")) {
-            QString pickedName;
-            QByteArray bytes = readZipEntryText(path, &pickedName);
-            if (bytes.isEmpty()) {
-                preview->setPlainText("无法解压或未找到可读取的日志文件（.log/.txt）。请确认已安装 7z / unzip。");
-                updateFileLabel(fi, "(zip 读取失败)");
-                return;
-            }
-            QString decoded = decodeBestEffort(bytes);
-            if (decoded.isEmpty()) {
-                preview->setPlainText("从 zip 中读取到的文件不是可识别的文本或编码识别失败。");
-                updateFileLabel(fi, "(zip 非文本)");
-                return;
+        preview->scrollToLine(line);
+        preview->setFocus();
+    }
+
+    // 规则或替换方式变了，已有的脱敏结果作废，需要重新脱敏；队列中的文件全部按新设置重新处理
+    void discardAnonymized() {
+        redacted.reset();
+        exportArtifact = {};
+        preview->setRedactions(nullptr);
+        resetSearch();
+        for (const auto &entry : queue) {
+            entry->progress->cancelled = true;
+            if (!entry->target.isEmpty()) QFile::remove(entry->target);
+        }
+        submitQueueEntries(queue);
+        updateActions();
+    }
+
+    // 单个文件直接打开预览；多个文件或文件夹加入队列
+    void openPaths(const QStringList &paths) {
+        if (paths.size() == 1 && QFileInfo(paths.first()).isFile())
+            loadFile(paths.first());
+        else if (!paths.isEmpty())
+            enqueuePaths(paths);
+    }
+
+    void enqueuePaths(const QStringList &paths) {
+        QSet<QString> queued;
+        for (const auto &entry : queue) queued.insert(entry->input);
+        std::vector<std::shared_ptr<QueueEntry>> added;
+        for (const QString &path : paths) {
+            // 文件夹中的文件导出时放在同名文件夹下
+            const QFileInfo fi(path);
+            const QString prefix = fi.isDir() ? fi.fileName() : QString();
+            QStringList relativeDirs;
+            const QStringList files = expandBatchInputs({ path }, &relativeDirs);
+            for (qsizetype i = 0; i < files.size(); ++i) {
+                if (queued.contains(files[i])) continue;
+                queued.insert(files[i]);
+                auto entry = std::make_shared<QueueEntry>();
+                entry->input = files[i];
+                entry->relativeDir = QDir::cleanPath(prefix + "/" + relativeDirs[i]);
+                if (entry->relativeDir == "/" || entry->relativeDir == ".") entry->relativeDir.clear();
+                const QString shown = entry->relativeDir.isEmpty() ? QFileInfo(files[i]).fileName()
+                                                                   : entry->relativeDir + "/" + QFileInfo(files[i]).fileName();
+                entry->row = new QTreeWidgetItem(queueList, { shown, QLocale().formattedDataSize(QFileInfo(files[i]).size()), QString() });
+                entry->row->setToolTip(0, files[i]);
+                queue.push_back(entry);
+                added.push_back(entry);
             }
-            fileContent = decoded;
-            currentDisplayName = pickedName.isEmpty() ? fi.completeBaseName() + ".txt" : pickedName;
-            preview->setPlainText(fileContent);
-            anonymizeBtn->setEnabled(true);
-            updateFileLabel(fi, "(已从 zip 读取)");
+        }
+        if (added.empty()) {
+            statusBar()->showMessage("没有可加入队列的日志文件", 5000);
             return;
         }
+        submitQueueEntries(added);
+        updateActions();
+    }
 
-        QString text = readTextFileAuto(path);
-        if (text.isEmpty()) {
-            preview->setPlainText("非文本文件或无法识别编码，或不是受支持的压缩包。");
-            updateFileLabel(fi, "(非文本/不支持)");
-            return;
+    // 把文件交给 queuePool；文件少于线程数时，把剩余的核心分给单个文件内部（压缩包条目、分段扫描）
+    void submitQueueEntries(const std::vector<std::shared_ptr<QueueEntry>> &entries) {
+        qsizetype pending = 0;
+        for (const auto &entry : queue)
+            if (entry->state == QueueEntry::State::Waiting || entry->state == QueueEntry::State::Running) ++pending;
+        for (const auto &entry : entries)
+            if (entry->state != QueueEntry::State::Waiting && entry->state != QueueEntry::State::Running) ++pending;
+        const int innerJobs = qMax(1, QThread::idealThreadCount() / int(qBound<qsizetype>(1, pending, queuePool.maxThreadCount())));
+        for (const auto &entry : entries) submitQueueEntry(entry, innerJobs);
+    }
+
+    void submitQueueEntry(const std::shared_ptr<QueueEntry> &entry, int innerJobs) {
+        auto progress = std::make_shared<TaskProgress>();
+        progress->total = progressTotalHint(entry->input);
+        auto runMetrics = std::make_shared<RunMetrics>();
+        entry->progress = progress;
+        entry->metrics = runMetrics;
+        entry->state = QueueEntry::State::Waiting;
+        entry->target.clear();
+        entry->error.clear();
+        updateQueueRow(*entry);
+
+        BatchJob job;
+        job.input = entry->input;
+        job.outputDir = queueDir.filePath(QString::number(++queueSerial));
+        job.innerJobs = innerJobs;
+        job.memoryLimit = kQueueMemoryLimit;
+        queuePool.start([this, entry, progress, runMetrics, job] {
+            if (progress->isCancelled()) return;
+            QMetaObject::invokeMethod(this, [this, entry, progress] {
+                if (entry->progress != progress) return;
+                entry->state = QueueEntry::State::Running;
+                updateQueueRow(*entry);
+                if (!queueTimer->isActive()) queueTimer->start();
+            }, Qt::QueuedConnection);
+            QString target;
+            const QString error = runBatchJob(job, *progress, *runMetrics, &target);
+            QMetaObject::invokeMethod(this, [this, entry, progress, target, error] {
+                // 已重新排队或被移出队列，这次的结果作废
+                if (entry->progress != progress) {
+                    if (!target.isEmpty()) QFile::remove(target);
+                    return;
+                }
+                entry->target = target;
+                entry->error = error;
+                entry->state = error.isEmpty() ? QueueEntry::State::Done : QueueEntry::State::Failed;
+                updateQueueRow(*entry);
+                onQueueEntryFinished();
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    void onQueueEntryFinished() {
+        updateActions();
+        qsizetype done = 0, failed = 0;
+        for (const auto &entry : queue) {
+            if (entry->state == QueueEntry::State::Done) ++done;
+            else if (entry->state == QueueEntry::State::Failed) ++failed;
+            else return;   // 还有文件没处理完
         }
-        fileContent = text;
-        currentDisplayName = fi.fileName();
-        preview->setPlainText(fileContent);
-        anonymizeBtn->setEnabled(true);
-        updateFileLabel(fi, "");
+        statusBar()->showMessage(QString("队列处理完成：成功 %1 个，失败 %2 个").arg(done).arg(failed));
     }
 
-    void updateFileLabel(const QFileInfo &fi, const QString &suffix) {
-        QString s = fi.fileName() + "    (" + fi.absoluteFilePath() + ")";
-        if (!suffix.isEmpty()) s += "  " + suffix;
-        fileLabel->setText(s);
+    void updateQueueRow(const QueueEntry &entry) {
+        QString status;
+        switch (entry.state) {
+        case QueueEntry::State::Waiting:
+            status = "等待中";
+            break;
+        case QueueEntry::State::Running: {
+            const qint64 done = entry.progress->done.load(std::memory_order_relaxed);
+            const qint64 total = entry.progress->total.load(std::memory_order_relaxed);
+            status = total > 0 ? QString("处理中 %1%").arg(qMin<qint64>(100, done * 100 / total))
+                               : QString("处理中 %1 MB").arg(double(done) / (1 << 20), 0, 'f', 1);
+            break;
+        }
+        case QueueEntry::State::Done:
+            status = "完成";
+            entry.row->setToolTip(2, entry.metrics->summary() + "\n命中：" + ruleHitSummary(*activeRuleSet(), *entry.progress));
+            break;
+        case QueueEntry::State::Failed:
+            status = "失败：" + entry.error;
+            entry.row->setToolTip(2, entry.error);
+            break;
+        }
+        entry.row->setText(2, status);
     }
 
-    void performAnonymize() {
-        const QString octet = "(?:25[0-5]|2[0-4]\\d|1?\\d?\\d)";
-        const QString ipPattern = QString("%1\\.%1\\.%1\\.%1").arg(octet);
-        const QString ipPortPattern = QString("\\b%1:\\d{1,5}\\b").arg(ipPattern);
-        const QString ipOnlyPattern = QString("\\b%1\\b").arg(ipPattern);
+    void updateMetricsLabel() {
+        metricsLabel->setText(metrics.summary());
+    }
 
-        QRegularExpression reIpPort(ipPortPattern);
-        QRegularExpression reIp(ipOnlyPattern);
+    void updateRulesTip() {
+        const RuleSetPtr rules = activeRuleSet();
+        QStringList names;
+        for (int i = 0; i < rules->ruleCount(); ++i) names << rules->rule(i).name;
+        rulesBtn->setToolTip("加载规则文件（IPv6、UUID、主机名、玩家名单等）\n当前规则：" + names.join("、"));
+    }
 
-        QString out = fileContent;
-        out.replace(reIpPort, "");
-        out.replace(reIp, "");
-        anonymizedText = out;
+    void setTaskWidgetsVisible(bool visible) {
+        taskLabel->setVisible(visible);
+        progressBar->setVisible(visible);
+        cancelBtn->setVisible(visible);
     }
 
-    QString generateAnonymizedFilePath(const QString &originPath, const QString &displayName) {
-        QFileInfo fin(originPath);
-        QFileInfo fdn(displayName);
+    // 按当前状态刷新各按钮是否可用
+    void updateActions() {
+        const bool idle = !task;
+        const bool anonymized = bool(redacted);
+        const bool pasting = pasteBtn->isChecked();
+        openBtn->setEnabled(idle);
+        rulesBtn->setEnabled(idle);
+        pasteBtn->setEnabled(idle);
+        anonymizeBtn->setEnabled(idle && !pasting && !fileBytes.isEmpty());
+        highlightBox->setEnabled(idle && !pasting && anonymized);
+        pseudonymBox->setEnabled(idle);
+        saveBtn->setEnabled(idle && !pasting && anonymized);
+        dragExportBtn->setEnabled(idle && !pasting && anonymized);
+        archiveBtn->setEnabled(idle && !pasting && archiveKindOf(originalFilePath) != ArchiveKind::None);
+        mergeBtn->setEnabled(idle && !pasting);
+
+        const bool queued = !queue.empty();
+        const bool queueDone = std::any_of(queue.cbegin(), queue.cend(), [](const std::shared_ptr<QueueEntry> &e) {
+            return e->state == QueueEntry::State::Done;
+        });
+        queueList->setVisible(queued);
+        clearQueueBtn->setVisible(queued);
+        exportQueueBtn->setVisible(queued);
+        clearQueueBtn->setEnabled(idle);
+        exportQueueBtn->setEnabled(idle && queueDone);
+    }
 
-        QString base = fdn.completeBaseName();
-        QString suffix = fdn.suffix();
-        if (suffix.isEmpty()) suffix = "txt";
+    void loadFile(const QString &path) {
+        if (task) return;
+        pasteBtn->setChecked(false);
+        originalFilePath = path;
+        QFileInfo fi(path);
+        redacted.reset();
+        fileBytes.clear();
+        fileMapping.reset();
+        fileHash = 0;
+        currentDisplayName.clear();
+        exportArtifact = {};
+        streamingMode = false;
+        metrics.clear();
+        updateMetricsLabel();
+        preview->setPlainText(QString());
+        resetSearch();
+        updateFileLabel(fi, QString());
 
-        QString outName = base + "_Anonymized." + suffix;
-        QString dir = fin.absoluteDir().absolutePath();
-        return dir + QDir::separator() + outName;
+        const bool streaming = shouldStream(fi);
+        runInBackground("正在读取", progressTotalHint(path), [path, streaming](TaskProgress &progress) {
+            QElapsedTimer timer;
+            timer.start();
+            LoadedLog log = streaming ? loadLogHead(path) : loadLogFile(path, &progress);
+            log.loadNs = timer.nsecsElapsed();
+            // 整体载入的文件此时大多已在系统缓存中，顺便算出哈希；大文件模式等到导出时再算
+            if (!streaming && !log.bytes.isEmpty() && activeResultCache()) hashFile(path, &log.sourceHash);
+            return log;
+        }, [this, path, streaming](const LoadedLog &log, bool cancelled) {
+            QFileInfo fi(path);
+            if (cancelled) {
+                updateFileLabel(fi, "(已取消读取)");
+                return;
+            }
+            if (log.bytes.isEmpty()) {
+                preview->setPlainText(log.error);
+                updateFileLabel(fi, log.note);
+                return;
+            }
+            metrics.set("load", log.loadNs - log.detectNs, fi.size(), log.bytes.size());
+            metrics.set("detect", log.detectNs, log.bytes.size());
+            updateMetricsLabel();
+            fileBytes = log.bytes;
+            fileMapping = log.mapping;
+            fileEncoding = log.encoding;
+            fileHash = log.sourceHash;
+            currentDisplayName = log.displayName;
+            streamingMode = streaming;
+            preview->setLogBytes(fileBytes, fileEncoding.working(), fileMapping);
+            resetSearch();
+            const QString timing = QString("[%1，编码识别 %2 ms / 读取共 %3 ms]")
+                                       .arg(log.encodingName)
+                                       .arg(double(log.detectNs) / 1e6, 0, 'f', 2)
+                                       .arg(double(log.loadNs) / 1e6, 0, 'f', 0);
+            updateFileLabel(fi, log.note.isEmpty() ? timing : log.note + "  " + timing);
+        });
     }
 
-    bool exportAnonymizedFile(const QString &targetPath) {
-        QFile f(targetPath);
-        if (!f.open(QIODevice::WriteOnly)) return false;
-        f.write(anonymizedText.toUtf8());
-        f.close();
-        return true;
+    void updateFileLabel(const QFileInfo &fi, const QString &suffix) {
+        QString s = fi.fileName() + "    (" + fi.absoluteFilePath() + ")";
+        if (!suffix.isEmpty()) s += "  " + suffix;
+        fileLabel->setText(s);
     }
 
+    QString generateAnonymizedFilePath(const QString &originPath, const QString &displayName) {
+        QFileInfo fin(originPath);
+        QString dir = fin.absoluteDir().absolutePath();
+        return dir + QDir::separator() + anonymizedFileName(displayName);
+    }
+
+    // 在后台导出脱敏文件；大文件模式从源文件流式处理，完成后调用 done(是否成功, 是否已取消)。
+    // 启用结果缓存时先按源文件的哈希查找之前导出过的文件（大文件模式的哈希在此时计算）。
+    // 未压缩的导出文件记为 exportArtifact 供之后复用
+    template <typename Done>
+    void exportInBackground(const QString &targetPath, Done done, bool gzip = false) {
+        const QString source = originalFilePath;
+        const QByteArray bytes = fileBytes;
+        const std::shared_ptr<QFile> mapping = fileMapping;
+        const std::shared_ptr<const RedactedLog> result = redacted;
+        const TextEncoding enc = fileEncoding;
+        const bool streaming = streamingMode;
+        const ResultCachePtr cache = activeResultCache();
+        const quint64 loadedHash = fileHash;
+        auto fromCache = std::make_shared<std::atomic<bool>>(false);
+        QElapsedTimer timer;
+        timer.start();
+        runInBackground("正在导出", streaming ? progressTotalHint(source) : bytes.size(), [=](TaskProgress &progress) {
+            Q_UNUSED(mapping);   // 持有映射，保证 bytes 在导出期间有效
+            QString key;
+            quint64 hash = loadedHash;
+            if (cache && (hash || (streaming && hashFile(source, &hash)))) {
+                key = ResultCache::key(hash, *activeRuleSet(), gzip ? CachedResult::GzipOutput : CachedResult::Output);
+                const QString cached = cache->lookup(key);
+                if (!cached.isEmpty() && copyToUserFile(cached, targetPath, nullptr)) {
+                    fromCache->store(true);
+                    return true;
+                }
+            }
+            const bool ok = streaming ? anonymizeFileStreaming(source, targetPath, &progress, gzip)
+                                      : writeRedactedFile(targetPath, bytes, *result, enc, &progress, gzip);
+            if (ok && !key.isEmpty()) cache->insert(key, targetPath, streaming ? progress.hitCounts() : result->hitCounts());
+            return ok;
+        }, [=](bool ok, bool cancelled) {
+            if (ok && !cancelled) {
+                const qint64 in = streaming ? QFileInfo(source).size() : result->outputSize(bytes.size());
+                const QString stage = fromCache->load() ? "cache" : streaming ? "stream" : "write";
+                metrics.set(stage, timer.nsecsElapsed(), in, QFileInfo(targetPath).size());
+                updateMetricsLabel();
+                if (!gzip) exportArtifact = ExportArtifact::capture(targetPath);
+            }
+            done(ok, cancelled);
+        });
+    }
 
     void startDragExport() {
-        QString suggested = generateAnonymizedFilePath(originalFilePath, currentDisplayName);
-        QFileInfo si(suggested);
-        QString tempTarget = QDir::tempPath() + QDir::separator() + si.fileName();
+        // 之前的拖拽或“导出文件”已经写好的文件直接拖出，不再重新写出
+        if (exportArtifact.isValid()) {
+            execDrag(exportArtifact.path);
+            return;
+        }
+        const QString tempTarget = QDir::tempPath() + QDir::separator() + anonymizedFileName(currentDisplayName);
 
-        QFile tf(tempTarget);
-        if (!tf.open(QIODevice::WriteOnly)) return;
-        tf.write(anonymizedText.toUtf8());
-        tf.close();
+        // 小文件当场写出；大文件（含映射的超大日志）与流式模式一样在后台准备
+        if (!streamingMode && fileBytes.size() <= kStreamPreviewSize) {
+            if (!writeRedactedFile(tempTarget, fileBytes, *redacted, fileEncoding)) return;
+            exportArtifact = ExportArtifact::capture(tempTarget);
+            execDrag(tempTarget);
+            return;
+        }
+        // 大文件先在后台生成；若完成时仍按着鼠标就直接开始拖拽，否则提示再拖一次
+        exportInBackground(tempTarget, [this, tempTarget](bool ok, bool cancelled) {
+            if (cancelled) return;
+            if (!ok) {
+                QMessageBox::critical(this, "导出失败", "无法写入文件：" + tempTarget);
+                return;
+            }
+            if (QGuiApplication::mouseButtons() & Qt::LeftButton)
+                execDrag(tempTarget);
+            else
+                statusBar()->showMessage("导出文件已准备好，再次拖动即可导出", 5000);
+        });
+    }
 
+    void execDrag(const QString &filePath) {
         QMimeData *mime = new QMimeData;
-        mime->setUrls({ QUrl::fromLocalFile(tempTarget) });
+        mime->setUrls({ QUrl::fromLocalFile(filePath) });
 
         QDrag *drag = new QDrag(dragExportBtn);
         drag->setMimeData(mime);
@@ -597,7 +1533,22 @@ private:
 // ---------------------------- 主入口 ----------------------------
 
 int main(int argc, char *argv[]) {
+    // 批处理与基准测试参数交给命令行部分处理（与 mcla-cli 相同），不创建窗口
+    if (isCommandLineInvocation(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return runCommandLine(app.arguments());
+    }
+
     QApplication a(argc, argv);
+    if (QFileInfo::exists(defaultRulesPath())) {
+        QString error;
+        if (RuleSetPtr rules = RuleSet::load(defaultRulesPath(), &error))
+            setActiveRuleSet(rules);
+        else
+            QMessageBox::warning(nullptr, "规则文件有误", defaultRulesPath() + "\n" + error + "\n将只删除 IP 地址及端口。");
+    }
+    // 反复打开的同一日志直接取出上次的脱敏结果
+    setActiveResultCache(std::make_shared<ResultCache>(ResultCache::defaultDirectory()));
     MainWindow w;
     w.show();
     return a.exec();
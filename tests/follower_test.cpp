@@ -0,0 +1,74 @@
+// ---------------------------- 跟踪模式轮转测试 ----------------------------
+// 在一次轮询的间隔内向 latest.log 追加关服的几行、把它改名轮转并重建，检查追加的内容与新文件的内容
+// 都已脱敏并按顺序输出，且只报告了一次轮转。任一项不符时返回非 0
+
+#include "core/follower.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <cstdio>
+
+using namespace mcla;
+
+static int failures = 0;
+
+static void check(bool condition, const char *what) {
+    if (!condition) {
+        std::printf("  FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+static bool appendTo(const QString &path, const QByteArray &data) {
+    QFile f(path);
+    return f.open(QIODevice::WriteOnly | QIODevice::Append) && f.write(data) == data.size();
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::printf("无法创建临时目录\n");
+        return 2;
+    }
+    std::printf("follow across rotation\n");
+    const QString latest = dir.filePath("latest.log");
+    check(appendTo(latest, "[12:00:00] [Server thread/INFO]: Steve[/203.0.113.7:51234] logged in with entity id 42\n"),
+          "write latest.log");
+
+    QByteArray out;
+    LogFollower follower(latest, [&out](QByteArrayView piece) {
+        out.append(piece.data(), piece.size());
+        return true;
+    });
+    int rotations = 0;
+    QObject::connect(&follower, &LogFollower::rotated, [&rotations] { ++rotations; });
+    QString error;
+    check(follower.start(true, &error), qPrintable("start: " + error));
+    check(out.contains("logged in with entity id 42") && !out.contains("203.0.113.7"), "existing content anonymized");
+
+    // 两次轮询之间：追加关服的几行，改名轮转，重建 latest.log 并写入
+    check(appendTo(latest, "[12:30:00] [Server thread/INFO]: Alex[/198.51.100.23:40000] lost connection: Disconnected\n"
+                           "[12:30:01] [Server thread/INFO]: Stopping server\n"),
+          "append before rotation");
+    check(QFile::rename(latest, dir.filePath("2026-10-17-1.log")), "rename latest.log");
+    check(appendTo(latest, "[12:31:00] [Server thread/INFO]: Starting minecraft server version 1.21\n"), "recreate latest.log");
+    follower.poll();
+
+    check(out.contains("lost connection: Disconnected") && !out.contains("198.51.100.23"),
+          "lines appended before the rotation are anonymized and kept");
+    const qsizetype stopping = out.indexOf("Stopping server");
+    const qsizetype starting = out.indexOf("Starting minecraft server");
+    check(stopping >= 0 && starting > stopping, "old file drained before the new file");
+    check(rotations == 1, "one rotation reported");
+
+    check(appendTo(latest, "[12:31:05] [Server thread/INFO]: Done (3.2s)!\n"), "append to the new file");
+    follower.poll();
+    check(out.endsWith("Done (3.2s)!\n"), "new file followed after the rotation");
+    follower.stop();
+
+    std::printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}